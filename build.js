@@ -1,9 +1,15 @@
 const fs = require('fs');
 
-fs.readFile('./dist/output.js', 'utf8', function(err, data) {
-  data = data.replace("var Module = typeof Module !== 'undefined' ? Module : {};", "export var Module = typeof Module !== 'undefined' ? Module : {};");
+// Serial builds, whose Module must be exported.
+const outputs = ['./dist/output.js', './dist/output-simd.js'];
 
-  fs.writeFile('./dist/output.js', data, 'utf8', function(err) {
+outputs.forEach(function(output) {
+  fs.readFile(output, 'utf8', function(err, data) {
     if (err) return console.log(err);
+    data = data.replace("var Module = typeof Module !== 'undefined' ? Module : {};", "export var Module = typeof Module !== 'undefined' ? Module : {};");
+
+    fs.writeFile(output, data, 'utf8', function(err) {
+      if (err) return console.log(err);
+    });
   });
 });
\ No newline at end of file
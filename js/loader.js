@@ -0,0 +1,68 @@
+// Loads the packing module, choosing between the threaded build
+// (dist/output-mt.js) and the serial one (dist/output.js), and between
+// their SIMD variants (dist/output-mt-simd.js, dist/output-simd.js) and
+// the plain ones.
+//
+// The threaded build needs WebAssembly memory backed by a
+// SharedArrayBuffer. Browsers only allow it in cross-origin isolated
+// pages (served with the COOP/COEP headers) and their workers; Node.js
+// always allows it. Everywhere else the serial build is loaded, so the
+// same call sites work in every environment.
+
+export function threadsSupported() {
+  if (typeof SharedArrayBuffer === 'undefined') {
+    return false;
+  }
+  // crossOriginIsolated is not defined in Node.js.
+  return typeof crossOriginIsolated === 'undefined' || crossOriginIsolated === true;
+}
+
+// A module with a function that returns i8x16.popcnt(i8x16.splat(0)).
+// It only validates where WebAssembly SIMD128 is supported.
+const SIMD_TEST = new Uint8Array([
+  0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1,
+  8, 0, 65, 0, 253, 15, 253, 98, 11,
+]);
+
+export function simdSupported() {
+  try {
+    return WebAssembly.validate(SIMD_TEST);
+  } catch (e) {
+    return false;
+  }
+}
+
+// Resolves to the initialized module. Pass { threads: false } to force
+// the serial build, or { threads: n } to use at most n threads, and
+// { simd: false } to force the build without SIMD. { deterministic: true }
+// makes both builds give the same packing on any number of threads.
+export async function loadPackModule(options = {}) {
+  const simd = options.simd !== false && simdSupported();
+
+  if (options.threads !== false && threadsSupported()) {
+    const { default: createPackModule } = simd
+      ? await import('./output-mt-simd.js')
+      : await import('./output-mt.js');
+    const module = await createPackModule();
+    if (typeof options.threads === 'number') {
+      module.ccall('pack_threads', null, ['number'], [options.threads]);
+    }
+    if (options.deterministic) {
+      module.ccall('pack_deterministic', null, ['number'], [1]);
+    }
+    return module;
+  }
+
+  const { Module } = simd
+    ? await import('./output-simd.js')
+    : await import('./output.js');
+  if (!Module.calledRun) {
+    await new Promise(function(resolve) {
+      Module.onRuntimeInitialized = resolve;
+    });
+  }
+  if (options.deterministic) {
+    Module.ccall('pack_deterministic', null, ['number'], [1]);
+  }
+  return Module;
+}
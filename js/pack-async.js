@@ -0,0 +1,220 @@
+// Runs pack() in a pool of module workers so that the page stays
+// responsive while the pallets are solved.
+//
+// Each job resolves to { count, positions }, positions being a
+// Float32Array of count triples { x, y, rotated } (rotated is 1 or 0),
+// or to the count alone for countAsync().
+// Jobs wait in a queue until one of the at most `concurrency` workers is
+// idle; workers are only started when there is work for them. A job can
+// be cancelled with an AbortSignal: a queued job is dropped and the
+// worker of a running one is terminated, releasing all its memory, and
+// replaced on demand.
+
+function defaultConcurrency() {
+  const cores = typeof navigator !== 'undefined' && navigator.hardwareConcurrency;
+  return Math.max(1, Math.min(4, (cores || 2) - 1));
+}
+
+// Options:
+//   concurrency - maximum number of workers (and of jobs solved at once).
+//   threads     - passed to loadPackModule() in every worker. Defaults to
+//                 1, since the workers already run in parallel.
+//   workerUrl   - location of pack-worker.js.
+export function createPacker(options = {}) {
+  const concurrency = options.concurrency || defaultConcurrency();
+  const threads = options.threads === undefined ? 1 : options.threads;
+  const workerUrl = options.workerUrl || new URL('./pack-worker.js', import.meta.url);
+
+  const workers = [];
+  const idle = [];
+  const queue = [];
+  let nextId = 0;
+
+  function spawn() {
+    const worker = new Worker(workerUrl, { type: 'module' });
+    worker.job = null;
+    worker.postMessage({ type: 'init', options: { threads } });
+
+    worker.onmessage = function(event) {
+      const { count, positions, error } = event.data;
+      const job = worker.job;
+      worker.job = null;
+      idle.push(worker);
+      if (error) {
+        job.reject(new Error(error));
+      } else if (job.countOnly) {
+        job.resolve(count);
+      } else {
+        job.resolve({ count, positions: new Float32Array(positions) });
+      }
+      dispatch();
+    };
+
+    // The worker is lost (it failed to load, or crashed): fail its job
+    // and let the next jobs start a new one.
+    worker.onerror = function(event) {
+      event.preventDefault();
+      const job = worker.job;
+      discard(worker);
+      if (job) {
+        job.reject(new Error(event.message || 'Pack worker failed'));
+      }
+      dispatch();
+    };
+
+    workers.push(worker);
+    return worker;
+  }
+
+  function discard(worker) {
+    worker.terminate();
+    workers.splice(workers.indexOf(worker), 1);
+    const i = idle.indexOf(worker);
+    if (i >= 0) {
+      idle.splice(i, 1);
+    }
+  }
+
+  function cancel(job, reason) {
+    const i = queue.indexOf(job);
+    if (i >= 0) {
+      queue.splice(i, 1);
+    } else {
+      const worker = workers.find(function(worker) {
+        return worker.job === job;
+      });
+      if (!worker) {
+        return; // Already answered.
+      }
+      discard(worker);
+    }
+    job.reject(reason);
+    dispatch();
+  }
+
+  function dispatch() {
+    while (queue.length > 0) {
+      let worker = idle.pop();
+      if (!worker) {
+        if (workers.length >= concurrency) {
+          return;
+        }
+        worker = spawn();
+      }
+      const job = queue.shift();
+      worker.job = job;
+      worker.postMessage({ id: job.id, L: job.L, W: job.W, l: job.l, w: job.w,
+                           countOnly: job.countOnly });
+    }
+  }
+
+  function submit(L, W, l, w, countOnly, signal) {
+    return new Promise(function(resolve, reject) {
+      const job = { id: nextId++, L, W, l, w, countOnly, resolve, reject };
+      if (signal) {
+        const abort = function() {
+          cancel(job, signal.reason || new Error('Packing aborted'));
+        };
+        if (signal.aborted) {
+          reject(signal.reason || new Error('Packing aborted'));
+          return;
+        }
+        signal.addEventListener('abort', abort, { once: true });
+        job.resolve = function(value) {
+          signal.removeEventListener('abort', abort);
+          resolve(value);
+        };
+        job.reject = function(error) {
+          signal.removeEventListener('abort', abort);
+          reject(error);
+        };
+      }
+      queue.push(job);
+      dispatch();
+    });
+  }
+
+  return {
+    // Resolves to { count, positions } for (l, w)-boxes on the (L, W)
+    // pallet. options.signal, an AbortSignal, cancels the job.
+    packAsync(L, W, l, w, options = {}) {
+      return submit(L, W, l, w, false, options.signal);
+    },
+
+    // Resolves to the number of boxes only, without placing them.
+    countAsync(L, W, l, w, options = {}) {
+      return submit(L, W, l, w, true, options.signal);
+    },
+
+    // Packs every [L, W, l, w] of instances. Resolves to the results of
+    // packAsync() in the same order or, with options.countOnly, to an
+    // Int32Array of the counts.
+    packBatch(instances, options = {}) {
+      const jobs = instances.map(function(p) {
+        return submit(p[0], p[1], p[2], p[3], !!options.countOnly, options.signal);
+      });
+      return Promise.all(jobs).then(function(results) {
+        return options.countOnly ? Int32Array.from(results) : results;
+      });
+    },
+
+    // Number of jobs not started yet.
+    get pending() {
+      return queue.length;
+    },
+
+    // Stops every worker; the jobs not finished are rejected.
+    terminate() {
+      const error = new Error('Packer terminated');
+      for (const worker of workers) {
+        worker.terminate();
+        if (worker.job) {
+          worker.job.reject(error);
+        }
+      }
+      for (const job of queue) {
+        job.reject(error);
+      }
+      workers.length = 0;
+      idle.length = 0;
+      queue.length = 0;
+    },
+  };
+}
+
+let sharedPacker = null;
+
+function shared() {
+  if (sharedPacker === null) {
+    sharedPacker = createPacker();
+  }
+  return sharedPacker;
+}
+
+// packAsync(), countAsync() and packBatch() on a packer with the default
+// options, created on first use.
+export function packAsync(L, W, l, w, options) {
+  return shared().packAsync(L, W, l, w, options);
+}
+
+export function countAsync(L, W, l, w, options) {
+  return shared().countAsync(L, W, l, w, options);
+}
+
+export function packBatch(instances, options) {
+  return shared().packBatch(instances, options);
+}
+
+// The boxes of a result as the objects answered by pack():
+// [{ x, y, rotated }, ...].
+export function toBoxes(result) {
+  const boxes = new Array(result.count);
+  for (let i = 0; i < result.count; i++) {
+    boxes[i] = {
+      x: result.positions[3 * i],
+      y: result.positions[3 * i + 1],
+      rotated: result.positions[3 * i + 2] !== 0,
+    };
+  }
+  return boxes;
+}
@@ -0,0 +1,158 @@
+// Same functions as pack-async.js, backed by the native addon built by
+// `make addon` instead of the WebAssembly module, for Node.js servers.
+// Switching is a matter of the import path:
+//
+//   import { packAsync, toBoxes } from './pack-native.js';
+//
+// The packings run on the threads of the libuv pool, so at most
+// UV_THREADPOOL_SIZE (4 by default) of them run at once, besides the
+// other users of the pool (file system, DNS, ...). A packer queues its
+// jobs so that it never takes more than `concurrency` of those threads.
+
+import { createRequire } from 'module';
+import os from 'os';
+
+const require = createRequire(import.meta.url);
+const native = require('./packnative.node');
+
+export { toBoxes } from './pack-async.js';
+
+function defaultConcurrency() {
+  const poolSize = Number(process.env.UV_THREADPOOL_SIZE) || 4;
+  const cores = os.availableParallelism ? os.availableParallelism() : os.cpus().length;
+  return Math.max(1, Math.min(poolSize, cores));
+}
+
+// Options:
+//   concurrency - maximum number of jobs solved at once.
+//   threads     - threads of the solver shared by those jobs, every
+//                 processor when not positive (the default). It can
+//                 only be given while no packing of any packer runs.
+export function createPacker(options = {}) {
+  const concurrency = options.concurrency || defaultConcurrency();
+  if (options.threads !== undefined) {
+    native.threads(options.threads);
+  }
+
+  const queue = [];
+  const running = new Set();
+
+  function start(job) {
+    const handle = native.solve(job.L, job.W, job.l, job.w, job.countOnly);
+    job.cancel = handle.cancel;
+    running.add(job);
+    handle.promise.then(function(result) {
+      job.resolve(job.countOnly ? result.count : result);
+    }, function(error) {
+      job.reject(job.reason || error);
+    }).finally(function() {
+      running.delete(job);
+      dispatch();
+    });
+  }
+
+  function dispatch() {
+    while (queue.length > 0 && running.size < concurrency) {
+      start(queue.shift());
+    }
+  }
+
+  // A queued job is dropped; a running one stops as soon as the solver
+  // notices it and its promise is rejected with the reason.
+  function cancel(job, reason) {
+    const i = queue.indexOf(job);
+    if (i >= 0) {
+      queue.splice(i, 1);
+      job.reject(reason);
+    } else if (running.has(job)) {
+      job.reason = reason;
+      job.cancel();
+    }
+  }
+
+  function submit(L, W, l, w, countOnly, signal) {
+    return new Promise(function(resolve, reject) {
+      const job = { L, W, l, w, countOnly, resolve, reject };
+      if (signal) {
+        const abort = function() {
+          cancel(job, signal.reason || new Error('Packing aborted'));
+        };
+        if (signal.aborted) {
+          reject(signal.reason || new Error('Packing aborted'));
+          return;
+        }
+        signal.addEventListener('abort', abort, { once: true });
+        job.resolve = function(value) {
+          signal.removeEventListener('abort', abort);
+          resolve(value);
+        };
+        job.reject = function(error) {
+          signal.removeEventListener('abort', abort);
+          reject(error);
+        };
+      }
+      queue.push(job);
+      dispatch();
+    });
+  }
+
+  return {
+    packAsync(L, W, l, w, options = {}) {
+      return submit(L, W, l, w, false, options.signal);
+    },
+
+    countAsync(L, W, l, w, options = {}) {
+      return submit(L, W, l, w, true, options.signal);
+    },
+
+    packBatch(instances, options = {}) {
+      const jobs = instances.map(function(p) {
+        return submit(p[0], p[1], p[2], p[3], !!options.countOnly, options.signal);
+      });
+      return Promise.all(jobs).then(function(results) {
+        return options.countOnly ? Int32Array.from(results) : results;
+      });
+    },
+
+    get pending() {
+      return queue.length;
+    },
+
+    // Cancels every job; the jobs not finished are rejected.
+    terminate() {
+      const error = new Error('Packer terminated');
+      for (const job of queue.splice(0)) {
+        job.reject(error);
+      }
+      for (const job of running) {
+        cancel(job, error);
+      }
+    },
+  };
+}
+
+let sharedPacker = null;
+
+function shared() {
+  if (sharedPacker === null) {
+    sharedPacker = createPacker();
+  }
+  return sharedPacker;
+}
+
+export function packAsync(L, W, l, w, options) {
+  return shared().packAsync(L, W, l, w, options);
+}
+
+export function countAsync(L, W, l, w, options) {
+  return shared().countAsync(L, W, l, w, options);
+}
+
+export function packBatch(instances, options) {
+  return shared().packBatch(instances, options);
+}
+
+// Gives back the memory of the tables of the solver threads.
+export function trim() {
+  native.trim();
+}
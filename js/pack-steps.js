@@ -0,0 +1,45 @@
+// Runs pack() in slices on the calling thread, for hosts where workers
+// are not available. Between two slices the event loop runs, so the
+// page can repaint a progress bar or cancel the packing.
+
+// Number of cuts tried per slice. About a few milliseconds of work.
+const DEFAULT_BUDGET = 20000;
+
+function nextTask() {
+  return new Promise(function(resolve) {
+    setTimeout(resolve, 0);
+  });
+}
+
+// Resolves to the boxes of pack() (the parsed JSON). Options:
+//   budget     - number of cuts tried per slice.
+//   onProgress - called after each slice with the fraction done.
+//   signal     - an AbortSignal; aborting rejects with its reason.
+export async function packInSteps(module, L, W, l, w, options = {}) {
+  const budget = options.budget || DEFAULT_BUDGET;
+  const signal = options.signal;
+  const args = ['number', 'number', 'number', 'number'];
+
+  const handle = module.ccall('pack_start', 'number', args, [L, W, l, w]);
+  if (handle === 0) {
+    throw new Error('Invalid dimensions');
+  }
+
+  try {
+    while (!module.ccall('pack_step', 'number', ['number', 'number'], [handle, budget])) {
+      if (options.onProgress) {
+        options.onProgress(module.ccall('pack_progress', 'number', ['number'], [handle]));
+      }
+      await nextTask();
+      if (signal && signal.aborted) {
+        throw signal.reason || new Error('Packing aborted');
+      }
+    }
+    if (options.onProgress) {
+      options.onProgress(1);
+    }
+    return JSON.parse(module.ccall('pack_result', 'string', ['number'], [handle]));
+  } finally {
+    module.ccall('pack_free', null, ['number'], [handle]);
+  }
+}
@@ -0,0 +1,56 @@
+// Worker that runs pack() off the main thread. It is driven by
+// pack-async.js: the first message may carry the options of
+// loadPackModule(), every other one is a job { id, L, W, l, w, countOnly }.
+//
+// The boxes are answered as a Float32Array of n triples { x, y, rotated }
+// whose buffer is transferred, not copied, back to the caller.
+
+import { loadPackModule } from './loader.js';
+
+let modulePromise = null;
+
+self.onmessage = async function(event) {
+  const message = event.data;
+
+  if (message.type === 'init') {
+    modulePromise = loadPackModule(message.options);
+    return;
+  }
+  if (modulePromise === null) {
+    modulePromise = loadPackModule();
+  }
+
+  const { id, L, W, l, w, countOnly } = message;
+  try {
+    const module = await modulePromise;
+    if (countOnly) {
+      const count = module.ccall('pack_count', 'number',
+                                 ['number', 'number', 'number', 'number'],
+                                 [L, W, l, w]);
+      if (count < 0) {
+        self.postMessage({ id, error: 'Invalid dimensions' });
+      } else {
+        self.postMessage({ id, count, positions: null });
+      }
+      return;
+    }
+
+    const ptr = module.ccall('pack_buffer', 'number',
+                             ['number', 'number', 'number', 'number'],
+                             [L, W, l, w]);
+    if (ptr === 0) {
+      self.postMessage({ id, error: 'Invalid dimensions' });
+      return;
+    }
+
+    // pack_buffer() answers [n, x0, y0, rotated0, ...] in the heap of the
+    // module. slice() copies it into a fresh (never shared) ArrayBuffer,
+    // which can be transferred.
+    const start = ptr >> 2;
+    const count = module.HEAPF32[start];
+    const positions = module.HEAPF32.slice(start + 1, start + 1 + 3 * count);
+    self.postMessage({ id, count, positions: positions.buffer }, [positions.buffer]);
+  } catch (e) {
+    self.postMessage({ id, error: String(e) });
+  }
+};
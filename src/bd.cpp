@@ -40,56 +40,100 @@
  ******************************************************************/
 
 #include <algorithm>
+#include <atomic>
+#include <fcntl.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
 #include <sys/resource.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/times.h>
 
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
 #include "bd.h"
+#include "cancel.h"
+#include "pool.h"
 #include "sets.h"
+#include "tables.h"
 #include "util.h"
 
 #define INFINITY_ 2000000000
 
+/* Minimum number of cut combinations (|X'|^2 |Y'|^2) of the root
+ * rectangle for its search to be divided among several threads. */
+#define PARALLEL_MIN_CUTS 1e6
+
+/* Number of chains of cuts of the root rectangle in the deterministic
+ * search (see chainWorker()), which is also the largest number of
+ * threads that it keeps busy. */
+#define DETERMINISTIC_CHAINS 8
+
 #define lowerBound(L, W, l, w) std::max ((L / l) * (W / w), (L / w) * (W / l));
 
 int BD (int L, int W, int l, int w, int n);
 
 int barnesBound (int L, int W, int l, int w);
 
+void initialize (int L, int W, int l, int w);
+
 /* Maximum level of recursion (maximum tree search depth). */
-int N = INFINITY_;
+__thread int N = INFINITY_;
 
 /* Arrays of indices for indexing the matrices that store
  * information about problems (L,W), where (L,W) belongs to X' x Y'
  * and X' and Y' are the raster points sets associated to (L,l,w) and
  * (W,l,w), respectively. */
-extern int *indexX, *indexY;
+extern __thread int *indexX, *indexY;
 
 /* Lower and upper bounds of each subproblem. */
-extern int **lowerBound, **upperBound;
+extern __thread int **lowerBound, **upperBound;
 
-extern Set normalSetX;
+extern __thread Set normalSetX;
 
 /* Indicate in which level of the recursion (or in which depth of the
  * tree search) the solution was found. Initially, solutionDepth[L][W]
  * = N, for all (L,W) subproblem. If the optimal solution was found
  * for a subproblem (L,W), than solutionDepth[L][W] = -1. */
-int **solutionDepth;
+__thread int **solutionDepth;
+
+/* Number of columns of the tables indexed by indexY. */
+__thread int sizeY;
 
 /* Array that stores the normalized values of each integer between 0 and L.
  * normalize[x] = max {r in X' | r <= x} */
-extern int *normalize;
+extern __thread int *normalize;
 
 /* Store the points that determine the divisions of the rectangles. */
-extern CutPoint **cutPoints;
+extern __thread CutPoint **cutPoints;
 
 /* Indicate if the limit of the recursion was reached during the
  * resolution of a problem. */
-int **reachedLimit;
+__thread int **reachedLimit;
+
+/* Blocks of the seed of the last search of the thread, which pack the
+ * rectangles whose CutPoint has seed set, or NULL. */
+__thread const std::vector<Block> *seedBlocks = NULL;
+
+/* Number of cuts kept for each rectangle besides the one of cutPoints,
+ * among the cuts that pack as many boxes as it (see
+ * solveAlternatives_BD()), or 0 if no other cut is kept. */
+__thread int maxAlternatives = 0;
+
+/* The cuts kept for the rectangle (i,j): numAlternatives[i][j] cuts
+ * from alternatives[(i * sizeY + j) * maxAlternatives] on. */
+__thread CutPoint *alternatives;
+__thread int **numAlternatives;
 
 /******************************************************************
  ******************************************************************/
@@ -117,8 +161,78 @@ localUpperBound (int iX, int iY)
 void
 storeCutPoint (int L, int W, int x1, int x2, int y1, int y2)
 {
-  CutPoint c = { x1, x2, y1, y2, 0 };
+  CutPoint c = { x1, x2, y1, y2, 0, 0, 0 };
   cutPoints[indexX[L]][indexY[W]] = c;
+
+  /* The cuts kept pack fewer boxes than this one. */
+  if (maxAlternatives > 0)
+    {
+      numAlternatives[indexX[L]][indexY[W]] = 0;
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Keep the cut (x1, x2, y1, y2) of the rectangle (L,W), which packs as
+ * many boxes as the one stored by storeCutPoint(), unless it is that
+ * one, it was kept before or maxAlternatives cuts are already kept.
+ */
+void
+storeAlternative (int L, int W, int x1, int x2, int y1, int y2)
+{
+  int iX = indexX[L], iY = indexY[W];
+  const CutPoint &best = cutPoints[iX][iY];
+  CutPoint *kept = alternatives + ((size_t)iX * sizeY + iY) * maxAlternatives;
+  int n = numAlternatives[iX][iY];
+
+  if (!best.homogeneous && !best.lApproach && !best.seed && best.x1 == x1
+      && best.x2 == x2 && best.y1 == y1 && best.y2 == y2)
+    {
+      return;
+    }
+  for (int i = 0; i < n; i++)
+    {
+      if (kept[i].x1 == x1 && kept[i].x2 == x2 && kept[i].y1 == y1
+          && kept[i].y2 == y2)
+        {
+          return;
+        }
+    }
+  if (n < maxAlternatives)
+    {
+      CutPoint c = { x1, x2, y1, y2, 0, 0, 0 };
+      kept[n] = c;
+      numAlternatives[iX][iY] = n + 1;
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Mark the rectangle (L,W) as solved with optimality guarantee if its
+ * lower bound z_lb reached its upper bound z_ub. When other cuts are
+ * kept, the search of (L,W) goes on until maxAlternatives of them pack
+ * z_ub boxes as well.
+ *
+ * Return:
+ * - 1 if (L,W) was marked, 0 otherwise.
+ */
+inline int
+optimalFound (int L, int W, int z_lb, int z_ub)
+{
+  int iX = indexX[L], iY = indexY[W];
+
+  if (z_lb != z_ub
+      || (maxAlternatives > 0 && numAlternatives[iX][iY] < maxAlternatives))
+    {
+      return 0;
+    }
+  solutionDepth[iX][iY] = -1;
+  reachedLimit[iX][iY] = 0;
+  return 1;
 }
 
 /******************************************************************
@@ -144,6 +258,9 @@ storeCutPoint (int L, int W, int x1, int x2, int y1, int y2)
  *
  * x1, x2, y1, y2 - Points that determine the division of the pallet.
  *
+ * If other cuts are kept (see maxAlternatives), the division is also
+ * kept when it packs as many boxes as the best one found for (L,W).
+ *
  * Return:
  * - the number of (l,w)-boxes packed into (L,W) pallet, using the
  *   division determined by (x1,x2,y1,y2).
@@ -211,7 +328,7 @@ solve (int L, int W, int l, int w, int n, int numBlocks, int *L_, int *W_,
           S_ub += zi_ub[i];
         }
 
-      if (*z_lb < S_ub)
+      if (*z_lb < S_ub || (maxAlternatives > 0 && *z_lb == S_ub))
         {
           /* The current lower bound is less than the sum of the partitions
            * upper bounds. Then, there is a possibility of this division
@@ -268,8 +385,9 @@ solve (int L, int W, int l, int w, int n, int numBlocks, int *L_, int *W_,
 
               /* If z_lb >= S_ub, we have, at least, a solution as good as
                * the one that can be find with this partitioning. So this
-               * partitioning is discarded. */
-              if (*z_lb >= S_ub)
+               * partitioning is discarded, unless other cuts are kept and
+               * it can still pack as many boxes. */
+              if (*z_lb > S_ub || (*z_lb == S_ub && maxAlternatives == 0))
                 {
                   break;
                 }
@@ -280,15 +398,24 @@ solve (int L, int W, int l, int w, int n, int numBlocks, int *L_, int *W_,
                 {
                   *z_lb = S_lb;
                   storeCutPoint (L, W, x1, x2, y1, y2);
-                  if (*z_lb == z_ub)
+                  if (optimalFound (L, W, *z_lb, z_ub))
                     {
                       /* An optimal solution was found. */
-                      solutionDepth[indexX[L]][indexY[W]] = -1;
-                      reachedLimit[indexX[L]][indexY[W]] = 0;
                       return 1;
                     }
                 }
             }
+
+          /* Every partition was solved and they pack as many boxes as
+           * the best cut. */
+          if (maxAlternatives > 0 && i > numBlocks && S_lb == *z_lb)
+            {
+              storeAlternative (L, W, x1, x2, y1, y2);
+              if (optimalFound (L, W, *z_lb, z_ub))
+                {
+                  return 1;
+                }
+            }
         }
     } /* if n < N */
 
@@ -315,18 +442,403 @@ solve (int L, int W, int l, int w, int n, int numBlocks, int *L_, int *W_,
         {
           *z_lb = S_lb;
           storeCutPoint (L, W, x1, x2, y1, y2);
-          if (*z_lb == z_ub)
+          if (optimalFound (L, W, *z_lb, z_ub))
             {
               /* An optimal solution was found. */
-              solutionDepth[indexX[L]][indexY[W]] = -1;
-              reachedLimit[indexX[L]][indexY[W]] = 0;
               return 1;
             }
         }
+      else if (maxAlternatives > 0 && S_lb == *z_lb)
+        {
+          storeAlternative (L, W, x1, x2, y1, y2);
+          if (optimalFound (L, W, *z_lb, z_ub))
+            {
+              return 1;
+            }
+        }
+    }
+  return 0;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Return the lower bound of the partition (a,b), normalizing it as
+ * solve() does.
+ */
+inline int
+partitionBound (int a, int b)
+{
+  a = normalize[a];
+  b = normalize[b];
+  if (a < b)
+    {
+      std::swap (a, b);
+    }
+  return lowerBound[indexX[a]][indexY[b]];
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Return G[v] = partitionBound(a, v), computing it if G[v] is -1.
+ */
+inline int
+boundG (int *G, int a, int v)
+{
+  if (G[v] < 0)
+    {
+      G[v] = partitionBound (a, v);
+    }
+  return G[v];
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Try the first order non-guillotine cuts of the rectangle (L,W) as
+ * nonGuillotineCutsAt() does, when the maximum depth was reached.
+ *
+ * Then solve() only compares the sum of the lower bounds of the five
+ * partitions with z_lb, so the sums are computed here from bounds
+ * gathered once for (x1, x2) and solve() is called only for the cuts
+ * that improve z_lb (or reach it, when other cuts are kept), which
+ * leaves the same cuts stored. For a cut
+ * (x1, x2, y1, y2) the sum is
+ *
+ *   c(y1) + F(y2) + G(y2 - y1), with
+ *
+ *   c(y1) = lb(x1, W - y1) + lb(x2, y1),
+ *   F(y2) = lb(L - x1, W - y2) + lb(L - x2, y2),
+ *   G(v)  = lb(x2 - x1, v).
+ *
+ * In SIMD builds the sums of four consecutive y2 are computed and
+ * compared at once.
+ *
+ * Parameters and return are the same as in nonGuillotineCutsAt().
+ */
+int
+screenNonGuillotineCuts (int L, int W, int l, int w, int n, int *z_lb,
+                         int z_ub, Set rasterX, Set rasterY, int index_x1,
+                         int index_x2)
+{
+  int x1 = rasterX.points[index_x1];
+  int x2 = rasterX.points[index_x2];
+  int *Y = rasterY.points;
+  int index_y1, index_y2, end, endW;
+  int L_[6], W_[6];
+
+  /* The raster points y2 < W. */
+  for (endW = 1; endW < rasterY.size && Y[endW] < W; endW++)
+    ;
+  if (endW <= 2)
+    {
+      return 0;
+    }
+
+  int *F = poolArray<int> (TABLE_SCREEN_F, endW + 4);
+  int *G = poolArray<int> (TABLE_SCREEN_G, W + 1);
+
+  /* The cuts that pack as many boxes as z_lb are tried too when other
+   * cuts are kept. */
+  int ties = maxAlternatives > 0 ? 1 : 0;
+
+  for (index_y2 = 1; index_y2 < endW; index_y2++)
+    {
+      F[index_y2] = partitionBound (L - x1, W - Y[index_y2])
+                    + partitionBound (L - x2, Y[index_y2]);
+    }
+
+  /* G is computed on first use: only the differences of raster
+   * points are valid partitions. */
+  std::fill (G, G + W + 1, -1);
+
+  for (index_y1 = 1; index_y1 < endW; index_y1++)
+    {
+
+      if (cancelled ())
+        {
+          return 1;
+        }
+
+      int y1 = Y[index_y1];
+      int c = partitionBound (x1, W - y1) + partitionBound (x2, y1);
+
+      /* Symmetry. When x1 + x2 = L, we can restrict y1 and y2 to
+       * y1 + y2 <= W. */
+      end = endW;
+      if (x1 + x2 == L)
+        {
+          for (end = index_y1 + 1; end < endW && y1 + Y[end] <= W; end++)
+            ;
+        }
+
+      if (end > index_y1 + 1)
+        {
+          /* Each call of solve() at the maximum depth marks the
+           * rectangle, even if the cut does not improve z_lb. */
+          reachedLimit[indexX[L]][indexY[W]] = 1;
+        }
+
+      index_y2 = index_y1 + 1;
+      while (index_y2 < end)
+        {
+          int stop = end;
+
+#ifdef __wasm_simd128__
+          if (index_y2 + 4 <= end)
+            {
+              v128_t v = wasm_i32x4_sub (wasm_v128_load (&Y[index_y2]),
+                                         wasm_i32x4_splat (y1));
+              v128_t g = wasm_i32x4_make (
+                  boundG (G, x2 - x1, wasm_i32x4_extract_lane (v, 0)),
+                  boundG (G, x2 - x1, wasm_i32x4_extract_lane (v, 1)),
+                  boundG (G, x2 - x1, wasm_i32x4_extract_lane (v, 2)),
+                  boundG (G, x2 - x1, wasm_i32x4_extract_lane (v, 3)));
+              v128_t sum = wasm_i32x4_add (
+                  wasm_i32x4_add (wasm_i32x4_splat (c),
+                                  wasm_v128_load (&F[index_y2])),
+                  g);
+
+              if (!wasm_v128_any_true (
+                      wasm_i32x4_gt (sum, wasm_i32x4_splat (*z_lb - ties))))
+                {
+                  /* None of the four cuts improves z_lb. */
+                  index_y2 += 4;
+                  continue;
+                }
+              stop = index_y2 + 4;
+            }
+#endif
+
+          for (; index_y2 < stop; index_y2++)
+            {
+              int y2 = Y[index_y2];
+
+              if (c + F[index_y2] + boundG (G, x2 - x1, y2 - y1)
+                  <= *z_lb - ties)
+                {
+                  continue;
+                }
+
+              /* The five partitions. */
+              L_[1] = x1;
+              W_[1] = W - y1;
+
+              L_[2] = L - x1;
+              W_[2] = W - y2;
+
+              L_[3] = x2 - x1;
+              W_[3] = y2 - y1;
+
+              L_[4] = x2;
+              W_[4] = y1;
+
+              L_[5] = L - x2;
+              W_[5] = y2;
+
+              if (solve (L, W, l, w, n, 5, L_, W_, z_lb, z_ub, x1, x2, y1,
+                         y2))
+                {
+                  /* This problem was solved with optimality guarantee. */
+                  return 1;
+                }
+            }
+        }
+    }
+
+  return 0;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Try the first order non-guillotine cuts of the rectangle (L,W)
+ * whose first points are x1 = rasterX.points[index_x1] and
+ * x2 = rasterX.points[index_x2].
+ *
+ * Parameters:
+ * L, W, l, w, n - As in BD().
+ *
+ * z_lb     - Current lower bound for (L,W).
+ * z_ub     - Upper bound for (L,W).
+ *
+ * rasterX  - Raster points set X' for (L,W).
+ * rasterY  - Raster points set Y' for (L,W).
+ *
+ * index_x1 - Index of x1 in the raster points set X'.
+ * index_x2 - Index of x2 in the raster points set X'.
+ *
+ * Return:
+ * - 1 if (L,W) was solved with optimality guarantee or the search
+ *   was cancelled, 0 otherwise.
+ */
+int
+nonGuillotineCutsAt (int L, int W, int l, int w, int n, int *z_lb, int z_ub,
+                     Set rasterX, Set rasterY, int index_x1, int index_x2)
+{
+  /* Points that determine the pallet division. */
+  int x1, x2, y1, y2;
+
+  /* Indices of y1 and y2 in the raster points arrays. */
+  int index_y1, index_y2;
+
+  if (n >= N)
+    {
+      return screenNonGuillotineCuts (L, W, l, w, n, z_lb, z_ub, rasterX,
+                                      rasterY, index_x1, index_x2);
     }
+
+  /* Size of the generated partitions:
+   * (L_[i], W_[i]) is the size of the partition i, for i = 1, ..., 5. */
+  int L_[6], W_[6];
+
+  x1 = rasterX.points[index_x1];
+  x2 = rasterX.points[index_x2];
+
+  for (index_y1 = 1;
+       index_y1 < rasterY.size && rasterY.points[index_y1] < W; index_y1++)
+    {
+
+      if (cancelled ())
+        {
+          return 1;
+        }
+
+      y1 = rasterY.points[index_y1];
+
+      for (index_y2 = index_y1 + 1;
+           index_y2 < rasterY.size && rasterY.points[index_y2] < W;
+           index_y2++)
+        {
+
+          y2 = rasterY.points[index_y2];
+
+          /* Symmetry. When x1 + x2 = L, we can restrict y1 and y2
+           * to y1 + y2 <= W. */
+          if (x1 + x2 == L && y1 + y2 > W)
+            break;
+
+          /* The five partitions. */
+          L_[1] = x1;
+          W_[1] = W - y1;
+
+          L_[2] = L - x1;
+          W_[2] = W - y2;
+
+          L_[3] = x2 - x1;
+          W_[3] = y2 - y1;
+
+          L_[4] = x2;
+          W_[4] = y1;
+
+          L_[5] = L - x2;
+          W_[5] = y2;
+
+          if (solve (L, W, l, w, n, 5, L_, W_, z_lb, z_ub, x1, x2, y1, y2))
+            {
+              /* This problem was solved with optimality guarantee. */
+              return 1;
+            }
+        } /* for y2 */
+    }     /* for y1 */
+
+  return 0;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Try the first order non-guillotine cuts of the rectangle (L,W)
+ * whose first point is x1 = rasterX.points[index_x1].
+ *
+ * Parameters and return are the same as in nonGuillotineCutsAt().
+ */
+int
+nonGuillotineCuts (int L, int W, int l, int w, int n, int *z_lb, int z_ub,
+                   Set rasterX, Set rasterY, int index_x1)
+{
+  int x1 = rasterX.points[index_x1];
+
+  for (int index_x2 = index_x1 + 1;
+       index_x2 < rasterX.size && rasterX.points[index_x2] + x1 <= L;
+       index_x2++)
+    {
+      if (nonGuillotineCutsAt (L, W, l, w, n, z_lb, z_ub, rasterX, rasterY,
+                               index_x1, index_x2))
+        {
+          /* This problem was solved with optimality guarantee or the
+           * search was cancelled. */
+          return 1;
+        }
+    } /* for x2 */
+
   return 0;
 }
 
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Try the vertical guillotine cut of the rectangle (L,W) at
+ * x1 = rasterX.points[index_x1].
+ *
+ * Parameters and return are the same as in nonGuillotineCuts().
+ */
+int
+verticalCut (int L, int W, int l, int w, int n, int *z_lb, int z_ub,
+             Set rasterX, int index_x1)
+{
+  int x1, x2, y1, y2;
+  int L_[6], W_[6];
+
+  x1 = x2 = rasterX.points[index_x1];
+  y1 = y2 = 0;
+
+  /* Partitions 1 and 2 generated by the vertical cut. */
+  L_[1] = x1;
+  W_[1] = W - y1;
+
+  L_[2] = L - x1;
+  W_[2] = W - y2;
+
+  return solve (L, W, l, w, n, 2, L_, W_, z_lb, z_ub, x1, x2, y1, y2);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Try the horizontal guillotine cut of the rectangle (L,W) at
+ * y1 = rasterY.points[index_y1].
+ *
+ * Parameters and return are the same as in nonGuillotineCuts().
+ */
+int
+horizontalCut (int L, int W, int l, int w, int n, int *z_lb, int z_ub,
+               Set rasterY, int index_y1)
+{
+  int x1, x2, y1, y2;
+  int L_[6], W_[6];
+
+  y1 = y2 = rasterY.points[index_y1];
+  x1 = x2 = 0;
+
+  /* Partitions 2 and 5 generated by the horizontal cut. */
+  L_[1] = L - x1;
+  W_[1] = W - y2;
+
+  L_[2] = L - x2;
+  W_[2] = y2;
+
+  return solve (L, W, l, w, n, 2, L_, W_, z_lb, z_ub, x1, x2, y1, y2);
+}
+
 /******************************************************************
  ******************************************************************/
 
@@ -370,21 +882,12 @@ BD (int L, int W, int l, int w, int n)
     }
   else
     {
-      /* Points that determine the pallet division. */
-      int x1, x2, y1, y2;
-
-      /* Indices of x1, x2, y1 and y2 in the raster points arrays. */
-      int index_x1, index_x2, index_y1, index_y2;
-
-      /* Size of the generated partitions:
-       * (L_[i], W_[i]) is the size of the partition i, for i = 1, ..., 5. */
-      int L_[6], W_[6];
+      /* Indices of x1 and y1 in the raster points arrays. */
+      int index_x1, index_y1;
 
       /* Raster points sets X' and Y' for this problem. */
       Set rasterX, rasterY;
 
-      int solved;
-
       /* Construct the raster points sets. */
       constructRasterPoints (L, W, &rasterX, &rasterY, normalSetX);
 
@@ -432,66 +935,16 @@ BD (int L, int W, int l, int w, int n)
            index_x1 < rasterX.size && rasterX.points[index_x1] <= L / 2;
            index_x1++)
         {
-
-          x1 = rasterX.points[index_x1];
-
-          for (index_x2 = index_x1 + 1;
-               index_x2 < rasterX.size && rasterX.points[index_x2] + x1 <= L;
-               index_x2++)
+          if (nonGuillotineCuts (L, W, l, w, n, &z_lb, z_ub, rasterX,
+                                 rasterY, index_x1))
             {
-
-              x2 = rasterX.points[index_x2];
-
-              for (index_y1 = 1;
-                   index_y1 < rasterY.size && rasterY.points[index_y1] < W;
-                   index_y1++)
-                {
-
-                  y1 = rasterY.points[index_y1];
-
-                  for (index_y2 = index_y1 + 1;
-                       index_y2 < rasterY.size && rasterY.points[index_y2] < W;
-                       index_y2++)
-                    {
-
-                      y2 = rasterY.points[index_y2];
-
-                      /* Symmetry. When x1 + x2 = L, we can restrict y1 and y2
-                       * to y1 + y2 <= W. */
-                      if (x1 + x2 == L && y1 + y2 > W)
-                        break;
-
-                      /* The five partitions. */
-                      L_[1] = x1;
-                      W_[1] = W - y1;
-
-                      L_[2] = L - x1;
-                      W_[2] = W - y2;
-
-                      L_[3] = x2 - x1;
-                      W_[3] = y2 - y1;
-
-                      L_[4] = x2;
-                      W_[4] = y1;
-
-                      L_[5] = L - x2;
-                      W_[5] = y2;
-
-                      solved = solve (L, W, l, w, n, 5, L_, W_, &z_lb, z_ub,
-                                      x1, x2, y1, y2);
-
-                      if (solved)
-                        {
-                          /* This problem was solved with optimality guarantee.
-                           */
-                          free (rasterX.points);
-                          free (rasterY.points);
-                          return z_lb;
-                        }
-                    } /* for y2 */
-                }     /* for y1 */
-            }         /* for x2 */
-        }             /* for x1 */
+              /* This problem was solved with optimality guarantee or
+               * the search was cancelled. */
+              free (rasterX.points);
+              free (rasterY.points);
+              return z_lb;
+            }
+        }
 
       /*###########################*
        * Vertical guillotine cuts. *
@@ -514,22 +967,11 @@ BD (int L, int W, int l, int w, int n)
            index_x1 < rasterX.size && rasterX.points[index_x1] <= L / 2;
            index_x1++)
         {
-
-          x1 = x2 = rasterX.points[index_x1];
-          y1 = y2 = 0;
-
-          /* Partitions 1 and 2 generated by the vertical cut. */
-          L_[1] = x1;
-          W_[1] = W - y1;
-
-          L_[2] = L - x1;
-          W_[2] = W - y2;
-
-          solved
-              = solve (L, W, l, w, n, 2, L_, W_, &z_lb, z_ub, x1, x2, y1, y2);
-          if (solved)
+          if (cancelled ()
+              || verticalCut (L, W, l, w, n, &z_lb, z_ub, rasterX, index_x1))
             {
-              /* This problem was solved with optimality guarantee. */
+              /* This problem was solved with optimality guarantee or
+               * the search was cancelled. */
               free (rasterX.points);
               free (rasterY.points);
               return z_lb;
@@ -557,22 +999,12 @@ BD (int L, int W, int l, int w, int n)
            index_y1 < rasterY.size && rasterY.points[index_y1] <= W / 2;
            index_y1++)
         {
-
-          y1 = y2 = rasterY.points[index_y1];
-          x1 = x2 = 0;
-
-          /* Partitions 2 and 5 generated by the horizontal cut. */
-          L_[1] = L - x1;
-          W_[1] = W - y2;
-
-          L_[2] = L - x2;
-          W_[2] = y2;
-
-          solved
-              = solve (L, W, l, w, n, 2, L_, W_, &z_lb, z_ub, x1, x2, y1, y2);
-          if (solved)
+          if (cancelled ()
+              || horizontalCut (L, W, l, w, n, &z_lb, z_ub, rasterY,
+                                index_y1))
             {
-              /* This problem was solved with optimality guarantee. */
+              /* This problem was solved with optimality guarantee or
+               * the search was cancelled. */
               free (rasterX.points);
               free (rasterY.points);
               return z_lb;
@@ -585,227 +1017,1410 @@ BD (int L, int W, int l, int w, int n)
     }
 }
 
+/******************************************************************
+ ******************************************************************/
+
+/* Copy of the tables of a worker of the parallel search. */
+struct WorkerTables
+{
+  int **lowerBound;
+  int **solutionDepth;
+  int **reachedLimit;
+  CutPoint **cutPoints;
+};
+
+/* Search for the cuts of the root rectangle divided among the
+ * workers of the pool. The cuts are grouped in slots, in the same
+ * order as BD() tries them: the slot s < numX1 holds the first order
+ * non-guillotine cuts with index_x1 = s + 1, the next numX1 slots
+ * hold the vertical cuts and the last numY1 slots the horizontal
+ * ones. Each worker takes the next free slot until all of them were
+ * tried or the root problem is solved. In the deterministic mode the
+ * workers take chains of slots instead (see chainWorker()). */
+struct RootSearch
+{
+  int L, W, l, w, n;
+
+  /* Initial lower bound and upper bound of the root rectangle. */
+  int z_lb, z_ub;
+
+  Set rasterX, rasterY;
+  int numX1, numY1, numSlots;
+
+  /* Read-only state of the thread that started the search. */
+  int *indexX, *indexY, **upperBound, *normalize;
+  Set normalSetX;
+  int N, sizeY;
+  std::atomic<int> *cancelToken;
+
+  std::atomic<int> nextSlot;
+
+  /* Best lower bound found by any worker. */
+  std::atomic<int> best;
+
+  std::atomic<bool> solved;
+
+  /* Tables of the calling thread, which every worker copies before
+   * searching and no worker modifies. */
+  WorkerTables main;
+
+  /* Tables of each worker and best lower bound found by it (-1 if
+   * the worker did not improve the root lower bound). */
+  WorkerTables *tables;
+  int *found;
+
+  /* Deterministic mode: the best tables of each worker, the chain where
+   * it found them and the first chain that solved the root problem. */
+  WorkerTables *bestTables;
+  int *foundChain;
+  std::atomic<int> solvedChain;
+};
+
 /******************************************************************
  ******************************************************************/
 
 /**
- * Compute the Barnes's upper bound [3].
- *
- * [3] F. W. Barnes. Packing the maximum number of m x n tiles in a
- *     large p x q rectangle. Discrete Mathematics, volume 26,
- *     pages 93-100, 1979.
+ * Copy the contents of the table with normalSetX.size rows and sizeY
+ * columns to another one.
+ */
+template <typename T>
+void
+copyTable (T **table, T **copy)
+{
+  for (int i = 0; i < normalSetX.size; i++)
+    {
+      std::copy (table[i], table[i] + sizeY, copy[i]);
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Return a copy of the table with normalSetX.size rows and sizeY
+ * columns, taken from the pool of this thread.
  *
  * Parameters:
- * (L, W) Pallet dimensions.
- * (l, w) Dimensions of the boxes to be packed.
- *
- * Return:
- * - the computed Barnes's bound.
+ * id    - Identifier of the table in the pool.
+ * table - The table.
  */
-int
-barnesBound (int L, int W, int l, int w)
+template <typename T>
+T **
+copyTable (int id, T **table)
 {
-  int r, s, D;
-  int minWaste = (L * W) % (l * w);
+  T **copy = poolTable<T> (id, normalSetX.size, sizeY);
+  copyTable (table, copy);
+  return copy;
+}
 
-  /* (l,1)-boxes packing. */
-  r = L % l;
-  s = W % l;
-  int A = std::min (r * s, (l - r) * (l - s));
+/******************************************************************
+ ******************************************************************/
 
-  /* (1,w)-boxes packing. */
-  r = L % w;
-  s = W % w;
-  int B = std::min (r * s, (w - r) * (w - s));
+/**
+ * Share the read-only state of the problem of the root search with a
+ * worker other than the thread that started it.
+ */
+static void
+shareProblem (RootSearch *search)
+{
+  indexX = search->indexX;
+  indexY = search->indexY;
+  upperBound = search->upperBound;
+  normalize = search->normalize;
+  normalSetX = search->normalSetX;
+  N = search->N;
+  sizeY = search->sizeY;
+  setCancelToken (search->cancelToken);
+}
 
-  /* Best unitary tile packing. */
-  int maxAB = std::max (A, B);
+/******************************************************************
+ ******************************************************************/
 
-  if (minWaste >= maxAB % (l * w))
+/**
+ * Try the cuts of a slot of the root search with the tables of this
+ * thread.
+ *
+ * Parameters:
+ * search - The RootSearch.
+ * slot   - The slot.
+ * z_lb   - Lower bound of the root rectangle, updated.
+ *
+ * Return:
+ * - 1 if the root rectangle was solved with optimality guarantee or
+ *   the search was cancelled, 0 otherwise.
+ */
+static int
+searchSlot (RootSearch *search, int slot, int *z_lb)
+{
+  if (slot < search->numX1)
     {
-      /* Wasted area. */
-      D = (maxAB / (l * w)) * (l * w) + minWaste;
+      return nonGuillotineCuts (search->L, search->W, search->l, search->w,
+                                search->n, z_lb, search->z_ub,
+                                search->rasterX, search->rasterY, slot + 1);
     }
-  else
+  else if (slot < 2 * search->numX1)
     {
-      /* Wasted area. */
-      D = (maxAB / (l * w) + 1) * (l * w) + minWaste;
+      return verticalCut (search->L, search->W, search->l, search->w,
+                          search->n, z_lb, search->z_ub, search->rasterX,
+                          slot - search->numX1 + 1);
     }
-
-  return (L * W - D) / (l * w);
+  return horizontalCut (search->L, search->W, search->l, search->w,
+                        search->n, z_lb, search->z_ub, search->rasterY,
+                        slot - 2 * search->numX1 + 1);
 }
 
 /******************************************************************
  ******************************************************************/
 
+/**
+ * Task executed by each worker of the parallel search of the root
+ * rectangle.
+ *
+ * Parameters:
+ * id  - Identifier of the worker.
+ * arg - The RootSearch.
+ */
 void
-initialize (int L, int W, int l, int w)
+rootWorker (int id, void *arg)
 {
+  RootSearch *search = (RootSearch *)arg;
+  int z_lb = search->z_lb;
+  int slot;
+  const WorkerTables *main = &search->main;
+
+  /* Every worker searches on private copies of the tables modified by
+   * the search, so that the tables of the calling thread stay as they
+   * were while the others copy them. The calling thread takes its
+   * copies from the buffers of the deterministic search. */
+  if (id != 0)
+    {
+      /* Share the read-only state of the problem. */
+      shareProblem (search);
 
-  /* Normalization of L and W. */
-  int L_n, W_n;
+      lowerBound = copyTable (TABLE_LOWER_BOUND, main->lowerBound);
+      solutionDepth = copyTable (TABLE_SOLUTION_DEPTH, main->solutionDepth);
+      reachedLimit = copyTable (TABLE_REACHED_LIMIT, main->reachedLimit);
+      cutPoints = copyTable (TABLE_CUT_POINTS, main->cutPoints);
+    }
+  else
+    {
+      lowerBound = copyTable (TABLE_CHAIN_LOWER_BOUND, main->lowerBound);
+      solutionDepth
+          = copyTable (TABLE_CHAIN_SOLUTION_DEPTH, main->solutionDepth);
+      reachedLimit = copyTable (TABLE_CHAIN_REACHED_LIMIT, main->reachedLimit);
+      cutPoints = copyTable (TABLE_CHAIN_CUT_POINTS, main->cutPoints);
+    }
 
-  int i, j;
+  search->found[id] = -1;
 
-  Set rasterX, rasterY;
+  while (!search->solved.load () && !cancelled ()
+         && (slot = search->nextSlot.fetch_add (1)) < search->numSlots)
+    {
+      /* Discard the cuts that cannot improve the best solution found
+       * by the other workers. */
+      int before = std::max (z_lb, search->best.load ());
 
-  /* Construct the conic combination set of l and w. */
-  normalSetX = newSet (L + 2);
-  constructConicCombinations (L, l, w, &normalSetX);
+      z_lb = before;
+      int solved = searchSlot (search, slot, &z_lb);
 
-  /* Compute the values of L* and W*.
-   * normalize[i] = max {x in X | x <= i} */
-  normalize = new int[L + 1];
-  i = 0;
-  for (j = 0; j <= L; j++)
+      if (z_lb > before)
+        {
+          /* This worker stored a better cut for the root. */
+          search->found[id] = z_lb;
+          int best = search->best.load ();
+          while (best < z_lb
+                 && !search->best.compare_exchange_weak (best, z_lb))
+            ;
+        }
+
+      if (solved)
+        {
+          search->solved.store (true);
+        }
+    }
+
+  search->tables[id].lowerBound = lowerBound;
+  search->tables[id].solutionDepth = solutionDepth;
+  search->tables[id].reachedLimit = reachedLimit;
+  search->tables[id].cutPoints = cutPoints;
+
+  if (id != 0)
     {
-      for (; i < normalSetX.size && normalSetX.points[i] <= j; i++)
-        ;
-      normalize[j] = normalSetX.points[i - 1];
+      setCancelToken (NULL);
+    }
+  else
+    {
+      lowerBound = main->lowerBound;
+      solutionDepth = main->solutionDepth;
+      reachedLimit = main->reachedLimit;
+      cutPoints = main->cutPoints;
     }
+}
 
-  /* Normalize (L, W). */
-  L_n = normalize[L];
-  W_n = normalize[W];
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Task executed by each worker of the deterministic search of the root
+ * rectangle. The slots are dealt in DETERMINISTIC_CHAINS chains, the
+ * chain c holding the slots c, c + DETERMINISTIC_CHAINS, ... Each
+ * chain is searched from a copy of the tables of the calling thread
+ * taken before the search, and discards only the cuts that cannot
+ * improve the best solution of the same chain, so its solution and its
+ * tables depend only on the problem. The workers take the next free
+ * chain and keep the tables of their best one.
+ *
+ * Parameters:
+ * id  - Identifier of the worker.
+ * arg - The RootSearch.
+ */
+static void
+chainWorker (int id, void *arg)
+{
+  RootSearch *search = (RootSearch *)arg;
+  WorkerTables main = search->main;
+  WorkerTables chain, *best = &search->bestTables[id];
+  int c;
 
-  constructRasterPoints (L, W, &rasterX, &rasterY, normalSetX);
+  if (id != 0)
+    {
+      shareProblem (search);
+    }
 
-  free (normalSetX.points);
-  normalSetX = newSet (L_n + 2);
-  int k = 0;
-  i = 0;
-  j = 0;
-  while (i < rasterX.size && rasterX.points[i] <= L_n && j < rasterY.size
-         && rasterY.points[j] <= W_n)
+  int rows = normalSetX.size;
+  chain.lowerBound = poolTable<int> (TABLE_CHAIN_LOWER_BOUND, rows, sizeY);
+  chain.solutionDepth
+      = poolTable<int> (TABLE_CHAIN_SOLUTION_DEPTH, rows, sizeY);
+  chain.reachedLimit = poolTable<int> (TABLE_CHAIN_REACHED_LIMIT, rows, sizeY);
+  chain.cutPoints = poolTable<CutPoint> (TABLE_CHAIN_CUT_POINTS, rows, sizeY);
+  lowerBound = chain.lowerBound;
+  solutionDepth = chain.solutionDepth;
+  reachedLimit = chain.reachedLimit;
+  cutPoints = chain.cutPoints;
+
+  search->found[id] = -1;
+  search->foundChain[id] = -1;
+
+  /* The chains after one that solved the root problem cannot win. */
+  while (!cancelled ()
+         && (c = search->nextSlot.fetch_add (1)) < DETERMINISTIC_CHAINS
+         && c < search->solvedChain.load ())
     {
+      copyTable (main.lowerBound, lowerBound);
+      copyTable (main.solutionDepth, solutionDepth);
+      copyTable (main.reachedLimit, reachedLimit);
+      copyTable (main.cutPoints, cutPoints);
 
-      if (rasterX.points[i] == rasterY.points[j])
+      int z_lb = search->z_lb;
+      for (int slot = c; slot < search->numSlots; slot += DETERMINISTIC_CHAINS)
         {
-          normalSetX.points[k++] = rasterX.points[i++];
-          normalSetX.size++;
-          j++;
-        }
-      else if (rasterX.points[i] < rasterY.points[j])
-        {
-          normalSetX.points[k++] = rasterX.points[i++];
-          normalSetX.size++;
+          if (c > search->solvedChain.load () || cancelled ())
+            {
+              break;
+            }
+          if (searchSlot (search, slot, &z_lb))
+            {
+              int solved = search->solvedChain.load ();
+              while (c < solved
+                     && !search->solvedChain.compare_exchange_weak (solved,
+                                                                    c))
+                ;
+              break;
+            }
         }
-      else
+
+      /* The chains are taken in increasing order, so that a worker
+       * keeps the first of its chains with the best solution. */
+      if (z_lb > std::max (search->z_lb, search->found[id]))
         {
-          normalSetX.points[k++] = rasterY.points[j++];
-          normalSetX.size++;
+          if (best->lowerBound == NULL)
+            {
+              best->lowerBound
+                  = poolTable<int> (TABLE_BEST_LOWER_BOUND, rows, sizeY);
+              best->cutPoints = poolTable<CutPoint> (TABLE_BEST_CUT_POINTS,
+                                                     rows, sizeY);
+            }
+          copyTable (lowerBound, best->lowerBound);
+          copyTable (cutPoints, best->cutPoints);
+          search->found[id] = z_lb;
+          search->foundChain[id] = c;
         }
     }
-  while (i < rasterX.size && rasterX.points[i] <= L_n)
+
+  if (id != 0)
     {
-      if (rasterX.points[i] > normalSetX.points[k - 1])
-        {
-          normalSetX.points[k++] = rasterX.points[i];
-          normalSetX.size++;
-        }
-      i++;
+      setCancelToken (NULL);
     }
-  if (k > 0 && normalSetX.points[k - 1] < L_n)
+  else
     {
-      normalSetX.points[k++] = L_n;
-      normalSetX.size++;
+      lowerBound = main.lowerBound;
+      solutionDepth = main.solutionDepth;
+      reachedLimit = main.reachedLimit;
+      cutPoints = main.cutPoints;
     }
-  normalSetX.points[k] = L_n + 1;
-  normalSetX.size++;
+}
 
-  free (rasterX.points);
-  free (rasterY.points);
+/******************************************************************
+ ******************************************************************/
 
-  /* Construct the array of indices. */
-  indexX = new int[L_n + 2];
-  indexY = new int[W_n + 2];
+/**
+ * Solve the root rectangle (L,W) as BD() does, dividing its cuts among
+ * the workers of the pool. Each worker searches with its own copy of
+ * the tables and, at the end, the tables of the worker that found the
+ * best cut are copied to the tables of the calling thread. In the
+ * deterministic mode the best cut is the one of the first chain with
+ * the best solution (see chainWorker()), which does not depend on the
+ * number of workers, and the calling thread searches it alone too.
+ *
+ * Parameters and return are the same as in BD(). It supposes L >= W.
+ */
+int
+parallelBD (int L, int W, int l, int w, int n)
+{
+  int z_lb = lowerBound[indexX[L]][indexY[W]];
+  int z_ub = localUpperBound (indexX[L], indexY[W]);
 
-  for (i = 0; i < normalSetX.size; i++)
+  if (z_lb == 0 || z_lb == z_ub)
     {
-      indexX[normalSetX.points[i]] = i;
+      return BD (L, W, l, w, n);
     }
-  int ySize = 0;
-  for (i = 0; i < normalSetX.size; i++)
+
+  RootSearch search;
+  search.L = L;
+  search.W = W;
+  search.l = l;
+  search.w = w;
+  search.n = n;
+  search.z_lb = z_lb;
+  search.z_ub = z_ub;
+
+  constructRasterPoints (L, W, &search.rasterX, &search.rasterY, normalSetX);
+
+  search.numX1 = 0;
+  while (search.numX1 + 1 < search.rasterX.size
+         && search.rasterX.points[search.numX1 + 1] <= L / 2)
     {
-      if (normalSetX.points[i] > W_n)
-        {
-          break;
-        }
-      ySize++;
-      indexY[normalSetX.points[i]] = i;
+      search.numX1++;
+    }
+  search.numY1 = 0;
+  while (search.numY1 + 1 < search.rasterY.size
+         && search.rasterY.points[search.numY1 + 1] <= W / 2)
+    {
+      search.numY1++;
     }
+  search.numSlots = 2 * search.numX1 + search.numY1;
 
-  solutionDepth = new int *[normalSetX.size];
-  upperBound = new int *[normalSetX.size];
-  lowerBound = new int *[normalSetX.size];
-  reachedLimit = new int *[normalSetX.size];
-  cutPoints = new CutPoint *[normalSetX.size];
+  /* Small problems are solved faster by a single thread. */
+  double numCuts = (double)search.rasterX.size * search.rasterX.size
+                   * search.rasterY.size * search.rasterY.size;
+  if (numCuts < PARALLEL_MIN_CUTS)
+    {
+      free (search.rasterX.points);
+      free (search.rasterY.points);
+      return BD (L, W, l, w, n);
+    }
 
-  for (i = 0; i < normalSetX.size; i++)
+  reachedLimit[indexX[L]][indexY[W]] = 0;
+
+  search.indexX = indexX;
+  search.indexY = indexY;
+  search.upperBound = upperBound;
+  search.normalize = normalize;
+  search.normalSetX = normalSetX;
+  search.N = N;
+  search.sizeY = sizeY;
+  search.cancelToken = cancelToken;
+  search.nextSlot.store (0);
+  search.best.store (z_lb);
+  search.solved.store (false);
+
+  int maxWorkers = numWorkers ();
+  search.tables = new WorkerTables[maxWorkers];
+  search.found = new int[maxWorkers];
+  search.bestTables = new WorkerTables[maxWorkers]();
+  search.foundChain = new int[maxWorkers];
+  search.solvedChain.store (DETERMINISTIC_CHAINS);
+  search.main.lowerBound = lowerBound;
+  search.main.solutionDepth = solutionDepth;
+  search.main.reachedLimit = reachedLimit;
+  search.main.cutPoints = cutPoints;
+
+  bool chains = deterministic ();
+  int workers = runOnWorkers (chains ? chainWorker : rootWorker, &search,
+                             maxWorkers);
+
+  /* Choose the worker that found the best cut, the one of the first
+   * chain among equal cuts of the deterministic search. */
+  int winner = 0;
+  for (int id = 1; id < workers; id++)
     {
-      solutionDepth[i] = new int[ySize];
-      upperBound[i] = new int[ySize];
-      lowerBound[i] = new int[ySize];
-      cutPoints[i] = new CutPoint[ySize];
-      reachedLimit[i] = new int[ySize];
+      if (search.found[id] > search.found[winner]
+          || (chains && search.found[id] == search.found[winner]
+              && search.foundChain[id] < search.foundChain[winner]))
+        {
+          winner = id;
+        }
     }
 
-  for (i = 0; i < normalSetX.size; i++)
+  /* The tables of the winner are copied to the ones of the calling
+   * thread, while the tables of the workers stay in their pools, to be
+   * reused by the next search. In the deterministic mode solutionDepth
+   * and reachedLimit are not kept, they are not used after the search
+   * of the root. */
+  if (chains && search.found[winner] != -1)
+    {
+      copyTable (search.bestTables[winner].lowerBound, lowerBound);
+      copyTable (search.bestTables[winner].cutPoints, cutPoints);
+    }
+  else if (!chains)
     {
+      copyTable (search.tables[winner].lowerBound, lowerBound);
+      copyTable (search.tables[winner].solutionDepth, solutionDepth);
+      copyTable (search.tables[winner].reachedLimit, reachedLimit);
+      copyTable (search.tables[winner].cutPoints, cutPoints);
+    }
 
-      int x = normalSetX.points[i];
+  z_lb = std::max (z_lb, search.found[winner]);
 
-      for (j = 0; j < ySize; j++)
-        {
+  delete[] search.tables;
+  delete[] search.found;
+  delete[] search.bestTables;
+  delete[] search.foundChain;
+  free (search.rasterX.points);
+  free (search.rasterY.points);
 
-          int y = normalSetX.points[j];
+  return z_lb;
+}
 
-          solutionDepth[i][j] = N;
-          reachedLimit[i][j] = 1;
-          upperBound[i][j] = barnesBound (x, y, l, w);
-          lowerBound[i][j] = lowerBound (x, y, l, w);
-          cutPoints[i][j].homogeneous = 1;
-        }
-    }
+/* Tables and parameters of a problem. They are global to the thread
+ * that solves the problem, so a resumable search saves them between
+ * its steps, letting other problems be solved in the meantime. */
+struct SolverState
+{
+  int N, sizeY;
+  int **lowerBound, **upperBound, **solutionDepth, **reachedLimit;
+  CutPoint **cutPoints;
+  int *indexX, *indexY, *normalize;
+  Set normalSetX;
+  int maxAlternatives;
+  CutPoint *alternatives;
+  int **numAlternatives;
+};
+
+/* Phases of a resumable search, in the order BD() tries the cuts. */
+#define PHASE_NON_GUILLOTINE 0
+#define PHASE_VERTICAL 1
+#define PHASE_HORIZONTAL 2
+#define PHASE_DONE 3
+
+/* Search of the root rectangle that can be interrupted between two
+ * of its cuts. The cuts are tried in the same order as BD(): the
+ * first order non-guillotine cuts grouped by (x1, x2), then the
+ * vertical and the horizontal cuts. */
+struct BDSearch
+{
+  SolverState state;
+
+  /* Pallet given to start_BD(), with L >= W. */
+  int palletL, palletW;
+
+  int L, W, l, w, n;
+  int z_lb, z_ub;
+
+  Set rasterX, rasterY;
+
+  /* Next cuts to try. */
+  int phase, index_x1, index_x2, index_y1;
+
+  /* Number of cuts tried and an estimation of their total number. */
+  long done, total;
+
+  /* Number of first order non-guillotine cuts for each (x1, x2). */
+  long cutsPerX2;
+};
+
+/******************************************************************
+ ******************************************************************/
+
+void
+saveState (SolverState *state)
+{
+  state->N = N;
+  state->sizeY = sizeY;
+  state->lowerBound = lowerBound;
+  state->upperBound = upperBound;
+  state->solutionDepth = solutionDepth;
+  state->reachedLimit = reachedLimit;
+  state->cutPoints = cutPoints;
+  state->indexX = indexX;
+  state->indexY = indexY;
+  state->normalize = normalize;
+  state->normalSetX = normalSetX;
+  state->maxAlternatives = maxAlternatives;
+  state->alternatives = alternatives;
+  state->numAlternatives = numAlternatives;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+void
+loadState (const SolverState *state)
+{
+  N = state->N;
+  sizeY = state->sizeY;
+  lowerBound = state->lowerBound;
+  upperBound = state->upperBound;
+  solutionDepth = state->solutionDepth;
+  reachedLimit = state->reachedLimit;
+  cutPoints = state->cutPoints;
+  indexX = state->indexX;
+  indexY = state->indexY;
+  normalize = state->normalize;
+  normalSetX = state->normalSetX;
+  maxAlternatives = state->maxAlternatives;
+  alternatives = state->alternatives;
+  numAlternatives = state->numAlternatives;
 }
 
 /******************************************************************
  ******************************************************************/
 
 /**
- * Parameters:
- * L     - Length of the pallet.
- * W     - Width of the pallet.
- * l     - Length of the boxes.
- * w     - Width of the boxes.
- * N_max - Maximum depth.
+ * Move the search to its next cuts, starting the next phases when
+ * the current one is exhausted.
  */
-int
-solve_BD (int L, int W, int l, int w, int N_max)
+void
+nextCuts (BDSearch *search)
 {
-  int L_n, W_n;
+  Set rasterX = search->rasterX;
+  Set rasterY = search->rasterY;
 
-  N = N_max;
-  if (N <= 0)
+  if (search->phase == PHASE_NON_GUILLOTINE)
     {
-      N = INFINITY_;
+      search->index_x2++;
+      while (search->index_x1 < rasterX.size
+             && rasterX.points[search->index_x1] <= search->L / 2)
+        {
+          int x1 = rasterX.points[search->index_x1];
+          if (search->index_x2 < rasterX.size
+              && rasterX.points[search->index_x2] + x1 <= search->L)
+            {
+              return;
+            }
+          search->index_x1++;
+          search->index_x2 = search->index_x1 + 1;
+        }
+      search->phase = PHASE_VERTICAL;
+      search->index_x1 = 1;
     }
-
-  /* We assume that L >= W. */
-  if (W > L)
+  else if (search->phase == PHASE_VERTICAL)
     {
-      std::swap (L, W);
+      search->index_x1++;
+    }
+  else if (search->phase == PHASE_HORIZONTAL)
+    {
+      search->index_y1++;
     }
 
-  initialize (L, W, l, w);
+  if (search->phase == PHASE_VERTICAL
+      && !(search->index_x1 < rasterX.size
+           && rasterX.points[search->index_x1] <= search->L / 2))
+    {
+      search->phase = PHASE_HORIZONTAL;
+      search->index_y1 = 1;
+    }
 
-  /* Normalize (L, W). */
-  L_n = normalize[L];
-  W_n = normalize[W];
+  if (search->phase == PHASE_HORIZONTAL
+      && !(search->index_y1 < rasterY.size
+           && rasterY.points[search->index_y1] <= search->W / 2))
+    {
+      search->phase = PHASE_DONE;
+    }
+}
 
-  int solution = BD (L_n, W_n, l, w, N);
+/******************************************************************
+ ******************************************************************/
 
-  /* remove this stupid check */
+/**
+ * Store the solution of the root rectangle. The tables stay in the
+ * pool of the thread.
+ */
+void
+finishSearch (int L_n, int W_n, int solution)
+{
+  lowerBound[indexX[L_n]][indexY[W_n]] = solution;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+BDSearch *
+start_BD (int L, int W, int l, int w, int N_max)
+{
+  BDSearch *search = new BDSearch;
+
+  N = N_max;
+  if (N <= 0)
+    {
+      N = INFINITY_;
+    }
+  maxAlternatives = 0;
+
+  /* We assume that L >= W. */
+  if (W > L)
+    {
+      std::swap (L, W);
+    }
+
+  initialize (L, W, l, w);
+
+  search->palletL = L;
+  search->palletW = W;
+  search->L = normalize[L];
+  search->W = normalize[W];
+  search->l = l;
+  search->w = w;
+  search->n = N;
+  search->z_lb = lowerBound[indexX[search->L]][indexY[search->W]];
+  search->z_ub = localUpperBound (indexX[search->L], indexY[search->W]);
+  search->done = 0;
+  search->total = 1;
+
+  if (search->z_lb == 0 || search->z_lb == search->z_ub)
+    {
+      /* Nothing to search. */
+      search->z_lb = BD (search->L, search->W, l, w, N);
+      search->phase = PHASE_DONE;
+      search->index_x1 = search->index_x2 = search->index_y1 = 0;
+      search->rasterX.points = search->rasterY.points = NULL;
+      saveState (&search->state);
+      return search;
+    }
+
+  constructRasterPoints (search->L, search->W, &search->rasterX,
+                         &search->rasterY, normalSetX);
+  reachedLimit[indexX[search->L]][indexY[search->W]] = 0;
+
+  /* Estimate the number of cuts, ignoring the symmetry of the
+   * non-guillotine cuts with x1 + x2 = L. */
+  int numY = 0;
+  while (numY + 1 < search->rasterY.size
+         && search->rasterY.points[numY + 1] < search->W)
+    {
+      numY++;
+    }
+  search->cutsPerX2 = std::max (1L, (long)numY * (numY - 1) / 2);
+
+  search->phase = PHASE_NON_GUILLOTINE;
+  search->index_x1 = 1;
+  search->index_x2 = 1;
+  search->index_y1 = 1;
+  nextCuts (search);
+
+  BDSearch count = *search;
+  search->total = 0;
+  while (count.phase != PHASE_DONE)
+    {
+      search->total
+          += (count.phase == PHASE_NON_GUILLOTINE) ? search->cutsPerX2 : 1;
+      nextCuts (&count);
+    }
+  search->total = std::max (search->total, 1L);
+
+  saveState (&search->state);
+  return search;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+step_BD (BDSearch *search, long budget)
+{
+  loadState (&search->state);
+
+  while (search->phase != PHASE_DONE && budget > 0)
+    {
+      int solved;
+      long cuts;
+
+      if (search->phase == PHASE_NON_GUILLOTINE)
+        {
+          solved = nonGuillotineCutsAt (
+              search->L, search->W, search->l, search->w, search->n,
+              &search->z_lb, search->z_ub, search->rasterX, search->rasterY,
+              search->index_x1, search->index_x2);
+          cuts = search->cutsPerX2;
+        }
+      else if (search->phase == PHASE_VERTICAL)
+        {
+          solved = verticalCut (search->L, search->W, search->l, search->w,
+                                search->n, &search->z_lb, search->z_ub,
+                                search->rasterX, search->index_x1);
+          cuts = 1;
+        }
+      else
+        {
+          solved = horizontalCut (search->L, search->W, search->l, search->w,
+                                  search->n, &search->z_lb, search->z_ub,
+                                  search->rasterY, search->index_y1);
+          cuts = 1;
+        }
+
+      search->done += cuts;
+      budget -= cuts;
+
+      if (solved || cancelled ())
+        {
+          /* This problem was solved with optimality guarantee or the
+           * search was cancelled. */
+          search->phase = PHASE_DONE;
+        }
+      else
+        {
+          nextCuts (search);
+        }
+    }
+
+  if (search->phase == PHASE_DONE)
+    {
+      search->done = search->total;
+    }
+
+  return search->phase == PHASE_DONE;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+double
+progress_BD (const BDSearch *search)
+{
+  return std::min (1.0, (double)search->done / search->total);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+finish_BD (BDSearch *search)
+{
+  int solution;
+
+  while (!step_BD (search, INFINITY_))
+    ;
+
+  solution = search->z_lb;
+  finishSearch (search->L, search->W, solution);
+
+  free (search->rasterX.points);
+  free (search->rasterY.points);
+  delete search;
+
+  return solution;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+void
+cancel_BD (BDSearch *search)
+{
+  loadState (&search->state);
+  finishSearch (search->L, search->W, search->z_lb);
+
+  free (search->rasterX.points);
+  free (search->rasterY.points);
+  delete search;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+save_BD (const BDSearch *search, const char *path)
+{
+  const SolverState *state = &search->state;
+  size_t cells = (size_t)state->normalSetX.size * state->sizeY;
+
+  CheckpointHeader header;
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, CHECKPOINT_MAGIC, sizeof (header.magic));
+  header.version = CHECKPOINT_VERSION;
+  header.cutPointSize = sizeof (CutPoint);
+  header.L = search->palletL;
+  header.W = search->palletW;
+  header.l = search->l;
+  header.w = search->w;
+  header.N = search->n;
+  header.rows = state->normalSetX.size;
+  header.cols = state->sizeY;
+  header.phase = search->phase;
+  header.index_x1 = search->index_x1;
+  header.index_x2 = search->index_x2;
+  header.index_y1 = search->index_y1;
+  header.z_lb = search->z_lb;
+  header.z_ub = search->z_ub;
+  header.done = search->done;
+  header.lowerBoundOffset = sizeof (CheckpointHeader);
+  header.upperBoundOffset = header.lowerBoundOffset + cells * sizeof (int);
+  header.solutionDepthOffset
+      = header.upperBoundOffset + cells * sizeof (int);
+  header.reachedLimitOffset
+      = header.solutionDepthOffset + cells * sizeof (int);
+  header.cutPointsOffset = header.reachedLimitOffset + cells * sizeof (int);
+  header.size = header.cutPointsOffset + cells * sizeof (CutPoint);
+
+  /* Write a temporary file and rename it, so that a failure while
+   * writing keeps the previous checkpoint. */
+  std::string temporary = std::string (path) + ".tmp";
+  FILE *file = fopen (temporary.c_str (), "wb");
+  if (file == NULL)
+    {
+      return 0;
+    }
+
+  /* The rows of each table are stored contiguously (see poolTable). */
+  bool ok = fwrite (&header, sizeof (header), 1, file) == 1
+            && fwrite (state->lowerBound[0], sizeof (int), cells, file)
+                   == cells
+            && fwrite (state->upperBound[0], sizeof (int), cells, file)
+                   == cells
+            && fwrite (state->solutionDepth[0], sizeof (int), cells, file)
+                   == cells
+            && fwrite (state->reachedLimit[0], sizeof (int), cells, file)
+                   == cells
+            && fwrite (state->cutPoints[0], sizeof (CutPoint), cells, file)
+                   == cells;
+  ok = fclose (file) == 0 && ok;
+
+  if (!ok || rename (temporary.c_str (), path) != 0)
+    {
+      unlink (temporary.c_str ());
+      return 0;
+    }
+  return 1;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Restore a search just started by start_BD() from the checkpoint of
+ * the same problem mapped at data.
+ *
+ * Return:
+ * - false if the checkpoint does not match the search.
+ */
+static bool
+restoreSearch (BDSearch *search, const CheckpointHeader *header,
+               const unsigned char *data)
+{
+  SolverState *state = &search->state;
+  size_t cells = (size_t)state->normalSetX.size * state->sizeY;
+
+  if (header->rows != state->normalSetX.size
+      || header->cols != state->sizeY
+      || header->lowerBoundOffset != sizeof (CheckpointHeader)
+      || header->upperBoundOffset
+             != header->lowerBoundOffset + cells * sizeof (int)
+      || header->solutionDepthOffset
+             != header->upperBoundOffset + cells * sizeof (int)
+      || header->reachedLimitOffset
+             != header->solutionDepthOffset + cells * sizeof (int)
+      || header->cutPointsOffset
+             != header->reachedLimitOffset + cells * sizeof (int)
+      || header->size != header->cutPointsOffset + cells * sizeof (CutPoint))
+    {
+      return false;
+    }
+
+  if (search->phase == PHASE_DONE)
+    {
+      /* Nothing to search, start_BD() already solved the problem. */
+      return true;
+    }
+
+  /* The indices of the next cuts are not used once the search is
+   * over. */
+  if (header->phase < PHASE_NON_GUILLOTINE || header->phase > PHASE_DONE
+      || header->done < 0
+      || (header->phase != PHASE_DONE
+          && (header->index_x1 < 0
+              || header->index_x1 > search->rasterX.size
+              || header->index_x2 < 0
+              || header->index_x2 > search->rasterX.size
+              || header->index_y1 < 0
+              || header->index_y1 > search->rasterY.size)))
+    {
+      return false;
+    }
+
+  memcpy (state->lowerBound[0], data + header->lowerBoundOffset,
+          cells * sizeof (int));
+  memcpy (state->upperBound[0], data + header->upperBoundOffset,
+          cells * sizeof (int));
+  memcpy (state->solutionDepth[0], data + header->solutionDepthOffset,
+          cells * sizeof (int));
+  memcpy (state->reachedLimit[0], data + header->reachedLimitOffset,
+          cells * sizeof (int));
+  memcpy (state->cutPoints[0], data + header->cutPointsOffset,
+          cells * sizeof (CutPoint));
+
+  search->phase = header->phase;
+  search->index_x1 = header->index_x1;
+  search->index_x2 = header->index_x2;
+  search->index_y1 = header->index_y1;
+  search->z_lb = header->z_lb;
+  search->z_ub = header->z_ub;
+  search->done = std::min ((long)header->done, search->total);
+  return true;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+BDSearch *
+resume_BD (int L, int W, int l, int w, int N_max, const char *path)
+{
+  struct stat info;
+  int fd = open (path, O_RDONLY);
+
+  if (fd < 0)
+    {
+      return NULL;
+    }
+  if (fstat (fd, &info) != 0
+      || (size_t)info.st_size < sizeof (CheckpointHeader))
+    {
+      close (fd);
+      return NULL;
+    }
+
+  size_t size = (size_t)info.st_size;
+  void *data = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (data == MAP_FAILED)
+    {
+      return NULL;
+    }
+
+  /* We assume that L >= W. */
+  if (W > L)
+    {
+      std::swap (L, W);
+    }
+
+  const CheckpointHeader *header = (const CheckpointHeader *)data;
+  bool valid
+      = memcmp (header->magic, CHECKPOINT_MAGIC, sizeof (header->magic)) == 0
+        && header->version == CHECKPOINT_VERSION
+        && header->cutPointSize == sizeof (CutPoint) && header->L == L
+        && header->W == W && header->l == l && header->w == w
+        && header->N == (N_max <= 0 ? INFINITY_ : N_max)
+        && header->size == size;
+
+  BDSearch *search = NULL;
+  if (valid)
+    {
+      search = start_BD (L, W, l, w, N_max);
+      if (!restoreSearch (search, header, (const unsigned char *)data))
+        {
+          cancel_BD (search);
+          search = NULL;
+        }
+    }
+
+  munmap (data, size);
+  return search;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Compute the Barnes's upper bound [3].
+ *
+ * [3] F. W. Barnes. Packing the maximum number of m x n tiles in a
+ *     large p x q rectangle. Discrete Mathematics, volume 26,
+ *     pages 93-100, 1979.
+ *
+ * Parameters:
+ * (L, W) Pallet dimensions.
+ * (l, w) Dimensions of the boxes to be packed.
+ *
+ * Return:
+ * - the computed Barnes's bound.
+ */
+int
+barnesBound (int L, int W, int l, int w)
+{
+  int r, s, D;
+  int minWaste = (L * W) % (l * w);
+
+  /* (l,1)-boxes packing. */
+  r = L % l;
+  s = W % l;
+  int A = std::min (r * s, (l - r) * (l - s));
+
+  /* (1,w)-boxes packing. */
+  r = L % w;
+  s = W % w;
+  int B = std::min (r * s, (w - r) * (w - s));
+
+  /* Best unitary tile packing. */
+  int maxAB = std::max (A, B);
+
+  if (minWaste >= maxAB % (l * w))
+    {
+      /* Wasted area. */
+      D = (maxAB / (l * w)) * (l * w) + minWaste;
+    }
+  else
+    {
+      /* Wasted area. */
+      D = (maxAB / (l * w) + 1) * (l * w) + minWaste;
+    }
+
+  return (L * W - D) / (l * w);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Build the tables of the problems of packing (l,w)-boxes into several
+ * pallets at once. The rows and columns of the tables are the union of
+ * the raster points of the pallets, which holds the raster points of
+ * every rectangle of their searches, so that the pallets share the
+ * solutions of their rectangles.
+ *
+ * Parameters:
+ * count   - Number of pallets.
+ * pallets - Dimensions of the pallets, as count pairs (L,W) with L >= W.
+ * l       - Length of the boxes.
+ * w       - Width of the boxes.
+ */
+void
+initialize (int count, const int *pallets, int l, int w)
+{
+
+  /* The largest dimensions, and their normalizations. */
+  int L = 0, W = 0;
+  int L_n, W_n;
+
+  int i, j;
+
+  Set rasterX, rasterY;
+
+  for (i = 0; i < count; i++)
+    {
+      L = std::max (L, pallets[2 * i]);
+      W = std::max (W, pallets[2 * i + 1]);
+    }
+
+  /* Construct the conic combination set of l and w. */
+  /* The tables are taken from the pool of the thread, so that they
+   * are allocated only when the problem is larger than the previous
+   * ones. Every entry used is initialized below. */
+  normalSetX.size = 0;
+  normalSetX.points = poolArray<int> (TABLE_NORMAL_SET, L + 2);
+  constructConicCombinations (L, l, w, &normalSetX);
+
+  /* Compute the values of L* and W*.
+   * normalize[i] = max {x in X | x <= i} */
+  normalize = poolArray<int> (TABLE_NORMALIZE, L + 1);
+  i = 0;
+  for (j = 0; j <= L; j++)
+    {
+      for (; i < normalSetX.size && normalSetX.points[i] <= j; i++)
+        ;
+      normalize[j] = normalSetX.points[i - 1];
+    }
+
+  /* Normalize (L, W). */
+  L_n = normalize[L];
+  W_n = normalize[W];
+
+  /* Mark the raster points of every pallet. */
+  char *inSet = (char *)calloc (L_n + 1, sizeof (char));
+  for (i = 0; i < count; i++)
+    {
+      constructRasterPoints (pallets[2 * i], pallets[2 * i + 1], &rasterX,
+                             &rasterY, normalSetX);
+      for (j = 0; j < rasterX.size; j++)
+        {
+          inSet[rasterX.points[j]] = 1;
+        }
+      for (j = 0; j < rasterY.size; j++)
+        {
+          inSet[rasterY.points[j]] = 1;
+        }
+      inSet[normalize[pallets[2 * i]]] = 1;
+      free (rasterX.points);
+      free (rasterY.points);
+    }
+
+  /* The new set takes the place of the conic combinations, which are
+   * no longer needed. */
+  normalSetX.size = 0;
+  for (i = 0; i <= L_n; i++)
+    {
+      if (inSet[i])
+        {
+          normalSetX.points[normalSetX.size++] = i;
+        }
+    }
+  free (inSet);
+  normalSetX.points[normalSetX.size++] = L_n + 1;
+
+  /* Construct the array of indices. */
+  indexX = poolArray<int> (TABLE_INDEX_X, L_n + 2);
+  indexY = poolArray<int> (TABLE_INDEX_Y, W_n + 2);
+
+  for (i = 0; i < normalSetX.size; i++)
+    {
+      indexX[normalSetX.points[i]] = i;
+    }
+  sizeY = 0;
+  for (i = 0; i < normalSetX.size; i++)
+    {
+      if (normalSetX.points[i] > W_n)
+        {
+          break;
+        }
+      sizeY++;
+      indexY[normalSetX.points[i]] = i;
+    }
+
+  solutionDepth
+      = poolTable<int> (TABLE_SOLUTION_DEPTH, normalSetX.size, sizeY);
+  upperBound = poolTable<int> (TABLE_UPPER_BOUND, normalSetX.size, sizeY);
+  lowerBound = poolTable<int> (TABLE_LOWER_BOUND, normalSetX.size, sizeY);
+  cutPoints = poolTable<CutPoint> (TABLE_CUT_POINTS, normalSetX.size, sizeY);
+  reachedLimit
+      = poolTable<int> (TABLE_REACHED_LIMIT, normalSetX.size, sizeY);
+
+  /* No other cut is kept yet. */
+  if (maxAlternatives > 0)
+    {
+      alternatives = poolArray<CutPoint> (
+          TABLE_ALTERNATIVES, normalSetX.size * sizeY * maxAlternatives);
+      numAlternatives = poolTable<int> (TABLE_NUM_ALTERNATIVES,
+                                        normalSetX.size, sizeY);
+      std::fill (numAlternatives[0],
+                 numAlternatives[0] + normalSetX.size * sizeY, 0);
+    }
+
+#ifdef __wasm_simd128__
+  /* Quotients y / w and y / l of each column, for the lower bounds.
+   * The buffers of the screening are free until the search. */
+  int *quotientW = poolArray<int> (TABLE_SCREEN_F, sizeY);
+  int *quotientL = poolArray<int> (TABLE_SCREEN_G, sizeY);
+  for (j = 0; j < sizeY; j++)
+    {
+      quotientW[j] = normalSetX.points[j] / w;
+      quotientL[j] = normalSetX.points[j] / l;
+    }
+#endif
+
+  for (i = 0; i < normalSetX.size; i++)
+    {
+
+      int x = normalSetX.points[i];
+
+      j = 0;
+
+#ifdef __wasm_simd128__
+      /* lowerBound (x, y, l, w) = max ((x/l) (y/w), (x/w) (y/l)) for four
+       * columns at once. */
+      v128_t xl = wasm_i32x4_splat (x / l);
+      v128_t xw = wasm_i32x4_splat (x / w);
+      for (; j + 4 <= sizeY; j += 4)
+        {
+          wasm_v128_store (&solutionDepth[i][j], wasm_i32x4_splat (N));
+          wasm_v128_store (&reachedLimit[i][j], wasm_i32x4_splat (1));
+          wasm_v128_store (
+              &lowerBound[i][j],
+              wasm_i32x4_max (
+                  wasm_i32x4_mul (xl, wasm_v128_load (&quotientW[j])),
+                  wasm_i32x4_mul (xw, wasm_v128_load (&quotientL[j]))));
+        }
+      for (int k = 0; k < j; k++)
+        {
+          upperBound[i][k] = barnesBound (x, normalSetX.points[k], l, w);
+          cutPoints[i][k].homogeneous = 1;
+          cutPoints[i][k].lApproach = 0;
+          cutPoints[i][k].seed = 0;
+        }
+#endif
+
+      for (; j < sizeY; j++)
+        {
+
+          int y = normalSetX.points[j];
+
+          solutionDepth[i][j] = N;
+          reachedLimit[i][j] = 1;
+          upperBound[i][j] = barnesBound (x, y, l, w);
+          lowerBound[i][j] = lowerBound (x, y, l, w);
+          cutPoints[i][j].homogeneous = 1;
+          cutPoints[i][j].lApproach = 0;
+          cutPoints[i][j].seed = 0;
+        }
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Determine whether the blocks of a seed are a packing: they are not
+ * empty, lie in the first quadrant and do not overlap.
+ */
+static bool
+validSeed (const std::vector<Block> &seed)
+{
+  for (size_t i = 0; i < seed.size (); i++)
+    {
+      const Block &a = seed[i];
+
+      if (a.x <= 0 || a.y <= 0 || a.dx < 0 || a.dy < 0)
+        {
+          return false;
+        }
+      for (size_t j = 0; j < i; j++)
+        {
+          const Block &b = seed[j];
+
+          if (a.dx < b.dx + b.x && b.dx < a.dx + a.x && a.dy < b.dy + b.y
+              && b.dy < a.dy + a.y)
+            {
+              return false;
+            }
+        }
+    }
+  return true;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Raise the lower bound of each rectangle (x,y) to the number of boxes
+ * of the blocks of the seed that fit into [0,x] x [0,y], each one
+ * packed homogeneously with the (l,w)-boxes. The rectangles raised are
+ * packed by the seed (see CutPoint).
+ */
+static void
+seedCells (const std::vector<Block> &seed, int l, int w)
+{
+  int rows = normalSetX.size - 1;
+  std::vector<int> boxes ((size_t)rows * sizeY, 0);
+
+  /* Each block counts in the rectangles from the smallest one that
+   * holds it on, so the counts are sums over the quadrants. */
+  for (size_t k = 0; k < seed.size (); k++)
+    {
+      const Block &b = seed[k];
+      int n = std::max ((b.x / l) * (b.y / w), (b.x / w) * (b.y / l));
+      int i = std::lower_bound (normalSetX.points, normalSetX.points + rows,
+                                b.dx + b.x)
+              - normalSetX.points;
+      int j = std::lower_bound (normalSetX.points, normalSetX.points + sizeY,
+                                b.dy + b.y)
+              - normalSetX.points;
+
+      if (n > 0 && i < rows && j < sizeY)
+        {
+          boxes[(size_t)i * sizeY + j] += n;
+        }
+    }
+
+  for (int i = 0; i < rows; i++)
+    {
+      for (int j = 0; j < sizeY; j++)
+        {
+          size_t k = (size_t)i * sizeY + j;
+
+          if (i > 0)
+            {
+              boxes[k] += boxes[k - sizeY];
+            }
+          if (j > 0)
+            {
+              boxes[k] += boxes[k - 1];
+            }
+          if (i > 0 && j > 0)
+            {
+              boxes[k] -= boxes[k - sizeY - 1];
+            }
+
+          /* The tables hold the rectangles with x >= y only. */
+          if (j <= i && boxes[k] > lowerBound[i][j]
+              && boxes[k] <= upperBound[i][j])
+            {
+              CutPoint c = { 0, 0, 0, 0, 0, 0, 1 };
+              lowerBound[i][j] = boxes[k];
+              cutPoints[i][j] = c;
+            }
+        }
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Parameters:
+ * L     - Length of the pallet.
+ * W     - Width of the pallet.
+ * l     - Length of the boxes.
+ * w     - Width of the boxes.
+ * N_max - Maximum depth.
+ * seed  - Blocks of the seed, or NULL.
+ */
+int
+solve_BD (int L, int W, int l, int w, int N_max,
+          const std::vector<Block> *seed)
+{
+  int L_n, W_n;
+
+  N = N_max;
+  if (N <= 0)
+    {
+      N = INFINITY_;
+    }
+  maxAlternatives = 0;
+
+  /* We assume that L >= W. */
+  if (W > L)
+    {
+      std::swap (L, W);
+    }
+
+  initialize (L, W, l, w);
+
+  /* Normalize (L, W). */
+  L_n = normalize[L];
+  W_n = normalize[W];
+
+  /* The search starts from the packings of the seed. */
+  seedBlocks = NULL;
+  if (seed != NULL && validSeed (*seed))
+    {
+      seedBlocks = seed;
+      seedCells (*seed, l, w);
+    }
+
+  /* The cuts of the pallet are divided among the workers of the
+   * pool, if there is more than one. */
+  int solution = (numWorkers () > 1 || deterministic ())
+                     ? parallelBD (L_n, W_n, l, w, N)
+                     : BD (L_n, W_n, l, w, N);
+
+  /* remove this stupid check */
   // if (solution != upperBound[indexX[L_n]][indexY[W_n]] && N != 1)
   //   {
   //     /* If the solution found is not optimal (or, at least, if it is not
@@ -814,16 +2429,511 @@ solve_BD (int L, int W, int l, int w, int N_max)
   //     solution = BD (L_n, W_n, l, w, 1);
   //   }
 
-  lowerBound[indexX[L_n]][indexY[W_n]] = solution;
+  finishSearch (L_n, W_n, solution);
+
+  return solution;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+solve_BD (int L, int W, int l, int w, int N_max)
+{
+  return solve_BD (L, W, l, w, N_max, NULL);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+solveAlternatives_BD (int L, int W, int l, int w, int N_max, int cuts)
+{
+  int L_n, W_n;
+
+  N = N_max;
+  if (N <= 0)
+    {
+      N = INFINITY_;
+    }
+  maxAlternatives = std::max (cuts - 1, 0);
+
+  /* We assume that L >= W. */
+  if (W > L)
+    {
+      std::swap (L, W);
+    }
+
+  initialize (L, W, l, w);
+  seedBlocks = NULL;
+
+  /* Normalize (L, W). */
+  L_n = normalize[L];
+  W_n = normalize[W];
+
+  /* The cuts kept by the workers would be lost with their tables, so
+   * the search is not divided among them. */
+  int solution = BD (L_n, W_n, l, w, N);
+  finishSearch (L_n, W_n, solution);
+
+  return solution;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Build the tables of the problem of packing (l,w)-boxes into the
+ * (L,W) pallet, with L >= W.
+ */
+void
+initialize (int L, int W, int l, int w)
+{
+  int pallet[2] = { L, W };
+  initialize (1, pallet, l, w);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+void
+solveMany_BD (int count, const int *pallets, int l, int w, int N_max,
+              int *solutions)
+{
+  std::vector<int> oriented (pallets, pallets + 2 * count);
+  std::vector<int> order (count);
+
+  N = N_max;
+  if (N <= 0)
+    {
+      N = INFINITY_;
+    }
+  maxAlternatives = 0;
+
+  /* We assume that L >= W. */
+  for (int i = 0; i < count; i++)
+    {
+      if (oriented[2 * i + 1] > oriented[2 * i])
+        {
+          std::swap (oriented[2 * i], oriented[2 * i + 1]);
+        }
+      order[i] = i;
+    }
+
+  initialize (count, oriented.data (), l, w);
+
+  /* The larger pallets first, whose searches solve rectangles of the
+   * smaller ones. */
+  std::vector<long> area (count);
+  for (int i = 0; i < count; i++)
+    {
+      area[i] = (long)oriented[2 * i] * oriented[2 * i + 1];
+    }
+  for (int i = 1; i < count; i++)
+    {
+      int k = order[i];
+      int j = i;
+      while (j > 0 && area[order[j - 1]] < area[k])
+        {
+          order[j] = order[j - 1];
+          j--;
+        }
+      order[j] = k;
+    }
+
+  for (int i = 0; i < count && !cancelled (); i++)
+    {
+      int L_n = normalize[oriented[2 * order[i]]];
+      int W_n = normalize[oriented[2 * order[i] + 1]];
+
+      /* A pallet packed optimally by the searches before is not
+       * searched again. */
+      if (lowerBound[indexX[L_n]][indexY[W_n]]
+          == upperBound[indexX[L_n]][indexY[W_n]])
+        {
+          continue;
+        }
+
+      int solution = (numWorkers () > 1 || deterministic ())
+                         ? parallelBD (L_n, W_n, l, w, N)
+                         : BD (L_n, W_n, l, w, N);
+      finishSearch (L_n, W_n, solution);
+    }
+
+  /* The later searches may have raised the solutions of the earlier
+   * pallets. */
+  for (int i = 0; i < count; i++)
+    {
+      solutions[i] = lowerBound[indexX[normalize[oriented[2 * i]]]]
+                               [indexY[normalize[oriented[2 * i + 1]]]];
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+refine_BD (int L, int W, int l, int w)
+{
+  int L_n, W_n;
+  bool improved = false;
+
+  /* We assume that L >= W. */
+  if (W > L)
+    {
+      std::swap (L, W);
+    }
 
+  L_n = normalize[L];
+  W_n = normalize[W];
+
+  /* The rectangles solved before without optimality guarantee are
+   * solved again, to combine the ones packed by the L-approach. */
   for (int i = 0; i < normalSetX.size; i++)
     {
-      free (reachedLimit[i]);
-      free (solutionDepth[i]);
+      for (int j = 0; j < sizeY; j++)
+        {
+          if (cutPoints[i][j].lApproach)
+            {
+              improved = true;
+            }
+          if (lowerBound[i][j] < upperBound[i][j])
+            {
+              solutionDepth[i][j] = N;
+            }
+        }
+    }
+
+  if (!improved)
+    {
+      /* The search would find the same solution. */
+      return lowerBound[indexX[L_n]][indexY[W_n]];
+    }
+
+  int solution = (numWorkers () > 1 || deterministic ())
+                     ? parallelBD (L_n, W_n, l, w, N)
+                     : BD (L_n, W_n, l, w, N);
+  finishSearch (L_n, W_n, solution);
+
+  return solution;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+void
+grid_BD (int L, int W, AnswerGrid *grid)
+{
+  bool swap = W > L;
+
+  /* We assume that L >= W. */
+  if (swap)
+    {
+      std::swap (L, W);
+    }
+
+  int L_n = normalize[L];
+  int W_n = normalize[W];
+  int rows, cols;
+
+  /* The sentinel L_n + 1 ends the breakpoints. */
+  for (rows = 0; normalSetX.points[rows] <= L_n; rows++)
+    ;
+  for (cols = 0; cols < sizeY && normalSetX.points[cols] <= W_n; cols++)
+    ;
+
+  std::vector<int> count ((size_t)rows * cols);
+  std::vector<char> optimal ((size_t)rows * cols);
+
+  for (int i = 0; i < rows; i++)
+    {
+      for (int j = 0; j < cols; j++)
+        {
+          /* The tables hold the rectangles with x >= y only. */
+          int x = normalSetX.points[i];
+          int y = normalSetX.points[j];
+          int iX = x >= y ? indexX[x] : indexX[y];
+          int iY = x >= y ? indexY[y] : indexY[x];
+          int z = lowerBound[iX][iY];
+
+          /* A packing of a smaller rectangle also fits. */
+          if (i > 0)
+            {
+              z = std::max (z, count[(size_t)(i - 1) * cols + j]);
+            }
+          if (j > 0)
+            {
+              z = std::max (z, count[(size_t)i * cols + j - 1]);
+            }
+          count[(size_t)i * cols + j] = z;
+          optimal[(size_t)i * cols + j] = z == upperBound[iX][iY];
+        }
+    }
+
+  grid->x.assign (normalSetX.points, normalSetX.points + rows);
+  grid->y.assign (normalSetX.points, normalSetX.points + cols);
+  grid->count.swap (count);
+  grid->optimal.swap (optimal);
+
+  if (swap)
+    {
+      /* Back to the orientation of the pallet given. */
+      std::swap (grid->x, grid->y);
+      count.resize ((size_t)rows * cols);
+      optimal.resize ((size_t)rows * cols);
+      for (int i = 0; i < rows; i++)
+        {
+          for (int j = 0; j < cols; j++)
+            {
+              count[(size_t)j * rows + i] = grid->count[(size_t)i * cols + j];
+              optimal[(size_t)j * rows + i]
+                  = grid->optimal[(size_t)i * cols + j];
+            }
+        }
+      grid->count.swap (count);
+      grid->optimal.swap (optimal);
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/* Last problem solved by resolve_BD() and its tables. */
+struct BDHistory
+{
+  /* Pools of the tables of the last problem and of the next one,
+   * which take turns. */
+  TablePool *tables[2];
+
+  /* Index in tables of the pool of the last problem, or -1 if there
+   * is none. */
+  int last;
+
+  SolverState state;
+
+  /* Root rectangle of the last problem, with L >= W, and its boxes,
+   * with l >= w. */
+  int L, W, l, w;
+};
+
+/******************************************************************
+ ******************************************************************/
+
+BDHistory *
+newHistory_BD ()
+{
+  BDHistory *history = new BDHistory;
+
+  history->tables[0] = newTablePool ();
+  history->tables[1] = newTablePool ();
+  history->last = -1;
+  return history;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+void
+deleteHistory_BD (BDHistory *history)
+{
+  if (history == NULL)
+    {
+      return;
+    }
+  deleteTablePool (history->tables[0]);
+  deleteTablePool (history->tables[1]);
+  delete history;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Determine whether the rectangle of the cell (i,j) of the old tables
+ * can be copied to the tables of the thread, with the cuts of its
+ * packing: the rectangles of the cuts must all have cells in the
+ * tables of the thread.
+ *
+ * Parameters:
+ * old     - Tables of the previous problem.
+ * i, j    - Cell of the rectangle in the old tables.
+ * row     - Row of the tables of the thread for each row of the old
+ *           tables, -1 if there is none.
+ * known   - State of each cell of the old tables: 0 if not visited
+ *           yet, 1 if it can be copied, 2 otherwise.
+ */
+static bool
+reusableCell (const SolverState *old, int i, int j,
+              const std::vector<int> &row, std::vector<char> &known)
+{
+  char *state = &known[(size_t)i * old->sizeY + j];
+
+  if (*state == 0)
+    {
+      CutPoint cut = old->cutPoints[i][j];
+      int x = old->normalSetX.points[i];
+      int y = old->normalSetX.points[j];
+
+      *state = (row[i] >= 0 && row[j] >= 0 && row[j] < sizeY
+                && !cut.lApproach && !cut.seed)
+                   ? 1
+                   : 2;
+
+      if (*state == 1 && !cut.homogeneous)
+        {
+          /* The rectangles of the cut, as in solve(). */
+          int L_[6] = { 0,
+                        cut.x1,
+                        old->normalize[x - cut.x1],
+                        old->normalize[cut.x2 - cut.x1],
+                        cut.x2,
+                        old->normalize[x - cut.x2] };
+          int W_[6] = { 0,
+                        old->normalize[y - cut.y1],
+                        old->normalize[y - cut.y2],
+                        old->normalize[cut.y2 - cut.y1],
+                        cut.y1,
+                        cut.y2 };
+
+          for (int k = 1; k <= 5 && *state == 1; k++)
+            {
+              int a = std::max (L_[k], W_[k]);
+              int b = std::min (L_[k], W_[k]);
+
+              if (b == 0 || (a == x && b == y))
+                {
+                  continue;
+                }
+              if (!reusableCell (old, old->indexX[a], old->indexY[b], row,
+                                 known))
+                {
+                  *state = 2;
+                }
+            }
+        }
+    }
+  return *state == 1;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Copy to the tables of the thread the packings of the rectangles
+ * found in the old tables, for the same boxes, that have cells in both
+ * tables together with the rectangles of their cuts. The bounds of a
+ * rectangle do not depend on the pallet, so the packings copied are
+ * valid lower bounds, and the rectangles packed optimally are not
+ * searched again.
+ */
+static void
+reuseCells (const SolverState *old)
+{
+  int oldRows = old->normalSetX.size - 1;
+  std::vector<int> row (oldRows, -1);
+  std::vector<char> known ((size_t)oldRows * old->sizeY, 0);
+
+  /* Both sets of rows are sorted, and end with a sentinel. */
+  for (int i = 0, k = 0; i < oldRows; i++)
+    {
+      while (k < normalSetX.size - 1
+             && normalSetX.points[k] < old->normalSetX.points[i])
+        {
+          k++;
+        }
+      if (k < normalSetX.size - 1
+          && normalSetX.points[k] == old->normalSetX.points[i])
+        {
+          row[i] = k;
+        }
+    }
+
+  for (int i = 0; i < oldRows; i++)
+    {
+      for (int j = 0; j < old->sizeY && j <= i; j++)
+        {
+          if (row[i] < 0 || row[j] < 0 || row[j] >= sizeY)
+            {
+              continue;
+            }
+
+          /* The other cells hold the same packing in both tables. */
+          if (old->lowerBound[i][j] > lowerBound[row[i]][row[j]]
+              && reusableCell (old, i, j, row, known))
+            {
+              lowerBound[row[i]][row[j]] = old->lowerBound[i][j];
+              cutPoints[row[i]][row[j]] = old->cutPoints[i][j];
+            }
+        }
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+resolve_BD (BDHistory *history, int L, int W, int l, int w, int N_max,
+            int *unchanged)
+{
+  int next = (history->last == 0) ? 1 : 0;
+  bool sameBoxes;
+
+  *unchanged = 0;
+
+  N = N_max;
+  if (N <= 0)
+    {
+      N = INFINITY_;
+    }
+  maxAlternatives = 0;
+
+  /* We assume that L >= W. */
+  if (W > L)
+    {
+      std::swap (L, W);
+    }
+
+  setTablePool (history->tables[next]);
+  initialize (L, W, l, w);
+
+  int L_n = normalize[L];
+  int W_n = normalize[W];
+
+  sameBoxes = history->last >= 0 && history->l == std::max (l, w)
+              && history->w == std::min (l, w) && history->state.N == N;
+
+  if (sameBoxes && history->L == L_n && history->W == W_n
+      && history->state.normalSetX.size == normalSetX.size
+      && memcmp (history->state.normalSetX.points, normalSetX.points,
+                 normalSetX.size * sizeof (int))
+             == 0)
+    {
+      /* The same normalized problem, on the same tables: its solution
+       * is the one already found. */
+      loadState (&history->state);
+      setTablePool (NULL);
+      *unchanged = 1;
+      return lowerBound[indexX[L_n]][indexY[W_n]];
+    }
+
+  if (sameBoxes)
+    {
+      reuseCells (&history->state);
     }
 
-  delete[] reachedLimit;
-  delete[] solutionDepth;
+  int solution = (numWorkers () > 1 || deterministic ())
+                     ? parallelBD (L_n, W_n, l, w, N)
+                     : BD (L_n, W_n, l, w, N);
+  finishSearch (L_n, W_n, solution);
+
+  /* A cancelled search is not the solution of its problem. */
+  history->last = cancelled () ? -1 : next;
+  saveState (&history->state);
+  history->L = L_n;
+  history->W = W_n;
+  history->l = std::max (l, w);
+  history->w = std::min (l, w);
+  setTablePool (NULL);
 
   return solution;
 }
@@ -25,6 +25,11 @@
 #ifndef BD_H_
 #define BD_H_
 
+#include <stdint.h>
+#include <vector>
+
+#include "draw_bd.h"
+
 /**
  * Guillotine and first order non-guillotine cuts recursive procedure.
  *
@@ -40,4 +45,260 @@
  */
 int solve_BD (int L, int W, int l, int w, int N_max);
 
+/**
+ * Same as solve_BD(), starting the search from a packing of a
+ * neighbouring problem, such as the same boxes on a slightly smaller
+ * pallet.
+ *
+ * Parameters are the same as in solve_BD(), plus:
+ * seed - The packing, as blocks (see Block) in the coordinates of the
+ *        pallet with L >= W, or NULL. If the blocks do not overlap,
+ *        the lower bound of each rectangle (x,y) is raised to the
+ *        boxes of the blocks that fit into [0,x] x [0,y], each one
+ *        packed with the (l,w)-boxes, and the search starts from them.
+ *        The blocks must stay valid until the solution is drawn.
+ */
+int solve_BD (int L, int W, int l, int w, int N_max,
+              const std::vector<Block> *seed);
+
+/**
+ * Same as solve_BD(), keeping for each rectangle up to cuts of the
+ * cuts that pack the most boxes found for it, instead of only the first
+ * one, so that several packings of the pallet with as many boxes can
+ * be drawn (see drawAlternatives()). The search of a rectangle goes on
+ * after its upper bound is reached, until that many cuts reach it as
+ * well, and is not divided among the workers of the pool, so it takes
+ * longer than solve_BD(). At the maximum depth only the pallet is
+ * searched, the other rectangles being packed as their lower bounds
+ * tell, so with N_max <= 0 only the cuts of the pallet are kept.
+ *
+ * Parameters are the same as in solve_BD(), plus:
+ * cuts - Number of cuts kept for each rectangle, at least 1.
+ *
+ * Return:
+ * - the number of (l,w)-boxes packed into (L,W) pallet.
+ */
+int solveAlternatives_BD (int L, int W, int l, int w, int N_max, int cuts);
+
+/**
+ * Solve the problems of packing (l,w)-boxes into several pallets with
+ * Algorithm 1, on tables shared by all of them: their rows and columns
+ * are the union of the raster points of the pallets. The pallets are
+ * solved from the largest to the smallest, so that a smaller pallet
+ * starts from the rectangles solved by the searches of the larger
+ * ones, and is not searched at all when they already packed it
+ * optimally. The tables of the thread are left as after solve_BD(),
+ * with a cell for each pallet.
+ *
+ * Parameters:
+ * count     - Number of pallets.
+ * pallets   - Dimensions of the pallets, as count pairs (L,W).
+ * l         - Length of the boxes.
+ * w         - Width of the boxes.
+ * N_max     - Maximum search depth.
+ * solutions - Receives the number of boxes packed into each pallet.
+ */
+void solveMany_BD (int count, const int *pallets, int l, int w, int N_max,
+                   int *solutions);
+
+/**
+ * Solve the (L,W) pallet again after solve_BD(), with the lower bounds
+ * of the rectangles raised meanwhile by the L-approach, so that the
+ * cuts combine the rectangles packed by it (see CutPoint). The tables
+ * of the thread are the ones left by solve_BD().
+ *
+ * Parameters are the same as in solve_BD(), but the maximum depth.
+ *
+ * Return:
+ * - the number of (l,w)-boxes packed into (L,W) pallet.
+ */
+int refine_BD (int L, int W, int l, int w);
+
+/* Number of boxes packed into every rectangle of a solved pallet: the
+ * answer grid of the pallet. The rectangle (x[i],y[j]) holds at least
+ * count[i * y.size () + j] boxes, and no more if
+ * optimal[i * y.size () + j] is set. The search of the pallet does not
+ * search its rectangles (the maximum depth is reached at the pallet),
+ * so the count of a rectangle that is not optimal is the one of its
+ * homogeneous packings, or of a smaller rectangle, and solving the
+ * rectangle itself may pack more boxes. Since the number of boxes
+ * packed into (a,b) only grows with a and b, a rectangle (a,b) of the
+ * pallet holds at least the count of (x[i],y[j]), for the largest
+ * x[i] <= a and y[j] <= b. */
+struct AnswerGrid
+{
+  std::vector<int> x, y;
+  std::vector<int> count;
+  std::vector<char> optimal;
+};
+
+/**
+ * Store the answer grid of the (L,W) pallet in grid, from the tables
+ * of the thread as left by solve_BD() or refine_BD() for the pallet.
+ * The count of a rectangle is the best one the tables know for it or
+ * for any rectangle that fits into it, a lower bound unless it is
+ * flagged optimal. The count of the pallet is its solution.
+ *
+ * Parameters:
+ * L, W - Dimensions of the pallet, as given to solve_BD().
+ * grid - Receives the answer grid, with x along L and y along W.
+ */
+void grid_BD (int L, int W, AnswerGrid *grid);
+
+/* Last problem solved by resolve_BD(), with its tables. */
+struct BDHistory;
+
+/**
+ * Create an empty history, with table pools of its own.
+ */
+BDHistory *newHistory_BD ();
+
+/**
+ * Free a history and its tables.
+ */
+void deleteHistory_BD (BDHistory *history);
+
+/**
+ * Same as solve_BD(), for a problem usually close to the last one
+ * solved with the history, as when the dimensions of the pallet are
+ * changed a little. If the normalized problem is the same (the same
+ * boxes, normalized pallet and raster points), its tables are the
+ * tables of the thread again and nothing is searched. Otherwise, for
+ * the same boxes, the rectangles of the last problem that also belong
+ * to the new one keep their packings, so the search starts from them
+ * and does not search again the ones packed optimally. Other boxes
+ * change every rectangle, and the problem is solved from scratch. The
+ * tables of the thread are left as after solve_BD(), in the pools of
+ * the history.
+ *
+ * Parameters are the same as in solve_BD(), plus:
+ * history   - The history, which receives the problem.
+ * unchanged - Receives 1 if the normalized problem is the last one,
+ *             0 otherwise.
+ *
+ * Return:
+ * - the number of (l,w)-boxes packed into (L,W) pallet.
+ */
+int resolve_BD (BDHistory *history, int L, int W, int l, int w, int N_max,
+                int *unchanged);
+
+/* Resumable search of solve_BD(). */
+struct BDSearch;
+
+/**
+ * Start the search of solve_BD() without trying any cut. The tables
+ * of the problem are taken from the table pool selected by the thread
+ * (see tables.h) and saved by the search between its steps, so the
+ * thread can solve other problems in the meantime if the search has a
+ * pool of its own.
+ *
+ * Parameters are the same as in solve_BD().
+ *
+ * Return:
+ * - the search, to be ended by finish_BD() or cancel_BD().
+ */
+BDSearch *start_BD (int L, int W, int l, int w, int N_max);
+
+/**
+ * Continue the search, trying about budget cuts of the pallet. The
+ * cuts are tried in groups of at most |Y'|^2, so a step may go
+ * slightly over the budget. The subproblems of a cut are solved within
+ * the step that tries it.
+ *
+ * Return:
+ * - 1 if the search is over, 0 otherwise.
+ */
+int step_BD (BDSearch *search, long budget);
+
+/**
+ * Return the fraction, between 0 and 1, of the cuts already tried.
+ */
+double progress_BD (const BDSearch *search);
+
+/**
+ * Complete the search and free it. The tables of the problem become
+ * the tables of the thread, as after solve_BD().
+ *
+ * Return:
+ * - the number of (l,w)-boxes packed into (L,W) pallet.
+ */
+int finish_BD (BDSearch *search);
+
+/* Checkpoints of a resumable search.
+ *
+ * A checkpoint file holds the search of the root rectangle between two
+ * of its steps: a header, with the problem and the next cuts to try,
+ * followed by the tables lowerBound, upperBound, solutionDepth,
+ * reachedLimit and cutPoints, each one stored as it is in memory, rows
+ * x cols elements in row-major order, at the offsets given by the
+ * header. The file can thus be mapped and its tables read in place.
+ * Integers are stored in the byte order of the machine that wrote the
+ * file; files are rejected on machines of the other order. */
+
+#define CHECKPOINT_MAGIC "PALLETCK"
+#define CHECKPOINT_VERSION 1
+
+struct CheckpointHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t cutPointSize;
+
+  /* Problem given to start_BD(), with L >= W, and its maximum depth. */
+  int32_t L, W, l, w, N;
+
+  /* Dimensions of the tables. */
+  int32_t rows, cols;
+
+  /* Next cuts to try and bounds of the root rectangle. */
+  int32_t phase, index_x1, index_x2, index_y1;
+  int32_t z_lb, z_ub;
+
+  /* Zero, it keeps the fields below aligned. */
+  int32_t reserved;
+
+  /* Number of cuts tried. */
+  int64_t done;
+
+  /* Offsets, in bytes from the beginning of the file, of the tables. */
+  uint64_t lowerBoundOffset;
+  uint64_t upperBoundOffset;
+  uint64_t solutionDepthOffset;
+  uint64_t reachedLimitOffset;
+  uint64_t cutPointsOffset;
+  uint64_t size;
+};
+
+/**
+ * Write a checkpoint of the search to the file at path (see
+ * CheckpointHeader). It must be called between two steps of the
+ * search, which goes on unchanged.
+ *
+ * Return:
+ * - 1 if the checkpoint was written, 0 otherwise.
+ */
+int save_BD (const BDSearch *search, const char *path);
+
+/**
+ * Continue the search of solve_BD() from the checkpoint at path, as
+ * start_BD() does for a new search. The tables are taken from the
+ * table pool selected by the thread.
+ *
+ * Parameters are the same as in start_BD(), plus:
+ * path - Path of the checkpoint, written by save_BD() for the same
+ *        problem.
+ *
+ * Return:
+ * - the search, to be ended by finish_BD() or cancel_BD(), or NULL if
+ *   the file cannot be read or is not a checkpoint of this problem.
+ */
+BDSearch *resume_BD (int L, int W, int l, int w, int N_max,
+                     const char *path);
+
+/**
+ * Stop the search and free it. The tables of the problem become the
+ * tables of the thread, holding the best solution found so far.
+ */
+void cancel_BD (BDSearch *search);
+
 #endif
@@ -0,0 +1,56 @@
+/* Copyright (C) 2007-2016 Rafael Durbano Lobato
+ *
+ * This file is part of Recursive Partitioning Algorithm.
+ *
+ * Recursive Partitioning Algorithm is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Recursive Partitioning Algorithm is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Recursive Partitioning Algorithm. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Contact information:
+ *
+ * Rafael Durbano Lobato <lobato@ime.usp.br>
+ * http://www.ime.usp.br/~lobato/
+ */
+
+#ifndef CANCEL_H_
+#define CANCEL_H_
+
+#include <atomic>
+#include <cstddef>
+
+/* Cancellation token of the problem being solved by this thread, or
+ * NULL. Any thread may request the cancellation by storing a nonzero
+ * value in it. */
+extern __thread std::atomic<int> *cancelToken;
+
+/**
+ * Set the cancellation token polled by the solver on this thread.
+ *
+ * Parameter:
+ * token - The token, or NULL to solve without cancellation.
+ */
+void setCancelToken (std::atomic<int> *token);
+
+/**
+ * Return whether the cancellation of the problem being solved by this
+ * thread was requested. The search loops poll it and, once it is
+ * true, return their best solution so far, which must be discarded.
+ */
+inline bool
+cancelled ()
+{
+  return cancelToken != NULL
+         && cancelToken->load (std::memory_order_relaxed) != 0;
+}
+
+#endif
@@ -22,38 +22,50 @@
  * http://www.ime.usp.br/~lobato/
  */
 
+#include "cancel.h"
+#include "draw.h"
 #include "draw_bd.h"
 #include "util.h"
 
-#include <map>
+#include <algorithm>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
+#include <unordered_map>
 
-extern int l, w;
+extern __thread int l, w;
 
-extern const int **lowerBound, *indexX, *indexY;
+extern __thread const int **lowerBound, *indexX, *indexY;
 
-extern const int *divisionPoint;
-extern const int *solution;
+extern __thread const int *divisionPoint;
+extern __thread const int *solution;
 
-extern std::map<int, int> *solutionMap;
-extern std::map<int, int> *divisionPointMap;
+extern __thread std::unordered_map<int, int> *solutionMap;
+extern __thread std::unordered_map<int, int> *divisionPointMap;
 
-extern const int *normalize;
-extern const int memory_type;
+extern __thread const int *normalize;
+extern __thread const int memory_type;
+extern __thread const int denseSize;
 
-int ret;
-int **ptoRet;
+__thread int ret;
+__thread int **ptoRet;
 
 void drawR (int L, int *q);
 
 /******************************************************************
  ******************************************************************/
 
+/**
+ * Return the index of the L-piece (q0, q1, q2, q3), or -1 if the piece
+ * was discarded (q0 < 0) because it does not fit a box.
+ */
 inline int
 LIndex (int q0, int q1, int q2, int q3)
 {
+  if (q0 < 0)
+    {
+      return -1;
+    }
   return LIndex (q0, q1, q2, q3, memory_type);
 }
 
@@ -374,7 +386,7 @@ drawB1 (int L, int *q)
   int start, end;
   int div[2];
 
-  if (memory_type == MEM_TYPE_4)
+  if (L < denseSize)
     {
       div[0] = divisionPoint[L] & ptoDiv1;
       div[1] = (divisionPoint[L] & ptoDiv2) >> descPtoDiv2;
@@ -382,8 +394,9 @@ drawB1 (int L, int *q)
   else
     {
       int h = getKey (q[0], q[1], q[2], q[3], memory_type);
-      div[0] = divisionPointMap[L][h] & ptoDiv1;
-      div[1] = (divisionPointMap[L][h] & ptoDiv2) >> descPtoDiv2;
+      int point = divisionPointMap[L - denseSize][h];
+      div[0] = point & ptoDiv1;
+      div[1] = (point & ptoDiv2) >> descPtoDiv2;
     }
 
   standardPositionB1 (div, q, q1, q2);
@@ -497,7 +510,7 @@ drawB2 (int L, int *q)
   int start, end;
   int div[3];
 
-  if (memory_type == MEM_TYPE_4)
+  if (L < denseSize)
     {
       div[0] = divisionPoint[L] & ptoDiv1;
       div[1] = (divisionPoint[L] & ptoDiv2) >> descPtoDiv2;
@@ -505,8 +518,9 @@ drawB2 (int L, int *q)
   else
     {
       int h = getKey (q[0], q[1], q[2], q[3], memory_type);
-      div[0] = divisionPointMap[L][h] & ptoDiv1;
-      div[1] = (divisionPointMap[L][h] & ptoDiv2) >> descPtoDiv2;
+      int point = divisionPointMap[L - denseSize][h];
+      div[0] = point & ptoDiv1;
+      div[1] = (point & ptoDiv2) >> descPtoDiv2;
     }
 
   standardPositionB2 (div, q, q1, q2);
@@ -608,7 +622,7 @@ drawB3 (int L, int *q)
   int start, end;
   int div[2];
 
-  if (memory_type == MEM_TYPE_4)
+  if (L < denseSize)
     {
       div[0] = divisionPoint[L] & ptoDiv1;
       div[1] = (divisionPoint[L] & ptoDiv2) >> descPtoDiv2;
@@ -616,8 +630,9 @@ drawB3 (int L, int *q)
   else
     {
       int h = getKey (q[0], q[1], q[2], q[3], memory_type);
-      div[0] = divisionPointMap[L][h] & ptoDiv1;
-      div[1] = (divisionPointMap[L][h] & ptoDiv2) >> descPtoDiv2;
+      int point = divisionPointMap[L - denseSize][h];
+      div[0] = point & ptoDiv1;
+      div[1] = (point & ptoDiv2) >> descPtoDiv2;
     }
 
   standardPositionB3 (div, q, q1, q2);
@@ -705,7 +720,7 @@ drawB4 (int L, int *q)
   int start, end;
   int div[2];
 
-  if (memory_type == MEM_TYPE_4)
+  if (L < denseSize)
     {
       div[0] = divisionPoint[L] & ptoDiv1;
       div[1] = (divisionPoint[L] & ptoDiv2) >> descPtoDiv2;
@@ -713,8 +728,9 @@ drawB4 (int L, int *q)
   else
     {
       int h = getKey (q[0], q[1], q[2], q[3], memory_type);
-      div[0] = divisionPointMap[L][h] & ptoDiv1;
-      div[1] = (divisionPointMap[L][h] & ptoDiv2) >> descPtoDiv2;
+      int point = divisionPointMap[L - denseSize][h];
+      div[0] = point & ptoDiv1;
+      div[1] = (point & ptoDiv2) >> descPtoDiv2;
     }
 
   standardPositionB4 (div, q, q1, q2);
@@ -816,7 +832,7 @@ drawB5 (int L, int *q)
   int start, end;
   int div[2];
 
-  if (memory_type == MEM_TYPE_4)
+  if (L < denseSize)
     {
       div[0] = divisionPoint[L] & ptoDiv1;
       div[1] = (divisionPoint[L] & ptoDiv2) >> descPtoDiv2;
@@ -824,8 +840,9 @@ drawB5 (int L, int *q)
   else
     {
       int h = getKey (q[0], q[1], q[2], q[3], memory_type);
-      div[0] = divisionPointMap[L][h] & ptoDiv1;
-      div[1] = (divisionPointMap[L][h] & ptoDiv2) >> descPtoDiv2;
+      int point = divisionPointMap[L - denseSize][h];
+      div[0] = point & ptoDiv1;
+      div[1] = (point & ptoDiv2) >> descPtoDiv2;
     }
 
   standardPositionB5 (div, q, q1, q2);
@@ -937,7 +954,7 @@ drawB6 (int L, int *q)
   int start, end;
   int div[3];
 
-  if (memory_type == MEM_TYPE_4)
+  if (L < denseSize)
     {
       div[0] = divisionPoint[L] & ptoDiv1;
       div[1] = (divisionPoint[L] & ptoDiv2) >> descPtoDiv2;
@@ -946,9 +963,10 @@ drawB6 (int L, int *q)
   else
     {
       int h = getKey (q[0], q[1], q[2], q[3], memory_type);
-      div[0] = divisionPointMap[L][h] & ptoDiv1;
-      div[1] = (divisionPointMap[L][h] & ptoDiv2) >> descPtoDiv2;
-      div[2] = (divisionPointMap[L][h] & ptoDiv3) >> descPtoDiv3;
+      int point = divisionPointMap[L - denseSize][h];
+      div[0] = point & ptoDiv1;
+      div[1] = (point & ptoDiv2) >> descPtoDiv2;
+      div[2] = (point & ptoDiv3) >> descPtoDiv3;
     }
 
   standardPositionB6 (div, q, q1, q2);
@@ -1060,7 +1078,7 @@ drawB7 (int L, int *q)
   int start, end;
   int div[3];
 
-  if (memory_type == MEM_TYPE_4)
+  if (L < denseSize)
     {
       div[0] = divisionPoint[L] & ptoDiv1;
       div[1] = (divisionPoint[L] & ptoDiv2) >> descPtoDiv2;
@@ -1069,9 +1087,10 @@ drawB7 (int L, int *q)
   else
     {
       int h = getKey (q[0], q[1], q[2], q[3], memory_type);
-      div[0] = divisionPointMap[L][h] & ptoDiv1;
-      div[1] = (divisionPointMap[L][h] & ptoDiv2) >> descPtoDiv2;
-      div[2] = (divisionPointMap[L][h] & ptoDiv3) >> descPtoDiv3;
+      int point = divisionPointMap[L - denseSize][h];
+      div[0] = point & ptoDiv1;
+      div[1] = (point & ptoDiv2) >> descPtoDiv2;
+      div[2] = (point & ptoDiv3) >> descPtoDiv3;
     }
 
   standardPositionB7 (div, q, q1, q2);
@@ -1183,7 +1202,7 @@ drawB8 (int L_index, int *q)
   int start, end;
   int div[2];
 
-  if (memory_type == MEM_TYPE_4)
+  if (L_index < denseSize)
     {
       div[0] = divisionPoint[L_index] & ptoDiv1;
       div[1] = (divisionPoint[L_index] & ptoDiv2) >> descPtoDiv2;
@@ -1191,8 +1210,9 @@ drawB8 (int L_index, int *q)
   else
     {
       int h = getKey (q[0], q[1], q[2], q[3], memory_type);
-      div[0] = divisionPointMap[L_index][h] & ptoDiv1;
-      div[1] = (divisionPointMap[L_index][h] & ptoDiv2) >> descPtoDiv2;
+      int point = divisionPointMap[L_index - denseSize][h];
+      div[0] = point & ptoDiv1;
+      div[1] = (point & ptoDiv2) >> descPtoDiv2;
     }
 
   standardPositionB8 (div, q, q1, q2);
@@ -1294,7 +1314,7 @@ drawB9 (int L_index, int *q)
   int start, end;
   int div[2];
 
-  if (memory_type == MEM_TYPE_4)
+  if (L_index < denseSize)
     {
       div[0] = divisionPoint[L_index] & ptoDiv1;
       div[1] = (divisionPoint[L_index] & ptoDiv2) >> descPtoDiv2;
@@ -1302,8 +1322,9 @@ drawB9 (int L_index, int *q)
   else
     {
       int h = getKey (q[0], q[1], q[2], q[3], memory_type);
-      div[0] = divisionPointMap[L_index][h] & ptoDiv1;
-      div[1] = (divisionPointMap[L_index][h] & ptoDiv2) >> descPtoDiv2;
+      int point = divisionPointMap[L_index - denseSize][h];
+      div[0] = point & ptoDiv1;
+      div[1] = (point & ptoDiv2) >> descPtoDiv2;
     }
 
   standardPositionB9 (div, q, q1, q2);
@@ -1399,14 +1420,31 @@ drawR (int L, int *q)
   int start, end;
   int divisionType;
 
-  if (memory_type == MEM_TYPE_4)
+  if (cancelled () || L < 0)
+    {
+      return;
+    }
+
+  /* The pieces that were not solved, whose lower bounds are part of
+   * the solution of the others, are packed as their lower bounds. */
+  if (L < denseSize)
     {
-      divisionType = (solution[L] & solucao) >> descSol;
+      divisionType = HOMOGENEOUS;
+      if (solution[L] != -1)
+        {
+          divisionType = (solution[L] & solucao) >> descSol;
+        }
     }
   else
     {
       int h = getKey (q[0], q[1], q[2], q[3], memory_type);
-      divisionType = (solutionMap[L][h] & solucao) >> descSol;
+      std::unordered_map<int, int>::const_iterator it
+          = solutionMap[L - denseSize].find (h);
+      divisionType = HOMOGENEOUS;
+      if (it != solutionMap[L - denseSize].end ())
+        {
+          divisionType = (it->second & solucao) >> descSol;
+        }
     }
 
   switch (divisionType)
@@ -1485,35 +1523,60 @@ drawR (int L, int *q)
 /******************************************************************
  ******************************************************************/
 
-std::string
-MakeJsonString (int Lo, int Wo, int L, int *q, int n, int l, int w, bool swap)
+int
+drawLRectangle (int x, int y, int start)
+{
+  int q[4] = { x, y, x, y };
+
+  ret = start;
+  drawR (LIndex (x, y, x, y), q);
+  return ret;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Compute the center of the box i of ptoRet and whether it is rotated,
+ * in the coordinates of the original pallet.
+ */
+static void
+boxPosition (int i, int l, int w, bool swap, float *px, float *py,
+             bool *rotated)
 {
-  std::string str = "[";;
   float x, y;
   float xl, yl, xh, yh;
-  bool rotated = true;
   int sym = 0 == l - w;
   int cmp = swap ? l : w;
-  if (sym)
-    rotated = false;
+
+  *rotated = !sym && 0 != ptoRet[i][3] - ptoRet[i][1] - cmp;
+
+  xh = (float)ptoRet[i][0];
+  yh = (float)ptoRet[i][1];
+  xl = (float)ptoRet[i][2];
+  yl = (float)ptoRet[i][3];
+  x = (xl - xh) / 2.0 + xh;
+  y = (yl - yh) / 2.0 + yh;
+
+  *px = swap ? x : y;
+  *py = swap ? y : x;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+std::string
+MakeJsonString (int Lo, int Wo, int L, int *q, int n, int l, int w, bool swap)
+{
+  std::string str = "[";;
+  float x, y;
+  bool rotated;
 
   printf ("[");
   for (int i = 0; i < n; i++) {
-    if (!sym)
-      {
-        if (sym || 0 == ptoRet[i][3] - ptoRet[i][1] - cmp)
-          rotated = false;
-        else
-          rotated = true;
-      }
-    xh = (float)ptoRet[i][0];
-    yh = (float)ptoRet[i][1];
-    xl = (float)ptoRet[i][2];
-    yl = (float)ptoRet[i][3];
-    x = (xl - xh) / 2.0 + xh;
-    y = (yl - yh) / 2.0 + yh;
-
-    str += "{\"x\": " +  std::to_string(swap ? x : y) + ", \"y\": " + std::to_string(swap ? y : x) + ", \"rotated\": " + (rotated ? "true" : "false") + "}";
+    boxPosition (i, l, w, swap, &x, &y, &rotated);
+
+    str += "{\"x\": " +  std::to_string(x) + ", \"y\": " + std::to_string(y) + ", \"rotated\": " + (rotated ? "true" : "false") + "}";
     if (i + 1 != n) {
       str += ",\n";
     }
@@ -1526,10 +1589,30 @@ MakeJsonString (int Lo, int Wo, int L, int *q, int n, int l, int w, bool swap)
 /******************************************************************
  ******************************************************************/
 
-std::string
-draw (int Lo, int Wo, int L, int *q, int n, bool solvedWithL, int l, int w,
-      bool swap)
+/**
+ * Return the most boxes a solution of n boxes of the rectangle q may
+ * place when it was found by the L-approach: no packing has more boxes
+ * than fit in its area.
+ */
+int
+maxBoxes (int *q, int n)
 {
+  return std::max (n, q[0] * q[1] / (l * w));
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/* Number of boxes ptoRet has room for. */
+static __thread int allocatedBoxes;
+
+/**
+ * Allocate ptoRet for n boxes.
+ */
+static void
+allocateSolution (int n)
+{
+  allocatedBoxes = n;
   ptoRet = (int **)malloc ((n) * sizeof (int *));
   if (ptoRet == NULL)
     {
@@ -1546,22 +1629,114 @@ draw (int Lo, int Wo, int L, int *q, int n, bool solvedWithL, int l, int w,
           exit (0);
         }
     }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Place the n boxes of the solution in ptoRet. The rectangles packed
+ * by the L-approach are drawn from the memory of the L-pieces (see
+ * drawLRectangle()). The lower bounds of the rectangles in the
+ * solutions of the L-pieces may have been raised after they were
+ * solved, so the pattern of a solution of the L-approach may have more
+ * than n boxes.
+ *
+ * Return:
+ * - the number of boxes placed.
+ */
+static int
+drawSolution (int L, int *q, int n, bool solvedWithL)
+{
+  allocateSolution (solvedWithL ? maxBoxes (q, n) : n);
+
+  ret = drawBD (q[0], q[1], 0);
+  return ret;
+}
 
-  ret = 0;
-  if (solvedWithL)
+/******************************************************************
+ ******************************************************************/
+
+static void
+freeSolution ()
+{
+  for (int i = 0; i < allocatedBoxes; i++)
+    free (ptoRet[i]);
+  free (ptoRet);
+  ptoRet = NULL;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+std::string
+draw (int Lo, int Wo, int L, int *q, int n, bool solvedWithL, int l, int w,
+      bool swap)
+{
+  std::string result;
+
+  n = drawSolution (L, q, n, solvedWithL);
+  if (!cancelled ())
     {
-      drawR (L, q);
+      result = MakeJsonString (Lo, Wo, L, q, n, l, w, swap);
     }
-  else
+  freeSolution ();
+
+  return result;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+drawPositions (int Lo, int Wo, int L, int *q, int n, bool solvedWithL, int l,
+               int w, bool swap, float *positions)
+{
+  bool rotated;
+
+  n = drawSolution (L, q, n, solvedWithL);
+  for (int i = 0; i < n && !cancelled (); i++)
     {
-      ret = drawBD (q[0], q[1], ret);
+      boxPosition (i, l, w, swap, &positions[3 * i], &positions[3 * i + 1],
+                   &rotated);
+      positions[3 * i + 2] = rotated ? 1.0f : 0.0f;
     }
+  freeSolution ();
+  return n;
+}
 
-  std::string result = MakeJsonString (Lo, Wo, L, q, n, l, w, swap);
+/******************************************************************
+ ******************************************************************/
 
-  // for (int i = 0; i < n; i++)
-  //   free (ptoRet[i]);
-  free (ptoRet);
+std::string
+draw (const std::vector<Block> &blocks, int n, int l, int w, bool swap)
+{
+  std::string result;
+
+  allocateSolution (n);
+  drawBlocks (blocks, 0);
+  result = MakeJsonString (0, 0, 0, NULL, n, l, w, swap);
+  freeSolution ();
 
   return result;
 }
+
+/******************************************************************
+ ******************************************************************/
+
+void
+drawPositions (const std::vector<Block> &blocks, int n, int l, int w,
+               bool swap, float *positions)
+{
+  bool rotated;
+
+  allocateSolution (n);
+  drawBlocks (blocks, 0);
+  for (int i = 0; i < n; i++)
+    {
+      boxPosition (i, l, w, swap, &positions[3 * i], &positions[3 * i + 1],
+                   &rotated);
+      positions[3 * i + 2] = rotated ? 1.0f : 0.0f;
+    }
+  freeSolution ();
+}
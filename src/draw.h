@@ -26,8 +26,55 @@
 #define DRAW_H_
 
 #include <string>
+#include <vector>
 
+#include "draw_bd.h"
+
+/**
+ * Return the most boxes that draw() and drawPositions() place for a
+ * solution of n boxes of the rectangle q found by solve_L().
+ */
+int maxBoxes (int *q, int n);
+
+/**
+ * Return the boxes of the solution as a JSON array, or an empty string
+ * if the cancellation of the problem was requested (see cancel.h).
+ * solvedWithL tells that the solution was found by solve_L(), whose
+ * tables of the L-pieces pack some of the rectangles. Such a solution
+ * may place more than n boxes (see maxBoxes()), and all of them are
+ * drawn.
+ */
 std::string draw (int Lo, int Wo, int L, int *q, int n, bool solvedWithL, int l,
            int w, bool swap);
 
+/**
+ * Same as draw, but store the center and orientation of each box in
+ * positions, as the triples {x, y, rotated}, rotated being 1 or 0.
+ * The positions are not meaningful if the cancellation of the problem
+ * was requested.
+ *
+ * Parameters:
+ * positions - Array with room for 3 * n floats, or 3 * maxBoxes(q, n)
+ *             if solvedWithL.
+ *
+ * Return:
+ * - the number of boxes placed.
+ */
+int drawPositions (int Lo, int Wo, int L, int *q, int n, bool solvedWithL,
+                   int l, int w, bool swap, float *positions);
+
+/**
+ * Same as draw, but for a solution given by the n boxes of its blocks
+ * (see drawBlocks()), without the tables of the solver.
+ */
+std::string draw (const std::vector<Block> &blocks, int n, int l, int w,
+                  bool swap);
+
+/**
+ * Same as drawPositions, but for a solution given by the n boxes of
+ * its blocks.
+ */
+void drawPositions (const std::vector<Block> &blocks, int n, int l, int w,
+                    bool swap, float *positions);
+
 #endif
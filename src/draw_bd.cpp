@@ -22,20 +22,48 @@
  * http://www.ime.usp.br/~lobato/
  */
 
+#include "cancel.h"
+#include "draw_bd.h"
 #include "util.h"
 #include <algorithm>
+#include <deque>
+#include <set>
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
 void draw (int L, int W, int dx, int dy);
 
-extern const CutPoint **cutPoints;
-extern const int *normalize;
-extern const int *indexX, *indexY;
-extern int **ptoRet;
-extern const int l, w;
+extern __thread const CutPoint **cutPoints;
+extern __thread const int *normalize;
+extern __thread const int *indexX, *indexY;
+extern __thread int **ptoRet;
+extern __thread const int l, w;
+extern __thread const std::vector<Block> *seedBlocks;
+extern __thread int maxAlternatives;
+extern __thread const CutPoint *alternatives;
+extern __thread const int **numAlternatives;
+extern __thread int sizeY;
+
+__thread int boxesDrawn = 0;
+
+/* If not NULL, the blocks drawn are stored here instead of their
+ * boxes (see drawBlocks()). */
+static __thread std::vector<Block> *blocksDrawn = NULL;
 
-int boxesDrawn = 0;
+/* If not NULL, the packing drawn is the alternative given by these
+ * choices (see drawAlternatives()): the choice i, taken at the i-th
+ * rectangle drawn that can be packed in choiceCounts[i] ways. */
+static __thread std::vector<int> *choices = NULL;
+static __thread std::vector<int> *choiceCounts;
+static __thread size_t nextChoice;
+
+/* Number of packings drawn by drawAlternatives() for each one that it
+ * returns, at most. */
+#define DRAWS_PER_ALTERNATIVE 8
 
 /******************************************************************
  ******************************************************************/
@@ -60,39 +88,187 @@ boxOrientation (int x, int y)
 /******************************************************************
  ******************************************************************/
 
+/**
+ * Take the next choice of the alternative packing drawn, among count
+ * ways of packing a rectangle.
+ *
+ * Return:
+ * - the way chosen, 0 for the one of the solution.
+ */
+static int
+choose (int count)
+{
+  if (choices == NULL || count <= 1)
+    {
+      return 0;
+    }
+  if (nextChoice == choices->size ())
+    {
+      choices->push_back (0);
+    }
+  choiceCounts->push_back (count);
+  return (*choices)[nextChoice++];
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Return the cut of the rectangle (iX,iY) to draw: the one of
+ * cutPoints or, in an alternative packing, one of the cuts kept for
+ * the rectangle.
+ */
+static const CutPoint &
+chooseCut (int iX, int iY)
+{
+  const CutPoint &cut = cutPoints[iX][iY];
+
+  if (choices == NULL || maxAlternatives == 0 || cut.lApproach || cut.seed)
+    {
+      return cut;
+    }
+
+  int i = choose (1 + numAlternatives[iX][iY]);
+  if (i == 0)
+    {
+      return cut;
+    }
+  return alternatives[((size_t)iX * sizeY + iY) * maxAlternatives + i - 1];
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Draw the boxes of an homogeneous packing of (x,y) translated by
+ * (dx,dy), with their sides (a,b) along the axes.
+ */
 void
-drawHomogeneous (int x, int y, int dx, int dy)
+drawGrid (int x, int y, int dx, int dy, int a, int b)
 {
   int i, j;
+
+#ifdef __wasm_simd128__
+  /* Each box is {i, j, i + a, j + b} + {dx, dy, dx, dy}, so the four
+   * coordinates are written by a single store. */
+  v128_t box = wasm_i32x4_make (dx, dy, a + dx, b + dy);
+  v128_t stepX = wasm_i32x4_make (a, 0, a, 0);
+  v128_t stepY = wasm_i32x4_make (0, b, 0, b);
+
+  for (i = 0; i + a <= x; i += a)
+    {
+      v128_t column = box;
+      for (j = 0; j + b <= y; j += b)
+        {
+          wasm_v128_store (ptoRet[boxesDrawn], column);
+          column = wasm_i32x4_add (column, stepY);
+          boxesDrawn++;
+        }
+      box = wasm_i32x4_add (box, stepX);
+    }
+#else
+  for (i = 0; i + a <= x; i += a)
+    {
+      for (j = 0; j + b <= y; j += b)
+        {
+          ptoRet[boxesDrawn][0] = i + dx;
+          ptoRet[boxesDrawn][1] = j + dy;
+          ptoRet[boxesDrawn][2] = i + a + dx;
+          ptoRet[boxesDrawn][3] = j + b + dy;
+          boxesDrawn++;
+        }
+    }
+#endif
+}
+
+/******************************************************************
+ ******************************************************************/
+
+void
+drawHomogeneous (int x, int y, int dx, int dy)
+{
   short corte = boxOrientation (x, y);
 
+  /* In an alternative packing, the boxes may be turned when they fit
+   * as many times both ways. */
+  if (choices != NULL && l != w && (x / l) * (y / w) == (x / w) * (y / l)
+      && (x / l) * (y / w) > 0 && choose (2))
+    {
+      corte = (corte == HORIZONTAL) ? VERTICAL : HORIZONTAL;
+    }
+
+  if (blocksDrawn != NULL)
+    {
+      Block block = { x, y, dx, dy, corte != HORIZONTAL };
+      blocksDrawn->push_back (block);
+      boxesDrawn += corte == HORIZONTAL ? (x / l) * (y / w) : (x / w) * (y / l);
+      return;
+    }
+
   if (corte == HORIZONTAL)
     {
-      for (i = 0; i + l <= x; i += l)
+      drawGrid (x, y, dx, dy, l, w);
+    }
+
+  else
+    {
+      drawGrid (x, y, dx, dy, w, l);
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Draw the boxes of the rectangle (L,W), L >= W, packed by the
+ * L-approach, translated by (dx,dy) and transposed if rotated.
+ */
+void
+drawLApproach (int L, int W, int dx, int dy, bool rotated)
+{
+  int start = boxesDrawn;
+
+  boxesDrawn = drawLRectangle (L, W, boxesDrawn);
+  for (int i = start; i < boxesDrawn; i++)
+    {
+      if (rotated)
         {
-          for (j = 0; j + w <= y; j += w)
-            {
-              ptoRet[boxesDrawn][0] = i + dx;
-              ptoRet[boxesDrawn][1] = j + dy;
-              ptoRet[boxesDrawn][2] = i + l + dx;
-              ptoRet[boxesDrawn][3] = j + w + dy;
-              boxesDrawn++;
-            }
+          std::swap (ptoRet[i][0], ptoRet[i][1]);
+          std::swap (ptoRet[i][2], ptoRet[i][3]);
         }
+      ptoRet[i][0] += dx;
+      ptoRet[i][1] += dy;
+      ptoRet[i][2] += dx;
+      ptoRet[i][3] += dy;
     }
+}
 
-  else
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Draw the blocks of the seed of the search that fit into the
+ * rectangle (L,W), L >= W, translated by (dx,dy) and transposed if
+ * rotated.
+ */
+void
+drawSeed (int L, int W, int dx, int dy, bool rotated)
+{
+  for (size_t i = 0; i < seedBlocks->size (); i++)
     {
-      for (i = 0; i + w <= x; i += w)
+      const Block &b = (*seedBlocks)[i];
+
+      if (b.dx + b.x > L || b.dy + b.y > W)
         {
-          for (j = 0; j + l <= y; j += l)
-            {
-              ptoRet[boxesDrawn][0] = i + dx;
-              ptoRet[boxesDrawn][1] = j + dy;
-              ptoRet[boxesDrawn][2] = i + w + dx;
-              ptoRet[boxesDrawn][3] = j + l + dy;
-              boxesDrawn++;
-            }
+          continue;
+        }
+      if (rotated)
+        {
+          drawHomogeneous (b.y, b.x, dx + b.dy, dy + b.dx);
+        }
+      else
+        {
+          drawHomogeneous (b.x, b.y, dx + b.dx, dy + b.dy);
         }
     }
 }
@@ -134,14 +310,28 @@ drawRotation (int L, int W, int dx, int dy)
   iX = indexX[L];
   iY = indexY[W];
 
-  if (cutPoints[iX][iY].homogeneous)
+  const CutPoint &cut = chooseCut (iX, iY);
+
+  if (cut.lApproach)
+    {
+      drawLApproach (L, W, dx, dy, true);
+      return;
+    }
+
+  if (cut.seed)
+    {
+      drawSeed (L, W, dx, dy, true);
+      return;
+    }
+
+  if (cut.homogeneous)
     {
       std::swap (L, W);
       drawHomogeneous (L, W, dx, dy);
       return;
     }
 
-  getSubproblems (cutPoints[iX][iY], L_, W_, L, W);
+  getSubproblems (cut, L_, W_, L, W);
 
   for (i = 1; i <= 5; i++)
     {
@@ -184,13 +374,27 @@ drawNormal (int L, int W, int dx, int dy)
   int iX = indexX[L];
   int iY = indexY[W];
 
-  if (cutPoints[iX][iY].homogeneous)
+  const CutPoint &cut = chooseCut (iX, iY);
+
+  if (cut.lApproach)
+    {
+      drawLApproach (L, W, dx, dy, false);
+      return;
+    }
+
+  if (cut.seed)
+    {
+      drawSeed (L, W, dx, dy, false);
+      return;
+    }
+
+  if (cut.homogeneous)
     {
       drawHomogeneous (L, W, dx, dy);
       return;
     }
 
-  getSubproblems (cutPoints[iX][iY], L_, W_, L, W);
+  getSubproblems (cut, L_, W_, L, W);
 
   for (i = 1; i <= 5; i++)
     {
@@ -225,6 +429,11 @@ drawNormal (int L, int W, int dx, int dy)
 void
 draw (int L, int W, int dx, int dy)
 {
+  if (cancelled ())
+    {
+      return;
+    }
+
   if (L >= W)
     {
       drawNormal (L, W, dx, dy);
@@ -235,6 +444,9 @@ draw (int L, int W, int dx, int dy)
     }
 }
 
+/******************************************************************
+ ******************************************************************/
+
 int
 drawBD (int L, int W, int ret)
 {
@@ -242,3 +454,133 @@ drawBD (int L, int W, int ret)
   draw (L, W, 0, 0);
   return boxesDrawn;
 }
+
+/******************************************************************
+ ******************************************************************/
+
+int
+drawBlocks (int L, int W, std::vector<Block> *blocks)
+{
+  blocks->clear ();
+  blocksDrawn = blocks;
+  boxesDrawn = 0;
+  draw (L, W, 0, 0);
+  blocksDrawn = NULL;
+  return boxesDrawn;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+drawBlocks (const std::vector<Block> &blocks, int ret)
+{
+  boxesDrawn = ret;
+  for (size_t i = 0; i < blocks.size (); i++)
+    {
+      const Block &b = blocks[i];
+      if (b.rotated)
+        {
+          drawGrid (b.x, b.y, b.dx, b.dy, w, l);
+        }
+      else
+        {
+          drawGrid (b.x, b.y, b.dx, b.dy, l, w);
+        }
+    }
+  return boxesDrawn;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Return the boxes of the blocks, as the sorted codes of their
+ * corners and orientations, which tell whether two packings are the
+ * same.
+ */
+static std::vector<long long>
+boxesOf (const std::vector<Block> &blocks)
+{
+  std::vector<long long> boxes;
+
+  for (size_t i = 0; i < blocks.size (); i++)
+    {
+      const Block &b = blocks[i];
+      int a = b.rotated ? w : l;
+      int c = b.rotated ? l : w;
+
+      for (int x = 0; x + a <= b.x; x += a)
+        {
+          for (int y = 0; y + c <= b.y; y += c)
+            {
+              boxes.push_back (((long long)(b.dx + x) << 32)
+                               | ((long long)(b.dy + y) << 1) | b.rotated);
+            }
+        }
+    }
+  std::sort (boxes.begin (), boxes.end ());
+  return boxes;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+drawAlternatives (int L, int W, int count,
+                  std::vector<std::vector<Block> > *patterns)
+{
+  /* The choices of the packings to draw. The children of a packing
+   * differ from it in one choice taken after its last one that is not
+   * 0, so every packing has a single parent and is drawn once, and the
+   * packings closer to the solution are drawn first. */
+  std::deque<std::vector<int> > queue (1);
+  std::set<std::vector<long long> > drawn;
+  std::vector<int> counts;
+  std::vector<Block> blocks;
+  int boxes = -1;
+  int draws = 0;
+
+  patterns->clear ();
+  while (!queue.empty () && (int)patterns->size () < count
+         && draws < DRAWS_PER_ALTERNATIVE * count && !cancelled ())
+    {
+      std::vector<int> sequence = queue.front ();
+      queue.pop_front ();
+
+      size_t last = sequence.size ();
+      counts.clear ();
+      choices = &sequence;
+      choiceCounts = &counts;
+      nextChoice = 0;
+      int n = drawBlocks (L, W, &blocks);
+      choices = NULL;
+      draws++;
+
+      if (boxes < 0)
+        {
+          boxes = n;
+        }
+      if (n == boxes && drawn.insert (boxesOf (blocks)).second)
+        {
+          patterns->push_back (blocks);
+        }
+
+      /* choose() completed the sequence with the choices taken. */
+      for (size_t i = last; i < counts.size (); i++)
+        {
+          for (int j = 1; j < counts[i]
+                          && (int)queue.size () < DRAWS_PER_ALTERNATIVE
+                                                      * count;
+               j++)
+            {
+              std::vector<int> child (sequence.begin (),
+                                      sequence.begin () + i);
+              child.push_back (j);
+              queue.push_back (child);
+            }
+        }
+    }
+
+  return boxes;
+}
@@ -22,8 +22,19 @@
  * http://www.ime.usp.br/~lobato/
  */
 
-#ifndef DRAW_H_
-#define DRAW_H_
+#ifndef DRAW_BD_H_
+#define DRAW_BD_H_
+
+#include <vector>
+
+/* Homogeneous packing of the rectangle (x,y) translated by (dx,dy):
+ * a leaf of the cut tree of a solution. The boxes have their sides
+ * (w,l) along the axes if rotated is set, (l,w) otherwise. */
+struct Block
+{
+  int x, y, dx, dy;
+  bool rotated;
+};
 
 /**
  * Determine the orientation of the boxes (l,w) that maximize the
@@ -38,4 +49,48 @@ short boxOrientation (int x, int y);
 
 int drawBD (int L, int W, int ret);
 
+/**
+ * Draw the boxes of the rectangle (x,y), x >= y, as packed by the
+ * solution of the L-approach in the memory of the L-pieces, in ptoRet
+ * from the index start on (see draw.cpp). drawBD() draws so the
+ * rectangles whose CutPoint has lApproach set.
+ *
+ * Return:
+ * - the index that follows the last box drawn.
+ */
+int drawLRectangle (int x, int y, int start);
+
+/**
+ * Store the leaves of the cut tree of the solution of (L,W) found by
+ * Algorithm 1 in blocks, in the order in which drawBD() draws them,
+ * instead of drawing the boxes.
+ *
+ * Return:
+ * - the number of boxes of the blocks.
+ */
+int drawBlocks (int L, int W, std::vector<Block> *blocks);
+
+/**
+ * Store in patterns the leaves of up to count distinct packings of
+ * (L,W) with as many boxes as its solution, as drawBlocks() does for
+ * the solution, which is the first one. The others take, for some
+ * rectangles of the cut tree, one of the other cuts kept for them by
+ * solveAlternatives_BD() (see bd.h) or, for some homogeneous packings,
+ * the boxes turned when they fit as many times both ways. The packings
+ * that differ from the solution in fewer rectangles come first.
+ *
+ * Return:
+ * - the number of boxes of each packing.
+ */
+int drawAlternatives (int L, int W, int count,
+                      std::vector<std::vector<Block> > *patterns);
+
+/**
+ * Draw the boxes of the blocks, from the box ret on.
+ *
+ * Return:
+ * - the number of boxes drawn so far.
+ */
+int drawBlocks (const std::vector<Block> &blocks, int ret);
+
 #endif
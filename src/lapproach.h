@@ -0,0 +1,66 @@
+/* Copyright (C) 2007-2016 Rafael Durbano Lobato
+ *
+ * This file is part of Recursive Partitioning Algorithm.
+ *
+ * Recursive Partitioning Algorithm is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Recursive Partitioning Algorithm is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Recursive Partitioning Algorithm. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Contact information:
+ *
+ * Rafael Durbano Lobato <lobato@ime.usp.br>
+ * http://www.ime.usp.br/~lobato/
+ */
+
+
+#ifndef LAPPROACH_H_
+#define LAPPROACH_H_
+
+#include <vector>
+
+/**
+ * Solve the problem of packing (l,w)-boxes into the (L,W) pallet with
+ * the L-approach (recursive partitioning into L-shaped pieces), after
+ * bounding the rectangles with Algorithm 1. Algorithm 1 then solves
+ * the pallet again, combining in its cuts the rectangles that the
+ * L-approach packed better (see refine_BD()). The tables of the
+ * L-pieces are allocated and freed by each call. The L-pieces are
+ * solved by the threads of the pool (see setNumWorkers()) when their
+ * tables fit in an array, with the same number of boxes as on a single
+ * thread. The boxes are placed the same way too in the deterministic
+ * mode (see setDeterministic()), where the rectangles raised for
+ * Algorithm 1 are only those of the pattern of the pallet.
+ *
+ * Parameters:
+ * L, W   - Dimensions of the pallet.
+ * l, w   - Dimensions of the boxes.
+ * pieces - Receives the number of L-pieces solved (not found in the
+ *          tables of the L-pieces already solved).
+ *
+ * Return:
+ * - the number of boxes packed, or -1 if some dimension is invalid.
+ */
+int solve_L (int L, int W, int l, int w, long *pieces);
+
+/**
+ * Same as solve_L(), but also place the boxes of the solution, before
+ * the tables of the L-pieces are freed: positions receives the center
+ * and orientation of each box as the triples {x, y, rotated} of
+ * drawPositions() (see draw.h), unless the problem was cancelled. The
+ * boxes placed may be more than those of the bounds of the tables, and
+ * then their number is returned.
+ */
+int solve_L (int L, int W, int l, int w, long *pieces,
+             std::vector<float> *positions);
+
+#endif
@@ -0,0 +1,418 @@
+/* Copyright (C) 2007-2016 Rafael Durbano Lobato
+ *
+ * This file is part of Recursive Partitioning Algorithm.
+ *
+ * Recursive Partitioning Algorithm is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Recursive Partitioning Algorithm is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Recursive Partitioning Algorithm. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Contact information:
+ *
+ * Rafael Durbano Lobato <lobato@ime.usp.br>
+ * http://www.ime.usp.br/~lobato/
+ */
+
+
+#include "lookup.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+struct SolutionTable
+{
+  const unsigned char *data;
+  size_t size;
+  const TableHeader *header;
+  const TableEntry *entries;
+  const unsigned char *trees;
+};
+
+/******************************************************************
+ ******************************************************************/
+
+static void
+putVarint (std::string *out, uint32_t v)
+{
+  while (v >= 0x80)
+    {
+      out->push_back ((char)(v | 0x80));
+      v >>= 7;
+    }
+  out->push_back ((char)v);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Read a varint at *p, not beyond end.
+ *
+ * Return:
+ * - false if the varint is truncated or too long.
+ */
+static bool
+getVarint (const unsigned char **p, const unsigned char *end, uint32_t *v)
+{
+  *v = 0;
+  for (int shift = 0; shift < 35 && *p < end; shift += 7)
+    {
+      unsigned char byte = *(*p)++;
+      *v |= (uint32_t)(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+std::string
+encodeBlocks (const std::vector<Block> &blocks)
+{
+  std::string tree;
+
+  putVarint (&tree, (uint32_t)blocks.size ());
+  for (size_t i = 0; i < blocks.size (); i++)
+    {
+      putVarint (&tree, ((uint32_t)blocks[i].x << 1) | blocks[i].rotated);
+      putVarint (&tree, (uint32_t)blocks[i].y);
+      putVarint (&tree, (uint32_t)blocks[i].dx);
+      putVarint (&tree, (uint32_t)blocks[i].dy);
+    }
+  return tree;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+static bool
+decodeBlocks (const unsigned char *p, size_t size, std::vector<Block> *blocks)
+{
+  const unsigned char *end = p + size;
+  uint32_t n, v[4];
+
+  blocks->clear ();
+  if (!getVarint (&p, end, &n) || n > size)
+    {
+      return false;
+    }
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      for (int k = 0; k < 4; k++)
+        {
+          if (!getVarint (&p, end, &v[k]))
+            {
+              return false;
+            }
+        }
+      Block block = { (int)(v[0] >> 1), (int)v[1], (int)v[2], (int)v[3],
+                      (v[0] & 1) != 0 };
+      blocks->push_back (block);
+    }
+  return p == end;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+static bool
+lessProblem (const Solution &a, const Solution &b)
+{
+  if (a.L != b.L)
+    return a.L < b.L;
+  if (a.W != b.W)
+    return a.W < b.W;
+  if (a.l != b.l)
+    return a.l < b.l;
+  return a.w < b.w;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+static bool
+sameProblem (const Solution &a, const Solution &b)
+{
+  return a.L == b.L && a.W == b.W && a.l == b.l && a.w == b.w;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+bool
+writeSolutionTable (const char *path, std::vector<Solution> &solutions)
+{
+  std::stable_sort (solutions.begin (), solutions.end (), lessProblem);
+  solutions.erase (std::unique (solutions.begin (), solutions.end (),
+                                sameProblem),
+                   solutions.end ());
+
+  TableHeader header;
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, TABLE_MAGIC, sizeof (header.magic));
+  header.version = TABLE_VERSION;
+  header.entrySize = sizeof (TableEntry);
+  header.numEntries = solutions.size ();
+  header.entriesOffset = sizeof (TableHeader);
+  header.treesOffset = header.entriesOffset
+    + header.numEntries * sizeof (TableEntry);
+
+  std::vector<TableEntry> entries (solutions.size ());
+  uint64_t offset = 0;
+  for (size_t i = 0; i < solutions.size (); i++)
+    {
+      entries[i].L = solutions[i].L;
+      entries[i].W = solutions[i].W;
+      entries[i].l = solutions[i].l;
+      entries[i].w = solutions[i].w;
+      entries[i].count = solutions[i].count;
+      entries[i].treeSize = (uint32_t)solutions[i].tree.size ();
+      entries[i].treeOffset = offset;
+      offset += solutions[i].tree.size ();
+    }
+  header.treesSize = offset;
+
+  /* Write a temporary file and rename it, so that readers never map a
+   * partial table. */
+  std::string temporary = std::string (path) + ".tmp";
+  FILE *file = fopen (temporary.c_str (), "wb");
+  if (file == NULL)
+    {
+      return false;
+    }
+
+  bool ok = fwrite (&header, sizeof (header), 1, file) == 1
+    && (entries.empty ()
+        || fwrite (&entries[0], sizeof (TableEntry), entries.size (), file)
+           == entries.size ());
+  for (size_t i = 0; ok && i < solutions.size (); i++)
+    {
+      const std::string &tree = solutions[i].tree;
+      ok = fwrite (tree.data (), 1, tree.size (), file) == tree.size ();
+    }
+  ok = fclose (file) == 0 && ok;
+
+  if (!ok || rename (temporary.c_str (), path) != 0)
+    {
+      unlink (temporary.c_str ());
+      return false;
+    }
+  return true;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+SolutionTable *
+openSolutionTable (const char *path)
+{
+  struct stat info;
+  int fd = open (path, O_RDONLY);
+
+  if (fd < 0)
+    {
+      return NULL;
+    }
+  if (fstat (fd, &info) != 0 || (size_t)info.st_size < sizeof (TableHeader))
+    {
+      close (fd);
+      return NULL;
+    }
+
+  size_t size = (size_t)info.st_size;
+  void *data = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (data == MAP_FAILED)
+    {
+      return NULL;
+    }
+
+  const TableHeader *header = (const TableHeader *)data;
+  bool valid = memcmp (header->magic, TABLE_MAGIC, sizeof (header->magic)) == 0
+    && header->version == TABLE_VERSION
+    && header->entrySize == sizeof (TableEntry)
+    && header->entriesOffset == sizeof (TableHeader)
+    && header->numEntries <= (size - sizeof (TableHeader)) / sizeof (TableEntry)
+    && header->treesOffset
+       == header->entriesOffset + header->numEntries * sizeof (TableEntry)
+    && header->treesSize == size - header->treesOffset;
+
+  if (!valid)
+    {
+      munmap (data, size);
+      return NULL;
+    }
+
+  SolutionTable *table = new SolutionTable;
+  table->data = (const unsigned char *)data;
+  table->size = size;
+  table->header = header;
+  table->entries = (const TableEntry *)(table->data + header->entriesOffset);
+  table->trees = table->data + header->treesOffset;
+  return table;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+void
+closeSolutionTable (SolutionTable *table)
+{
+  if (table != NULL)
+    {
+      munmap ((void *)table->data, table->size);
+      delete table;
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+size_t
+tableSize (const SolutionTable *table)
+{
+  return (size_t)table->header->numEntries;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Decode the cut tree of an entry, checking that it lies within the
+ * table.
+ */
+static bool
+entryBlocks (const SolutionTable *table, const TableEntry *entry,
+             std::vector<Block> *blocks)
+{
+  if (entry->treeOffset > table->header->treesSize
+      || entry->treeSize > table->header->treesSize - entry->treeOffset)
+    {
+      return false;
+    }
+  return decodeBlocks (table->trees + entry->treeOffset, entry->treeSize,
+                       blocks);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Check that the blocks of the solution of an entry lie within its
+ * pallet and hold its number of boxes, which is the room taken to draw
+ * them.
+ */
+static bool
+validBlocks (const TableEntry *entry, const std::vector<Block> &blocks)
+{
+  long boxes = 0;
+
+  for (size_t i = 0; i < blocks.size (); i++)
+    {
+      const Block &b = blocks[i];
+      int a = b.rotated ? entry->w : entry->l;
+      int c = b.rotated ? entry->l : entry->w;
+
+      if (b.x < 0 || b.y < 0 || b.dx < 0 || b.dy < 0
+          || b.x > entry->L - b.dx || b.y > entry->W - b.dy)
+        {
+          return false;
+        }
+      boxes += (long)(b.x / a) * (b.y / c);
+    }
+  return boxes == entry->count;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+bool
+tableSolution (const SolutionTable *table, size_t i, Solution *solution)
+{
+  const TableEntry *entry = &table->entries[i];
+  std::vector<Block> blocks;
+
+  if (!entryBlocks (table, entry, &blocks))
+    {
+      return false;
+    }
+
+  solution->L = entry->L;
+  solution->W = entry->W;
+  solution->l = entry->l;
+  solution->w = entry->w;
+  solution->count = entry->count;
+  solution->tree.assign ((const char *)table->trees + entry->treeOffset,
+                         entry->treeSize);
+  return true;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+lookupSolution (const SolutionTable *table, int L, int W, int l, int w,
+                std::vector<Block> *blocks)
+{
+  int32_t key[4] = { L, W, l, w };
+  size_t low = 0, high = (size_t)table->header->numEntries;
+
+  /* Binary search of the first entry not less than the key. */
+  while (low < high)
+    {
+      size_t middle = low + (high - low) / 2;
+      const TableEntry *entry = &table->entries[middle];
+      int32_t problem[4] = { entry->L, entry->W, entry->l, entry->w };
+      if (std::lexicographical_compare (problem, problem + 4, key, key + 4))
+        {
+          low = middle + 1;
+        }
+      else
+        {
+          high = middle;
+        }
+    }
+
+  if (low == table->header->numEntries)
+    {
+      return -1;
+    }
+
+  const TableEntry *entry = &table->entries[low];
+  if (entry->L != L || entry->W != W || entry->l != l || entry->w != w)
+    {
+      return -1;
+    }
+  /* A corrupt entry is solved instead. */
+  std::vector<Block> decoded;
+  if (blocks == NULL)
+    {
+      blocks = &decoded;
+    }
+  if (entry->l <= 0 || entry->w <= 0 || !entryBlocks (table, entry, blocks)
+      || !validBlocks (entry, *blocks))
+    {
+      return -1;
+    }
+  return entry->count;
+}
@@ -0,0 +1,171 @@
+/* Copyright (C) 2007-2016 Rafael Durbano Lobato
+ *
+ * This file is part of Recursive Partitioning Algorithm.
+ *
+ * Recursive Partitioning Algorithm is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Recursive Partitioning Algorithm is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Recursive Partitioning Algorithm. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Contact information:
+ *
+ * Rafael Durbano Lobato <lobato@ime.usp.br>
+ * http://www.ime.usp.br/~lobato/
+ */
+
+
+#ifndef LOOKUP_H_
+#define LOOKUP_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "draw_bd.h"
+
+/* Precomputed solutions.
+ *
+ * A solution table file holds the solutions of a set of problems, so
+ * that they are answered without solving. It is made of a header, an
+ * array of entries sorted by (L,W,l,w), where L >= W, and the cut
+ * trees of the solutions, each one stored as the varint-encoded list
+ * of its blocks (see drawBlocks()). The file is mapped read-only and
+ * searched in place, in O(log n). Integers are stored in the byte
+ * order of the machine that wrote the file; files are rejected on
+ * machines of the other order. */
+
+#define TABLE_MAGIC "PALLETTB"
+#define TABLE_VERSION 1
+
+struct TableHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t entrySize;
+  uint64_t numEntries;
+
+  /* Offsets, in bytes from the beginning of the file, of the entries
+   * and of the cut trees. */
+  uint64_t entriesOffset;
+  uint64_t treesOffset;
+  uint64_t treesSize;
+};
+
+struct TableEntry
+{
+  int32_t L, W, l, w;
+
+  /* Number of boxes of the solution. */
+  int32_t count;
+
+  /* Size and offset, relative to treesOffset, of the cut tree. */
+  uint32_t treeSize;
+  uint64_t treeOffset;
+};
+
+/* A problem solved by the precompute tool, with its encoded cut tree
+ * (see encodeBlocks()). */
+struct Solution
+{
+  int L, W, l, w;
+  int count;
+  std::string tree;
+};
+
+/* A solution table mapped in memory. */
+struct SolutionTable;
+
+/**
+ * Solve the problem of packing (l,w)-boxes into the (L,W) pallet, with
+ * L >= W, with Algorithm 1 and store the blocks of its solution. It is
+ * defined along with pack() and used by the precompute tool.
+ *
+ * Parameters:
+ * checkpoint - Path of a checkpoint of the search (see save_BD()),
+ *              written every interval seconds and removed once the
+ *              problem is solved. The search continues the checkpoint
+ *              left by an interrupted run. NULL solves without
+ *              checkpoints. The search with checkpoints runs on the
+ *              calling thread only.
+ *
+ * Return:
+ * - the number of boxes packed, or -1 if some dimension is invalid,
+ *   L < W or the problem was cancelled.
+ */
+int solveBlocks (int L, int W, int l, int w, std::vector<Block> *blocks,
+                 const char *checkpoint = NULL, int interval = 0);
+
+/**
+ * Encode the blocks of a cut tree as stored in a solution table.
+ */
+std::string encodeBlocks (const std::vector<Block> &blocks);
+
+/**
+ * Write the solutions to a solution table file. The solutions are
+ * sorted by (L,W,l,w) and, for repeated problems, only the first one
+ * is kept.
+ *
+ * Parameters:
+ * path      - Path of the file.
+ *
+ * solutions - The problems solved, with L >= W.
+ *
+ * Return:
+ * - false if the file could not be written.
+ */
+bool writeSolutionTable (const char *path, std::vector<Solution> &solutions);
+
+/**
+ * Map a solution table file read-only.
+ *
+ * Return:
+ * - the table, or NULL if the file cannot be read or is not a valid
+ *   solution table.
+ */
+SolutionTable *openSolutionTable (const char *path);
+
+/**
+ * Unmap a solution table.
+ */
+void closeSolutionTable (SolutionTable *table);
+
+/**
+ * Return the number of solutions of a table.
+ */
+size_t tableSize (const SolutionTable *table);
+
+/**
+ * Read the solution i of a table, in the order of the table.
+ *
+ * Return:
+ * - false if the cut tree of the solution is corrupt.
+ */
+bool tableSolution (const SolutionTable *table, size_t i, Solution *solution);
+
+/**
+ * Look up the solution of the problem (L,W,l,w), with L >= W.
+ *
+ * Parameters:
+ * blocks - Receives the blocks of the solution, or NULL to get only
+ *          its number of boxes.
+ *
+ * Return:
+ * - the number of boxes of the solution, or -1 if the problem is not
+ *   in the table or its entry is corrupt: its cut tree cannot be
+ *   decoded, or its blocks leave the pallet or do not hold the number
+ *   of boxes of the entry.
+ */
+int lookupSolution (const SolutionTable *table, int L, int W, int l, int w,
+                    std::vector<Block> *blocks);
+
+#endif
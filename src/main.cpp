@@ -43,11 +43,21 @@
 /******************************************************************
  ******************************************************************/
 
+#include <algorithm>
+#include <climits>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
-#include <map>
-
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <sched.h>
 #include <stdlib.h>
 #include <sys/resource.h>
 #include <sys/time.h>
@@ -56,13 +66,17 @@
 #include <iostream>
 
 #include "bd.h"
+#include "cancel.h"
 #include "draw.h"
 #include "graphics.h"
+#include "lapproach.h"
+#include "lookup.h"
+#include "pool.h"
 #include "sets.h"
+#include "subdivision.h"
+#include "tables.h"
 #include "util.h"
 
-#include <emscripten.h>
-
 // If this is an Emscripten (WebAssembly) build then...
 #ifdef __EMSCRIPTEN__
   #include <emscripten.h>
@@ -72,45 +86,74 @@
  ******************************************************************/
 
 int solve (int L, int *q);
+int solvePiece (int L, int key, int *q);
+
+/* The state of the solver below is local to each thread, so that
+ * different threads can solve independent problems at the same time
+ * (see solve_BD() for threads sharing the same problem). */
 
 /* Lower and upper bounds of each rectangular subproblem. */
-int **lowerBound, **upperBound;
+__thread int **lowerBound, **upperBound;
 
 /* Arrays of indices for indexing the matrices that store information
  * about rectangular subproblems (L,W), where (L,W) belongs to X' x Y'
  * and X' and Y' are the raster points sets associated to (L,l,w) and
  * (W,l,w), respectively. */
-int *indexX, *indexY;
+__thread int *indexX, *indexY;
 
 /* Set of integer conic combinations of l and w:
  * X = {x | x = rl + sw, with r,w in Z and r,w >= 0} */
-Set normalSetX;
+__thread Set normalSetX;
 
 /* Array that stores the normalized values of each integer between 0 and
  * L (dimension of the problem):
  * normalize[x] = max {r in X' | r <= x} */
-int *normalize;
+__thread int *normalize;
 
 /* Store the solutions of the subproblems. */
-std::map<int, int> *solutionMap;
-int *solution;
+__thread std::unordered_map<int, int> *solutionMap;
+__thread int *solution;
 
 /* Store the division points in the rectangular and in the L-shaped
  * pieces associated to the solutions found. */
-std::map<int, int> *divisionPointMap;
-int *divisionPoint;
+__thread std::unordered_map<int, int> *divisionPointMap;
+__thread int *divisionPoint;
 
 /* Dimensions of the boxes to be packed. */
-int l, w;
+__thread int l, w;
 
 /* Type of the structure used to store the solutions. */
-int memory_type;
+__thread int memory_type;
+
+/* Number of L-pieces stored in the arrays solution and divisionPoint.
+ * The L-pieces of index L >= denseSize are stored in the maps, at
+ * L - denseSize. In MEM_TYPE_HYBRID, the arrays store the L-pieces
+ * whose indices in the raster points are less than numDenseX and
+ * numDenseY, which are the most visited ones. */
+__thread int denseSize;
+__thread int numDenseX, numDenseY;
+
+/* Maximum number of L-pieces in the arrays of MEM_TYPE_HYBRID. */
+#define HYBRID_DENSE_SIZE (1 << 22)
 
 /* Store the points that determine the divisions of the rectangles. */
-CutPoint **cutPoints;
+__thread CutPoint **cutPoints;
+
+__thread int *indexRasterX, *indexRasterY;
+__thread int numRasterX, numRasterY;
+
+/* Number of L-pieces solved by solve(), for solve_L(). */
+__thread long piecesSolved;
+
+/* States of an L-piece in the parallel L-approach. */
+#define PIECE_FREE 0
+#define PIECE_BUSY 1
+#define PIECE_DONE 2
 
-int *indexRasterX, *indexRasterY;
-int numRasterX, numRasterY;
+/* States of the L-pieces (PIECE_FREE, PIECE_BUSY or PIECE_DONE) when
+ * the L-approach runs on several threads sharing the arrays solution
+ * and divisionPoint, or NULL when it runs on a single thread. */
+__thread unsigned char *pieceState;
 
 /******************************************************************
  ******************************************************************/
@@ -182,7 +225,7 @@ R_LowerBound (int x, int y)
 {
   x = normalize[x];
   y = normalize[y];
-  return lowerBound[indexX[x]][indexY[y]];
+  return __atomic_load_n (&lowerBound[indexX[x]][indexY[y]], __ATOMIC_RELAXED);
 }
 
 /******************************************************************
@@ -212,12 +255,22 @@ inline int
 L_LowerBound (int *q, bool *horizontalCut)
 {
 
-  int a = lowerBound[indexX[normalize[q[2]]]][indexY[normalize[q[1] - q[3]]]]
-          + lowerBound[indexX[normalize[q[0]]]][indexY[normalize[q[3]]]];
-
-  int b
-      = lowerBound[indexX[normalize[q[2]]]][indexY[normalize[q[1]]]]
-        + lowerBound[indexX[normalize[q[0] - q[2]]]][indexY[normalize[q[3]]]];
+  /* The parallel L-approach raises the bounds of the rectangles while
+   * other threads read them. */
+  int a = __atomic_load_n (
+              &lowerBound[indexX[normalize[q[2]]]]
+                         [indexY[normalize[q[1] - q[3]]]],
+              __ATOMIC_RELAXED)
+          + __atomic_load_n (
+              &lowerBound[indexX[normalize[q[0]]]][indexY[normalize[q[3]]]],
+              __ATOMIC_RELAXED);
+
+  int b = __atomic_load_n (
+              &lowerBound[indexX[normalize[q[2]]]][indexY[normalize[q[1]]]],
+              __ATOMIC_RELAXED)
+          + __atomic_load_n (&lowerBound[indexX[normalize[q[0] - q[2]]]]
+                                        [indexY[normalize[q[3]]]],
+                             __ATOMIC_RELAXED);
 
   if (a > b)
     {
@@ -234,34 +287,6 @@ L_LowerBound (int *q, bool *horizontalCut)
 /******************************************************************
  ******************************************************************/
 
-/**
- * Divide an L-piece in two new L-pieces, according to the specified
- * subdivision, and normalize the two ones.
- *
- * Parameters:
- * i  - Point that determines the division int the L-piece.
- *
- * q  - The L-piece to be divided.
- *
- * q1 - It will store a new L-piece.
- *
- * q2 - It will store the other new L-piece.
- *
- * standardPosition - Pointer to the function that will divide the L-piece.
- */
-void
-divide (int *i, int *q, int *q1, int *q2,
-        void (*standardPosition) (int *, int *, int *, int *))
-{
-
-  /* Divide the L-piece in two new ones. */
-  (*standardPosition) (i, q, q1, q2);
-
-  /* Normalize the new L-pieces. */
-  normalizePiece (q1);
-  normalizePiece (q2);
-}
-
 /******************************************************************
  ******************************************************************/
 
@@ -279,13 +304,13 @@ divide (int *i, int *q, int *q1, int *q2,
 inline int
 getSolution (int L, int key)
 {
-  if (memory_type == MEM_TYPE_4)
+  if (L < denseSize)
     {
       return solution[L] & nRet;
     }
   else
     {
-      return solutionMap[L][key] & nRet;
+      return solutionMap[L - denseSize][key] & nRet;
     }
 }
 
@@ -306,14 +331,14 @@ getSolution (int L, int key)
 inline int
 getSolution (int L, int *q)
 {
-  if (memory_type == MEM_TYPE_4)
+  if (L < denseSize)
     {
       return solution[L] & nRet;
     }
   else
     {
       int key = getKey (q[0], q[1], q[2], q[3], memory_type);
-      return solutionMap[L][key] & nRet;
+      return solutionMap[L - denseSize][key] & nRet;
     }
 }
 
@@ -336,14 +361,14 @@ getSolution (int L, int *q)
 inline int
 getSolution (int L, int *q, int *key)
 {
-  if (memory_type == MEM_TYPE_4)
+  if (L < denseSize)
     {
       return solution[L];
     }
   else
     {
       *key = getKey (q[0], q[1], q[2], q[3], memory_type);
-      return solutionMap[L][*key];
+      return solutionMap[L - denseSize][*key];
     }
 }
 
@@ -364,13 +389,13 @@ getSolution (int L, int *q, int *key)
 inline void
 storeSolution (int L, int key, int LSolution)
 {
-  if (memory_type == MEM_TYPE_4)
+  if (L < denseSize)
     {
       solution[L] = LSolution;
     }
   else
     {
-      solutionMap[L][key] = LSolution;
+      solutionMap[L - denseSize][key] = LSolution;
     }
 }
 
@@ -391,13 +416,13 @@ storeSolution (int L, int key, int LSolution)
 inline void
 storeDivisionPoint (int L, int key, int point)
 {
-  if (memory_type == MEM_TYPE_4)
+  if (L < denseSize)
     {
       divisionPoint[L] = point;
     }
   else
     {
-      divisionPointMap[L][key] = point;
+      divisionPointMap[L - denseSize][key] = point;
     }
 }
 
@@ -432,764 +457,475 @@ optimal (int L, int key, int upperBound)
  ******************************************************************/
 
 /**
- * Divide the L-piece in every possible way, according to the specified
- * subdivision B.
+ * Calculate the lower bound of a piece produced by a division, which is
+ * either an L or a degenerated L (a rectangle). solve() never returns
+ * less than this for the piece.
  *
  * Parameters:
- * L                - Index of the L-piece.
- *
- * q                - The L-piece.
- *
- * constraints      - Constraints that determine the interval of x' and y'.
- *
- * B                - The subdivision.
- *
- * standardPosition - Pointer to the function that divides the L-piece
- *                    according to the subdivision B.
- *
- * X                - Set of raster points.
- *
- * startX           - Index to start the divisions on the set X.
- *
- * Y                - Set of raster points.
+ * q - The piece.
  *
- * startY           - Index to start the divisions on the set Y.
+ * Return:
+ * The computed lower bound.
  */
-int
-divideL (int L, int *q, int *constraints, int B,
-         void (*standardPosition) (int *, int *, int *, int *), Set X,
-         int startX, Set Y, int startY)
+inline int
+pieceLowerBound (int *q)
 {
-
-  /* i_k[0] <- x'
-   * i_k[1] <- y'
-   */
-  int i_k[2];
-  int i_x, i_y;
-  int q1[4], q2[4];
-
-  int key = 0;
-  int LSolution = getSolution (L, q, &key);
-  int upperBound = L_UpperBound (q);
-
-  for (i_x = startX; i_x < X.size; i_x++)
+  bool horizontalCut;
+  if (q[0] == q[2])
     {
-
-      i_k[0] = X.points[i_x];
-      if (i_k[0] > constraints[1])
-        {
-          break;
-        }
-
-      for (i_y = startY; i_y < Y.size; i_y++)
-        {
-
-          i_k[1] = Y.points[i_y];
-          if (i_k[1] > constraints[3])
-            {
-              break;
-            }
-
-          divide (i_k, q, q1, q2, (*standardPosition));
-          if (q1[0] < 0 || q2[0] < 0)
-            {
-              continue;
-            }
-
-          if (L_UpperBound (q1) + L_UpperBound (q2) > (LSolution & nRet))
-            {
-              /* It is possible that this division gets a better solution. */
-              int L1 = LIndex (q1[0], q1[1], q1[2], q1[3], memory_type);
-              int L2 = LIndex (q2[0], q2[1], q2[2], q2[3], memory_type);
-              int L1Solution = solve (L1, q1);
-              int L2Solution = solve (L2, q2);
-
-              if ((L1Solution & nRet) + (L2Solution & nRet)
-                  > (LSolution & nRet))
-                {
-                  /* A better solution was found. */
-                  LSolution = ((L1Solution & nRet) + (L2Solution & nRet))
-                              | (B << descSol);
-                  storeSolution (L, key, LSolution);
-                  storeDivisionPoint (L, key,
-                                      i_k[0] | (i_k[1] << descPtoDiv2));
-                  if ((LSolution & nRet) == upperBound)
-                    {
-                      return LSolution;
-                    }
-                }
-            }
-        }
+      return R_LowerBound (q[0], q[1]);
     }
-  return LSolution;
+  return L_LowerBound (q, &horizontalCut);
 }
 
 /******************************************************************
  ******************************************************************/
 
 /**
- * Divide the L-piece in every possible way, according to the B6
- * subdivision.
- *
- * +-------------+--------+
- * |             |        |
- * |   (x',y')   |   L2   |
- * |      o------o        |
- * |      |  (x'',y')     |
- * |  L1  |               |
- * |      |               |
- * +------+---------------+
+ * Calculate the upper bound of a piece produced by a division. The piece
+ * fits in the rectangle (q[0], q[1]), whose bound in the tables may be
+ * tighter than the area of the piece.
  *
  * Parameters:
- * L - Index of the L-piece.
- *
- * q - The L-piece.
- *
- * X - Set of raster points.
+ * q - The piece.
  *
- * Y - Set of raster points.
+ * Return:
+ * The computed upper bound.
  */
-int
-divideB6 (int L, int *q, Set X, Set Y)
+inline int
+pieceUpperBound (int *q)
 {
+  return std::min (L_UpperBound (q), R_UpperBound (q[0], q[1]));
+}
 
-  /* i_k[0] <- x'
-   * i_k[1] <- y'
-   * i_k[2] <- x''
-   */
-  int i_k[3];
-  int q1[4], q2[4];
-  int key = 0;
-  int LSolution = getSolution (L, q, &key);
-  int upperBound = R_UpperBound (q[0], q[1]);
+/******************************************************************
+ ******************************************************************/
 
-  int i = 0;
-  for (i_k[0] = X.points[i]; i < X.size; i++)
+/**
+ * Return the solution of a piece if it is in the memory.
+ *
+ * Parameters:
+ * L - Index of the piece.
+ *
+ * q - The piece.
+ *
+ * Return:
+ * The solution of the piece, or -1 if it was not solved yet.
+ */
+inline int
+knownSolution (int L, int *q)
+{
+  if (L < denseSize)
     {
-
-      i_k[0] = X.points[i];
-
-      int j = i;
-      for (i_k[2] = X.points[j]; j < X.size; j++)
+      if (pieceState != NULL
+          && __atomic_load_n (&pieceState[L], __ATOMIC_ACQUIRE) != PIECE_DONE)
         {
-
-          i_k[2] = X.points[j];
-          if (i_k[0] == 0 && i_k[2] == 0)
-            {
-              continue;
-            }
-
-          int k = 0;
-          for (i_k[1] = Y.points[k]; k < Y.size; k++)
-            {
-
-              i_k[1] = Y.points[k];
-              divide (i_k, q, q1, q2, standardPositionB6);
-              if (q1[0] < 0 || q2[0] < 0)
-                {
-                  continue;
-                }
-
-              if (L_UpperBound (q1) + L_UpperBound (q2) > (LSolution & nRet))
-                {
-                  /* It is possible that this division gets a better solution.
-                   */
-                  int L1 = LIndex (q1[0], q1[1], q1[2], q1[3], memory_type);
-                  int L2 = LIndex (q2[0], q2[1], q2[2], q2[3], memory_type);
-                  int L1Solution = solve (L1, q1);
-                  int L2Solution = solve (L2, q2);
-
-                  if ((L1Solution & nRet) + (L2Solution & nRet)
-                      > (LSolution & nRet))
-                    {
-                      /* A better solution was found. */
-                      LSolution = ((L1Solution & nRet) + (L2Solution & nRet))
-                                  | (B6 << descSol);
-                      storeSolution (L, key, LSolution);
-                      storeDivisionPoint (L, key,
-                                          i_k[0] | (i_k[1] << descPtoDiv2)
-                                              | (i_k[2] << descPtoDiv3));
-
-                      if ((LSolution & nRet) == upperBound)
-                        {
-                          return LSolution;
-                        }
-                    }
-                }
-            }
+          return -1;
         }
+      return solution[L];
     }
-  return LSolution;
+  std::unordered_map<int, int>::iterator it
+      = solutionMap[L - denseSize].find (
+          getKey (q[0], q[1], q[2], q[3], memory_type));
+  if (it == solutionMap[L - denseSize].end ())
+    {
+      return -1;
+    }
+  return it->second;
 }
 
 /******************************************************************
  ******************************************************************/
 
 /**
- * Divide the L-piece in every possible way, according to the B7
- * subdivision.
- *
- * +-------------+
- * |             |
- * |   (x',y'')  |
- * |      o------+
- * |      |      |
- * |  L1  |  L2  |
- * |      |      |
- * +------o      |
- * |   (x',y')   |
- * |             |
- * |             |
- * +-------------+
+ * Calculate the lower bound of a division of an L-piece by the
+ * subdivision B3 at a point on the border of the L-piece, which cuts a
+ * rectangle from it. The other piece is an L, bounded by its solution
+ * if it was already solved, or else by its rectangles.
  *
  * Parameters:
- * L - Index of the L-piece.
+ * i - The division point, (0,y') or (x',0).
  *
  * q - The L-piece.
  *
- * X - Set of raster points.
- *
- * Y - Set of raster points.
+ * Return:
+ * The computed lower bound, or 0 if a piece does not fit a box.
  */
-int
-divideB7 (int L, int *q, Set X, Set Y)
+inline int
+stripLowerBound (const int *i, int *q)
 {
-
-  /* i_k[0] <- x'
-   * i_k[1] <- y'
-   * i_k[2] <- y''
-   */
-  int i_k[3];
   int q1[4], q2[4];
-  int key = 0;
-  int LSolution = getSolution (L, q, &key);
-  int upperBound = R_UpperBound (q[0], q[1]);
 
-  int j = 0;
-  for (i_k[1] = Y.points[j]; j < Y.size; j++)
+  divide<B3> (i, q, q1, q2, normalize, l * w);
+  if (q1[0] < 0 || q2[0] < 0)
     {
+      return 0;
+    }
 
-      i_k[1] = Y.points[j];
-
-      int k = j;
-      for (i_k[2] = Y.points[k]; k < Y.size; k++)
-        {
-
-          i_k[2] = Y.points[k];
-          if (i_k[1] == 0 && i_k[2] == 0)
-            {
-              continue;
-            }
-
-          int i = 0;
-          for (i_k[0] = X.points[i]; i < X.size; i++)
-            {
-
-              i_k[0] = X.points[i];
-              divide (i_k, q, q1, q2, standardPositionB7);
-              if (q1[0] < 0 || q2[0] < 0)
-                {
-                  continue;
-                }
-
-              if (L_UpperBound (q1) + L_UpperBound (q2) > (LSolution & nRet))
-                {
-                  /* It is possible that this division gets a better solution.
-                   */
-                  int L1 = LIndex (q1[0], q1[1], q1[2], q1[3], memory_type);
-                  int L2 = LIndex (q2[0], q2[1], q2[2], q2[3], memory_type);
-                  int L1Solution = solve (L1, q1);
-                  int L2Solution = solve (L2, q2);
-
-                  if (((L1Solution & nRet) + (L2Solution & nRet))
-                      > (LSolution & nRet))
-                    {
-                      /* A better solution was found. */
-                      LSolution = ((L1Solution & nRet) + (L2Solution & nRet))
-                                  | (B7 << descSol);
-                      storeSolution (L, key, LSolution);
-                      storeDivisionPoint (L, key,
-                                          i_k[0] | (i_k[1] << descPtoDiv2)
-                                              | (i_k[2] << descPtoDiv3));
-
-                      if ((LSolution & nRet) == upperBound)
-                        {
-                          return LSolution;
-                        }
-                    }
-                }
-            }
-        }
+  int solution
+      = knownSolution (LIndex (q2[0], q2[1], q2[2], q2[3], memory_type), q2);
+  if (solution != -1)
+    {
+      return R_LowerBound (q1[0], q1[1]) + (solution & nRet);
     }
-  return LSolution;
+  return R_LowerBound (q1[0], q1[1]) + pieceLowerBound (q2);
 }
 
 /******************************************************************
  ******************************************************************/
 
 /**
- * Solve the problem of packing rectangular (l,w)-boxes into the
- * specified L-shaped piece.
+ * Calculate a lower bound of an L-piece from the divisions that cut a
+ * strip from its bottom or from its left. Bounding the other piece by
+ * two rectangles gives these three rectangles, besides those that are
+ * a division of the rectangles of L_LowerBound:
+ *
+ * +-----+                        +--+--+
+ * |     |                        |  |  |
+ * |     |(x,y)                   |  |  |(x,y)
+ * |     +----+                   |  +--+----+
+ * |     |    |                   |  |       |
+ * +-----+----+                   |  |       |
+ * |          |                   |  |       |
+ * +----------+                   +--+-------+
+ * B3 at (0,y'), 0 < y' < y       B3 at (x',0), 0 < x' < x
+ *
+ * These divisions are on the border of the intervals of x' and y' of
+ * the subdivision B3, so they never give more than solving the L-piece,
+ * but they give it before any division is solved.
  *
  * Parameters:
- * L - Index of the L-piece.
+ * q      - The L-piece.
  *
- * q - The L-piece. q = {X, Y, x, y}.
+ * X      - Set of raster points.
+ *
+ * startX - Index of the first point of X not less than x.
+ *
+ * Y      - Set of raster points.
+ *
+ * startY - Index of the first point of Y not less than y.
+ *
+ * best   - The lower bound to beat.
+ *
+ * point  - Receives the division point of the B3 subdivision that gives
+ *          the bound, as stored by storeDivisionPoint, if it beats best.
+ *
+ * Return:
+ * The greater of best and the computed lower bound.
  */
 int
-solve (int L, int *q)
+L_DivisionLowerBound (int *q, Set X, int startX, Set Y, int startY,
+                      int best, int *point)
 {
+  int i[2];
 
-  int key = 0;
-  if (memory_type == MEM_TYPE_4)
+  /* Cut a strip from the bottom. */
+  i[0] = 0;
+  for (int k = 0; k < startY; k++)
     {
-      if (solution[L] != -1)
+      i[1] = Y.points[k];
+      int bound = i[1] > 0 ? stripLowerBound (i, q) : 0;
+      if (bound > best)
         {
-          /* This problem has already been solved. */
-          return solution[L];
+          best = bound;
+          *point = i[0] | (i[1] << descPtoDiv2);
         }
     }
-  else
+
+  /* Cut a strip from the left. */
+  i[1] = 0;
+  for (int k = 0; k < startX; k++)
     {
-      key = getKey (q[0], q[1], q[2], q[3], memory_type);
-      if (solutionMap[L].count (key) > 0)
+      i[0] = X.points[k];
+      int bound = i[0] > 0 ? stripLowerBound (i, q) : 0;
+      if (bound > best)
         {
-          /* This problem has already been solved. */
-          return solutionMap[L][key];
+          best = bound;
+          *point = i[0] | (i[1] << descPtoDiv2);
         }
     }
+  return best;
+}
 
-  if (q[0] != q[2])
-    {
-      bool horizontalCut;
-      int lowerBound = L_LowerBound (q, &horizontalCut);
-      int upperBound = L_UpperBound (q);
-      int LSolution = lowerBound | (B1 << descSol);
+/******************************************************************
+ ******************************************************************/
 
-      if (horizontalCut)
-        storeDivisionPoint (L, key, 0 | (q[3] << descPtoDiv2));
-      else
-        storeDivisionPoint (L, key, q[2] | (0 << descPtoDiv2));
+/* A division of an L-piece that passed the screening of divideL and
+ * waits to be solved. */
+struct Candidate
+{
+  int q1[4];
+  int q2[4];
+  int L1;
+  int L2;
+  int point;
+  int upperBound;
+  int lowerBound;
+};
+
+/* Candidates of every divideL in the recursion, each call owning the
+ * ones after those of its callers. */
+static thread_local std::vector<Candidate> candidates;
+
+/* Solution looked for by canonicalPiece(), or 0 while searching. The
+ * divisions are then solved in the order they are screened, and the
+ * first one that gives this solution is kept. */
+__thread int canonicalTarget;
 
-      storeSolution (L, key, LSolution);
+/******************************************************************
+ ******************************************************************/
 
-      /* Try to solve this problem with homogeneous packing (or other
-       * better solution already computed). */
-      if ((LSolution & nRet) != upperBound)
-        {
-          /* It was not possible to solve this problem with homogeneous
-           * packing. */
-          int constraints[4];
-          int startX = 0;
-          int startY = 0;
-
-          /* Construct the raster points sets X and Y. */
-          Set X, Y;
-          constructRasterPoints (q[0], q[1], &X, &Y, normalSetX);
-          for (startX = 0; X.points[startX] < q[2]; startX++)
-            ;
-          for (startY = 0; Y.points[startY] < q[3]; startY++)
-            ;
-
-          /***********************************
-           * 0 <= x' <= x  and  0 <= y' <= y *
-           ***********************************/
-          constraints[0] = 0;
-          constraints[1] = q[2];
-          constraints[2] = 0;
-          constraints[3] = q[3];
-
-          /* B1 subdivision.
-           *
-           * +------------+
-           * |            |
-           * |            |(x,y)
-           * |      +-----o-----+
-           * |  L1  |           |
-           * |      |     L2    |
-           * +------o           |
-           * |   (x',y')        |
-           * |                  |
-           * +------------------+
-           */
-          LSolution = divideL (L, q, constraints, B1, standardPositionB1, X, 0,
-                               Y, 0);
-          if ((LSolution & nRet) == upperBound)
-            {
-              free (X.points);
-              free (Y.points);
-              return LSolution;
-            }
-
-          /* B3 subdivision.
-           *
-           * +------+-----+
-           * |      |     |
-           * |      |     |(x,y)
-           * |      | L2  o-----+
-           * |      |           |
-           * |  L1  |           |
-           * |      o-----------+
-           * |   (x',y')        |
-           * |                  |
-           * +------------------+
-           */
-          LSolution = divideL (L, q, constraints, B3, standardPositionB3, X, 0,
-                               Y, 0);
-          if ((LSolution & nRet) == upperBound)
-            {
-              free (X.points);
-              free (Y.points);
-              return LSolution;
-            }
-
-          /* B5 subdivision.
-           *
-           * +------------+
-           * |            |
-           * |     L1     |(x,y)
-           * |            o-----+
-           * |   (x',y')  |     |
-           * |      o-----+     |
-           * |      |           |
-           * |      |     L2    |
-           * |      |           |
-           * +------+-----------+
-           */
-          LSolution = divideL (L, q, constraints, B5, standardPositionB5, X, 0,
-                               Y, 0);
-          if ((LSolution & nRet) == upperBound)
-            {
-              free (X.points);
-              free (Y.points);
-              return LSolution;
-            }
-
-          /***********************************
-           * 0 <= x' <= x  and  y <= y' <= Y *
-           ***********************************/
-          constraints[0] = 0;
-          constraints[1] = q[2];
-          constraints[2] = q[3];
-          constraints[3] = Y.points[Y.size - 1];
-
-          /* B2 subdivision.
-           *
-           * +------------+
-           * |            |
-           * |   (x',y')  |
-           * +------o     |
-           * |      | L1  |
-           * |      |     |(x,y)
-           * |      +-----o-----+
-           * |  L2              |
-           * |                  |
-           * +------------------+
-           */
-          LSolution = divideL (L, q, constraints, B2, standardPositionB2, X, 0,
-                               Y, startY);
-          if ((LSolution & nRet) == upperBound)
-            {
-              free (X.points);
-              free (Y.points);
-              return LSolution;
-            }
-
-          /* B8 subdivision.
-           *
-           * +------------+
-           * |            |
-           * |   (x',y')  |
-           * |      o-----+
-           * |      |     |
-           * |  L1  |     |(x,y)
-           * |      |     o-----+
-           * |      |  L2       |
-           * |      |           |
-           * +------+-----------+
-           */
-          LSolution = divideL (L, q, constraints, B8, standardPositionB8, X, 0,
-                               Y, startY);
-          if ((LSolution & nRet) == upperBound)
-            {
-              free (X.points);
-              free (Y.points);
-              return LSolution;
-            }
-
-          /***********************************
-           * x <= x' <= X  and  0 <= y' <= y *
-           ***********************************/
-          constraints[0] = q[2];
-          constraints[1] = X.points[X.size - 1];
-          constraints[2] = 0;
-          constraints[3] = q[3];
-
-          /* B4 subdivision.
-           *
-           * +------+
-           * |      |
-           * |      |(x,y)
-           * |      o-----------+
-           * |  L1  |           |
-           * |      |  (x',y')  |
-           * |      +-----o     |
-           * |            | L2  |
-           * |            |     |
-           * +------------+-----+
-           */
-          LSolution = divideL (L, q, constraints, B4, standardPositionB4, X,
-                               startX, Y, 0);
-          if ((LSolution & nRet) == upperBound)
-            {
-              free (X.points);
-              free (Y.points);
-              return LSolution;
-            }
-
-          /* B9 subdivision.
-           *
-           * +---------+
-           * |         |
-           * |         |(x,y)
-           * |   L1    o---+----+
-           * |             |    |
-           * |             |    |
-           * +-------------o    |
-           * |          (x',y') |
-           * |     L2           |
-           * |                  |
-           * +------------------+
-           */
-          LSolution = divideL (L, q, constraints, B9, standardPositionB9, X,
-                               startX, Y, 0);
-          free (X.points);
-          free (Y.points);
-        }
-      return LSolution;
-    } /* if q[0] != q[2] */
-  else
-    {
-      /* Degenerated L (a rectangle) */
-
-      int LSolution = R_LowerBound (q[0], q[1]) | (HOMOGENEOUS << descSol);
-      int upperBound = R_UpperBound (q[0], q[1]);
-      storeSolution (L, key, LSolution);
+/* Number of candidate divisions of an L-piece whose pieces are offered
+ * to the other threads of the parallel L-approach, see solveCandidates. */
+#define SHARED_CANDIDATES 4
 
-      /* Verify whether it could not be solved with homogeneous packing. */
-      if ((LSolution & nRet) != upperBound)
-        {
+/* L-piece offered to the threads of the parallel L-approach. */
+struct PieceTask
+{
+  int L;
+  int q[4];
+  int area;
 
-          /* Construct the raster points sets X and Y. */
-          Set X, Y;
-          constructRasterPoints (q[0], q[1], &X, &Y, normalSetX);
+  /* Call of solveCandidates that offered the piece. */
+  long frame;
+};
 
-          /* Try the subdivisions B6 and B7. */
-
-          /* B6 subdivision.
-           *
-           * +-------------+--------+
-           * |             |        |
-           * |   (x',y')   |   L2   |
-           * |      o------o        |
-           * |      |  (x'',y')     |
-           * |  L1  |               |
-           * |      |               |
-           * +------+---------------+
-           */
-          LSolution = divideB6 (L, q, X, Y);
-          if ((LSolution & nRet) == upperBound)
-            {
-              free (X.points);
-              free (Y.points);
+/* Pieces offered by a thread. It takes back the last ones, while the
+ * other threads steal the first ones, which tend to be the largest. */
+struct TaskQueue
+{
+  std::mutex mutex;
+  std::deque<PieceTask> tasks;
+};
 
-              /* Update the lower bound for this rectangular piece. */
-              lowerBound[indexX[q[0]]][indexY[q[1]]] = LSolution & nRet;
+/* Parallel L-approach, shared by its threads. */
+struct LSearch
+{
+  /* Read-only state of the thread that started the search. */
+  int l, w, memory_type, denseSize;
+  int **lowerBound, **upperBound;
+  CutPoint **cutPoints;
+  int *indexX, *indexY, *normalize;
+  Set normalSetX;
+  int *indexRasterX, *indexRasterY;
+  int numRasterX, numRasterY;
+
+  /* Memory of the L-pieces, shared by the threads. */
+  int *solution, *divisionPoint;
+  unsigned char *pieceState;
+
+  /* The root L-piece and its solution. */
+  int L;
+  int q[4];
+  int LSolution;
+
+  TaskQueue *queues;
+  int numQueues;
+
+  /* Set once the root is solved or cancelled, to stop the threads. */
+  std::atomic<int> stop;
+
+  /* Number of L-pieces solved by the threads other than the first. */
+  std::atomic<long> pieces;
+};
+
+/* Parallel L-approach in which this thread takes part, its index among
+ * the threads and the number of calls of solveCandidates. */
+__thread LSearch *lSearch;
+__thread int lWorker;
+__thread long lFrame;
 
-              return LSolution;
-            }
+/******************************************************************
+ ******************************************************************/
 
-          /* B7 subdivision.
-           *
-           * +-------------+
-           * |             |
-           * |   (x',y'')  |
-           * |      o------+
-           * |      |      |
-           * |  L1  |  L2  |
-           * |      |      |
-           * +------o      |
-           * |   (x',y')   |
-           * |             |
-           * |             |
-           * +-------------+
-           */
-          LSolution = divideB7 (L, q, X, Y);
+inline int
+pieceArea (const int *q)
+{
+  return q[0] * q[1] - (q[0] - q[2]) * (q[1] - q[3]);
+}
 
-          free (X.points);
-          free (Y.points);
+/******************************************************************
+ ******************************************************************/
 
-          /* Update the lower bound for this rectangular piece. */
-          lowerBound[indexX[q[0]]][indexY[q[1]]] = LSolution & nRet;
-        }
-      return LSolution;
-    }
+/**
+ * Offer an L-piece to the other threads of the parallel L-approach.
+ *
+ * Parameters:
+ * L     - Index of the L-piece.
+ *
+ * q     - The L-piece.
+ *
+ * frame - Call of solveCandidates that offers the piece.
+ */
+void
+pushTask (int L, const int *q, long frame)
+{
+  PieceTask task;
+  task.L = L;
+  std::copy (q, q + 4, task.q);
+  task.area = pieceArea (q);
+  task.frame = frame;
+
+  TaskQueue &queue = lSearch->queues[lWorker];
+  std::lock_guard<std::mutex> lock (queue.mutex);
+  queue.tasks.push_back (task);
 }
 
 /******************************************************************
  ******************************************************************/
 
+/**
+ * Withdraw the pieces offered by a call of solveCandidates that were
+ * not taken by the other threads.
+ *
+ * Parameter:
+ * frame - The call of solveCandidates.
+ */
 void
-makeIndices (int L, int W)
+dropTasks (long frame)
 {
+  TaskQueue &queue = lSearch->queues[lWorker];
+  std::lock_guard<std::mutex> lock (queue.mutex);
+  while (!queue.tasks.empty () && queue.tasks.back ().frame == frame)
+    {
+      queue.tasks.pop_back ();
+    }
+}
 
-  Set X, Y, raster;
-  constructRasterPoints (L, W, &X, &Y, normalSetX);
-
-  int j = 0;
-  int k = 0;
-  int i = 0;
+/******************************************************************
+ ******************************************************************/
 
-  raster = newSet (L + 2);
-  while (i < X.size && X.points[i] <= L && j < Y.size && Y.points[j] <= W)
+/**
+ * Take a piece offered by this thread or steal one offered by another
+ * thread of the parallel L-approach.
+ *
+ * Parameters:
+ * maxArea - Only pieces of area less than this are taken.
+ *
+ * task    - Receives the piece.
+ *
+ * Return:
+ * Whether a piece was taken.
+ */
+bool
+takeTask (int maxArea, PieceTask *task)
+{
+  int n = lSearch->numQueues;
+  for (int k = 0; k < n; k++)
     {
-
-      if (X.points[i] == Y.points[j])
-        {
-          raster.points[k++] = X.points[i++];
-          raster.size++;
-          j++;
-        }
-      else if (X.points[i] < Y.points[j])
+      TaskQueue &queue = lSearch->queues[(lWorker + k) % n];
+      std::lock_guard<std::mutex> lock (queue.mutex);
+      if (queue.tasks.empty ())
         {
-          raster.points[k++] = X.points[i++];
-          raster.size++;
+          continue;
         }
-      else
+      if (k == 0 && queue.tasks.back ().area < maxArea)
         {
-          raster.points[k++] = Y.points[j++];
-          raster.size++;
+          *task = queue.tasks.back ();
+          queue.tasks.pop_back ();
+          return true;
         }
-    }
-  while (i < X.size && X.points[i] <= L)
-    {
-      if (X.points[i] > raster.points[k - 1])
+      if (k > 0 && queue.tasks.front ().area < maxArea)
         {
-          raster.points[k++] = X.points[i];
-          raster.size++;
+          *task = queue.tasks.front ();
+          queue.tasks.pop_front ();
+          return true;
         }
-      i++;
-    }
-  if (k > 0 && raster.points[k - 1] < L)
-    {
-      raster.points[k++] = L;
-      raster.size++;
-    }
-  raster.points[k] = L + 1;
-  raster.size++;
-
-  try
-    {
-      indexRasterX = new int[L + 2];
-      indexRasterY = new int[W + 2];
-    }
-  catch (std::exception &e)
-    {
-      std::cout << "Error allocating memory." << std::endl;
-      exit (0);
     }
+  return false;
+}
 
-  j = 0;
-  numRasterX = 0;
-  for (int i = 0; i <= L; i++)
-    {
+/******************************************************************
+ ******************************************************************/
 
-      if (raster.points[j] == i)
-        {
-          indexRasterX[i] = numRasterX++;
-          j++;
-        }
-      else
-        {
-          indexRasterX[i] = indexRasterX[i - 1];
-        }
-    }
-  indexRasterX[L + 1] = indexRasterX[L] + 1;
+/**
+ * Claim an L-piece for this thread, so that no other thread of the
+ * parallel L-approach solves it too.
+ *
+ * Parameter:
+ * L - Index of the L-piece.
+ *
+ * Return:
+ * Whether the piece was free and is now claimed by this thread.
+ */
+inline bool
+claimPiece (int L)
+{
+  unsigned char expected = PIECE_FREE;
+  return __atomic_compare_exchange_n (&pieceState[L], &expected, PIECE_BUSY,
+                                      false, __ATOMIC_ACQUIRE,
+                                      __ATOMIC_RELAXED);
+}
 
-  j = 0;
-  numRasterY = 0;
-  for (int i = 0; i <= W; i++)
-    {
-      if (raster.points[j] == i)
-        {
-          indexRasterY[i] = numRasterY++;
-          j++;
-        }
-      else
-        {
-          indexRasterY[i] = indexRasterY[i - 1];
-        }
-    }
-  indexRasterY[W + 1] = indexRasterY[W] + 1;
+/******************************************************************
+ ******************************************************************/
 
-  free (raster.points);
-  free (X.points);
-  free (Y.points);
+/**
+ * Publish the solution of an L-piece claimed by this thread.
+ *
+ * Parameter:
+ * L - Index of the L-piece.
+ */
+inline void
+finishPiece (int L)
+{
+  __atomic_store_n (&pieceState[L], PIECE_DONE, __ATOMIC_RELEASE);
 }
 
 /******************************************************************
  ******************************************************************/
 
+/**
+ * Solve an offered piece, unless another thread already did or is
+ * doing it.
+ *
+ * Parameter:
+ * task - The piece.
+ */
 void
-freeMemory ()
+runTask (PieceTask *task)
 {
-  if (memory_type == MEM_TYPE_4)
+  if (claimPiece (task->L))
     {
-      delete[] solution;
-      delete[] divisionPoint;
-    }
-  else
-    {
-      delete[] solutionMap;
-      delete[] divisionPointMap;
+      solvePiece (task->L, 0, task->q);
+      finishPiece (task->L);
     }
-  delete[] indexRasterX;
-  delete[] indexRasterY;
 }
 
 /******************************************************************
  ******************************************************************/
 
+/**
+ * Wait until another thread solves an L-piece, solving smaller offered
+ * pieces meanwhile. As the pieces of a division are smaller than the
+ * divided piece, the threads never wait for each other in a cycle.
+ *
+ * Parameters:
+ * L    - Index of the L-piece.
+ *
+ * area - Area of the L-piece.
+ *
+ * Return:
+ * Whether the piece was solved (false if the search was cancelled).
+ */
 bool
-tryAllocateMemory (int size)
+waitPiece (int L, int area)
 {
-  try
-    {
-      solutionMap = new std::map<int, int>[size];
-    }
-  catch (std::exception &e)
+  while (__atomic_load_n (&pieceState[L], __ATOMIC_ACQUIRE) != PIECE_DONE)
     {
-      if (size == 0)
+      PieceTask task;
+      if (cancelled ())
         {
-          std::cout << "Error allocating memory." << std::endl;
-          exit (0);
+          return false;
         }
-      return false;
-    }
-  try
-    {
-      divisionPointMap = new std::map<int, int>[size];
-    }
-  catch (std::exception &e)
-    {
-      delete[] solutionMap;
-      delete[] divisionPointMap;
-      if (size == 0)
+      if (takeTask (area, &task))
         {
-          std::cout << "Error allocating memory." << std::endl;
-          exit (0);
+          runTask (&task);
+        }
+      else
+        {
+          sched_yield ();
         }
-      return false;
     }
   return true;
 }
@@ -1197,151 +933,2758 @@ tryAllocateMemory (int size)
 /******************************************************************
  ******************************************************************/
 
-void
-allocateMemory ()
+/**
+ * Return the solution of an L-piece in the parallel L-approach: the
+ * one already published, or the one computed by this thread if the
+ * piece is free, or the one computed by the thread that claimed it.
+ *
+ * Parameters:
+ * L - Index of the L-piece.
+ *
+ * q - The L-piece.
+ *
+ * Return:
+ * The solution of the L-piece.
+ */
+int
+solveShared (int L, int *q)
 {
-  memory_type = MEM_TYPE_4;
-
-  int nL = roundToNearest (
-      (pow ((double)numRasterX, ceil ((double)memory_type / 2.0))
-       * pow ((double)numRasterY, floor ((double)memory_type / 2.0))));
+  if (claimPiece (L))
+    {
+      int LSolution = solvePiece (L, 0, q);
+      finishPiece (L);
+      return LSolution;
+    }
+  if (!waitPiece (L, pieceArea (q)))
+    {
+      return 0;
+    }
+  return solution[L];
+}
 
-  memory_type--;
+/******************************************************************
+ ******************************************************************/
 
-  if (nL >= 0)
+/**
+ * Offer to the other threads of the parallel L-approach the free pieces
+ * of the first candidates of an L-piece, the first ones being taken
+ * back last by this thread.
+ *
+ * Parameters:
+ * pending - The candidates.
+ *
+ * first   - Index of the first candidate of the L-piece.
+ *
+ * Return:
+ * The identifier of the call of solveCandidates, for dropTasks.
+ */
+long
+shareCandidates (std::vector<Candidate> &pending, size_t first)
+{
+  long frame = ++lFrame;
+  size_t end = std::min (pending.size (), first + SHARED_CANDIDATES);
+  for (size_t i = end; i-- > first;)
     {
-      try
+      Candidate &c = pending[i];
+      if (__atomic_load_n (&pieceState[c.L2], __ATOMIC_RELAXED) == PIECE_FREE)
         {
-          solution = new int[nL];
-          try
-            {
-              divisionPoint = new int[nL];
-              for (int i = 0; i < nL; i++)
-                solution[i] = -1;
-            }
-          catch (std::exception &e)
-            {
-
-              delete[] solution;
-              do
-                {
-                  nL = roundToNearest (
-                      (pow ((double)numRasterX,
-                            ceil ((double)memory_type / 2.0))
-                       * pow ((double)numRasterY,
-                              floor ((double)memory_type / 2.0))));
-
-                  memory_type--;
-
-                  if (nL >= 0 && tryAllocateMemory (nL))
-                    {
-                      break;
-                    }
-                }
-              while (memory_type >= 0);
-            }
+          pushTask (c.L2, c.q2, frame);
         }
-      catch (std::exception &e)
+      if (__atomic_load_n (&pieceState[c.L1], __ATOMIC_RELAXED) == PIECE_FREE)
         {
-          do
-            {
-              nL = roundToNearest (
-                  (pow ((double)numRasterX, ceil ((double)memory_type / 2.0))
-                   * pow ((double)numRasterY,
-                          floor ((double)memory_type / 2.0))));
+          pushTask (c.L1, c.q1, frame);
+        }
+    }
+  return frame;
+}
 
-              memory_type--;
+/******************************************************************
+ ******************************************************************/
 
-              if (nL >= 0 && tryAllocateMemory (nL))
-                {
-                  break;
-                }
-            }
-          while (memory_type >= 0);
+/* Order of the candidates in solveCandidates. */
+inline bool
+morePromising (const Candidate &a, const Candidate &b)
+{
+  if (a.upperBound != b.upperBound)
+    {
+      return a.upperBound > b.upperBound;
+    }
+  return a.lowerBound > b.lowerBound;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Solve the candidate divisions of an L-piece, from the index first to
+ * the end of candidates, and remove them. The candidate with the best
+ * lower bound is solved first, so that the solution of the L-piece is
+ * at least that bound and the candidates which can not beat it are not
+ * solved. The others are then solved by decreasing upper bound, stopping
+ * at the first one that can not improve the solution.
+ *
+ * Parameters:
+ * L          - Index of the L-piece.
+ *
+ * key        - Key for this L-piece.
+ *
+ * B          - The subdivision of the candidates.
+ *
+ * first      - Index of the first candidate of this L-piece.
+ *
+ * LSolution  - Current solution of the L-piece.
+ *
+ * upperBound - Upper bound for the L-piece.
+ *
+ * Return:
+ * The solution of the L-piece.
+ */
+int
+solveCandidates (int L, int key, int B, size_t first, int LSolution,
+                 int upperBound)
+{
+  /* Thread-local objects are checked for initialization at every use. */
+  std::vector<Candidate> &pending = candidates;
+
+  if (pending.size () == first)
+    {
+      return LSolution;
+    }
+
+  size_t best = first;
+  for (size_t i = first + 1; i < pending.size (); i++)
+    {
+      if (pending[i].lowerBound > pending[best].lowerBound)
+        {
+          best = i;
         }
     }
-  else
+  std::swap (pending[first], pending[best]);
+
+  /* Drop the candidates screened before a better lower bound was found. */
+  int threshold = std::max (pending[first].lowerBound, LSolution & nRet);
+  size_t n = first + 1;
+  for (size_t i = first + 1; i < pending.size (); i++)
+    {
+      if (pending[i].upperBound > threshold)
+        {
+          pending[n++] = pending[i];
+        }
+    }
+  pending.resize (n);
+  std::sort (pending.begin () + first + 1, pending.end (), morePromising);
+
+  long frame = 0;
+  if (pieceState != NULL)
+    {
+      frame = shareCandidates (pending, first);
+    }
+
+  for (size_t i = first; i < pending.size (); i++)
     {
-      do
+      /* The recursion appends to candidates, so work on a copy. */
+      Candidate c = pending[i];
+      if (c.upperBound <= (LSolution & nRet))
+        {
+          if (i == first)
+            {
+              continue;
+            }
+          /* Neither can the ones after it. */
+          break;
+        }
+      if (cancelled ())
         {
-          nL = roundToNearest (
-              (pow ((double)numRasterX, ceil ((double)memory_type / 2.0))
-               * pow ((double)numRasterY, floor ((double)memory_type / 2.0))));
+          break;
+        }
 
-          memory_type--;
+      int L1Solution = solve (c.L1, c.q1);
+      int L2Solution = solve (c.L2, c.q2);
 
-          if (nL >= 0 && tryAllocateMemory (nL))
+      if ((L1Solution & nRet) + (L2Solution & nRet) > (LSolution & nRet))
+        {
+          /* A better solution was found. */
+          LSolution = ((L1Solution & nRet) + (L2Solution & nRet))
+                      | (B << descSol);
+          storeSolution (L, key, LSolution);
+          storeDivisionPoint (L, key, c.point);
+          if ((LSolution & nRet) == upperBound)
             {
               break;
             }
         }
-      while (memory_type >= 0);
     }
-  memory_type++;
+  if (pieceState != NULL)
+    {
+      dropTasks (frame);
+    }
+  pending.resize (first);
+  return LSolution;
 }
 
 /******************************************************************
  ******************************************************************/
 
-#ifdef __cplusplus
-extern "C" { // So that the C++ compiler does not rename our function names
-#endif
+/**
+ * Screen a division of an L-piece. A division whose pieces are already
+ * solved is evaluated right away; any other one that may improve the
+ * solution is kept as a candidate for solveCandidates.
+ *
+ * Parameters:
+ * L          - Index of the L-piece.
+ *
+ * key        - Key for this L-piece.
+ *
+ * B          - The subdivision.
+ *
+ * q1, q2     - The pieces of the division.
+ *
+ * point      - The division point, as stored by storeDivisionPoint.
+ *
+ * upperBound - Upper bound for the L-piece.
+ *
+ * LSolution  - Current solution of the L-piece, updated.
+ *
+ * lowerBound - Best lower bound of the candidates kept, updated.
+ *
+ * pending    - The candidates.
+ *
+ * Return:
+ * Whether the solution of the L-piece reached its upper bound, or the
+ * solution looked for by canonicalPiece().
+ */
+inline bool
+screenDivision (int L, int key, int B, int *q1, int *q2, int point,
+                int upperBound, int *LSolution, int *lowerBound,
+                std::vector<Candidate> &pending)
+{
+  int L1 = LIndex (q1[0], q1[1], q1[2], q1[3], memory_type);
+  int L2 = LIndex (q2[0], q2[1], q2[2], q2[3], memory_type);
 
-#ifdef __EMSCRIPTEN__
-  EMSCRIPTEN_KEEPALIVE
-#endif
-  const char* pack(int inL, int inW, int inl, int inw) {
-    printf("Beginning pack sequence\n");
-    int L, W;
-    int q[4];
-    int BD_solution;
-    int L_n, W_n;
-    bool swap = false;
+  if (canonicalTarget != 0)
+    {
+      /* The pieces not solved yet are solved as by the search. */
+      int target = canonicalTarget;
+      canonicalTarget = 0;
+      int sum = (solve (L1, q1) & nRet) + (solve (L2, q2) & nRet);
+      canonicalTarget = target;
+      if (sum == target)
+        {
+          *LSolution = sum | (B << descSol);
+          storeSolution (L, key, *LSolution);
+          storeDivisionPoint (L, key, point);
+          return true;
+        }
+      return false;
+    }
 
-    // int INDEX, L_solution;
-    L = inL;
-    W = inW;
-    l = inl;
-    w = inw;
+  int L1Solution = knownSolution (L1, q1);
+  int L2Solution = knownSolution (L2, q2);
 
-    if (L <= 0 || W <= 0 || l <= 0 || w <= 0) {
-      printf ("Invalid dimensions\n");
-      return NULL;
+  if (L1Solution != -1 && L2Solution != -1)
+    {
+      if ((L1Solution & nRet) + (L2Solution & nRet) > (*LSolution & nRet))
+        {
+          /* A better solution was found. */
+          *LSolution
+              = ((L1Solution & nRet) + (L2Solution & nRet)) | (B << descSol);
+          storeSolution (L, key, *LSolution);
+          storeDivisionPoint (L, key, point);
+          return (*LSolution & nRet) == upperBound;
+        }
+      return false;
     }
 
-    if (L < W) {
-      std::swap (L, W);
-      swap = true;
+  Candidate c;
+  c.upperBound
+      = (L1Solution != -1 ? L1Solution & nRet : pieceUpperBound (q1))
+        + (L2Solution != -1 ? L2Solution & nRet : pieceUpperBound (q2));
+  if (c.upperBound <= std::max (*LSolution & nRet, *lowerBound))
+    {
+      return false;
     }
 
-    memory_type = 5;
+  /* It is possible that this division gets a better solution. */
+  c.lowerBound
+      = (L1Solution != -1 ? L1Solution & nRet : pieceLowerBound (q1))
+        + (L2Solution != -1 ? L2Solution & nRet : pieceLowerBound (q2));
+  std::copy (q1, q1 + 4, c.q1);
+  std::copy (q2, q2 + 4, c.q2);
+  c.L1 = L1;
+  c.L2 = L2;
+  c.point = point;
+  pending.push_back (c);
+
+  /* Solving this division gets at least its lower bound, which the
+   * others have to beat. */
+  *lowerBound = std::max (*lowerBound, c.lowerBound);
+  return false;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Divide the L-piece in every possible way, according to the specified
+ * subdivision B. The divisions are screened by the bounds of their
+ * pieces before any of them is solved, see solveCandidates.
+ *
+ * Parameters:
+ * L                - Index of the L-piece.
+ *
+ * q                - The L-piece.
+ *
+ * constraints      - Constraints that determine the interval of x' and y'.
+ *
+ * B                - The subdivision, a parameter of the template so
+ *                    that its division is compiled inline.
+ *
+ * X                - Set of raster points.
+ *
+ * startX           - Index to start the divisions on the set X.
+ *
+ * Y                - Set of raster points.
+ *
+ * startY           - Index to start the divisions on the set Y.
+ */
+template <int B>
+int
+divideL (int L, int *q, int *constraints, Set X, int startX, Set Y,
+         int startY)
+{
+
+  /* i_k[0] <- x'
+   * i_k[1] <- y'
+   */
+  int i_k[2];
+  int i_x, i_y;
+  int q1[4], q2[4];
+
+  int key = 0;
+  int LSolution = getSolution (L, q, &key);
+  int upperBound = L_UpperBound (q);
+  const int *normalized = normalize;
+  int boxArea = l * w;
+  std::vector<Candidate> &pending = candidates;
+  size_t first = pending.size ();
+  int lowerBound = 0;
+
+  /* Screen every division first, then solve only the promising ones. */
+  for (i_x = startX; i_x < X.size; i_x++)
+    {
+
+      i_k[0] = X.points[i_x];
+      if (i_k[0] > constraints[1])
+        {
+          break;
+        }
 
-    /* Try to solve the problem with Algorithm 1. */
-    BD_solution = solve_BD (L, W, l, w, 0);
+      for (i_y = startY; i_y < Y.size; i_y++)
+        {
 
-    L_n = normalize[L];
-    W_n = normalize[W];
+          i_k[1] = Y.points[i_y];
+          if (i_k[1] > constraints[3])
+            {
+              break;
+            }
 
-    q[0] = q[2] = L_n;
-    q[1] = q[3] = W_n;
+          divide<B> (i_k, q, q1, q2, normalized, boxArea);
+          if (q1[0] < 0 || q2[0] < 0)
+            {
+              continue;
+            }
 
-    auto result = draw (L, W, 0, q, BD_solution, false, l, w, swap);
+          if (L_UpperBound (q1) + L_UpperBound (q2) <= (LSolution & nRet))
+            {
+              continue;
+            }
 
-    for (int i = 0; i < normalSetX.size; i++) {
-      free (lowerBound[i]);
-      free (upperBound[i]);
-      free (cutPoints[i]);
+          if (screenDivision (L, key, B, q1, q2,
+                              i_k[0] | (i_k[1] << descPtoDiv2), upperBound,
+                              &LSolution, &lowerBound, pending))
+            {
+              pending.resize (first);
+              return LSolution;
+            }
+        }
     }
+  return solveCandidates (L, key, B, first, LSolution, upperBound);
+}
 
-    delete[] lowerBound;
-    delete[] upperBound;
-    delete[] cutPoints;
-    delete[] indexX;
-    delete[] indexY;
-    delete[] normalize;
-    delete[] normalSetX.points;
+/******************************************************************
+ ******************************************************************/
 
-    return result.c_str();
+/**
+ * Divide the L-piece in every possible way, according to the B6
+ * subdivision. The divisions are screened as in divideL, and the pairs
+ * of outer coordinates whose divisions can not improve the solution are
+ * skipped as a whole.
+ *
+ * +-------------+--------+
+ * |             |        |
+ * |   (x',y')   |   L2   |
+ * |      o------o        |
+ * |      |  (x'',y')     |
+ * |  L1  |               |
+ * |      |               |
+ * +------+---------------+
+ *
+ * Parameters:
+ * L - Index of the L-piece.
+ *
+ * q - The L-piece.
+ *
+ * X - Set of raster points.
+ *
+ * Y - Set of raster points.
+ */
+int
+divideB6 (int L, int *q, Set X, Set Y)
+{
+
+  /* i_k[0] <- x'
+   * i_k[1] <- y'
+   * i_k[2] <- x''
+   */
+  int i_k[3];
+  int q1[4], q2[4];
+  int key = 0;
+  int LSolution = getSolution (L, q, &key);
+  int upperBound = R_UpperBound (q[0], q[1]);
+  const int *normalized = normalize;
+  int boxArea = l * w;
+  std::vector<Candidate> &pending = candidates;
+  size_t first = pending.size ();
+  int lowerBound = 0;
+
+  int i = 0;
+  for (i_k[0] = X.points[i]; i < X.size; i++)
+    {
+
+      i_k[0] = X.points[i];
+
+      int j = i;
+      for (i_k[2] = X.points[j]; j < X.size; j++)
+        {
+
+          i_k[2] = X.points[j];
+          if (i_k[0] == 0 && i_k[2] == 0)
+            {
+              continue;
+            }
+
+          /* Whatever y' is, L1 fits in the rectangle (x'', Y) and L2 in
+           * the rectangle (X - x', Y). */
+          if (R_UpperBound (i_k[2], q[1]) + R_UpperBound (q[0] - i_k[0], q[1])
+              <= std::max (LSolution & nRet, lowerBound))
+            {
+              continue;
+            }
+
+          int k = 0;
+          for (i_k[1] = Y.points[k]; k < Y.size; k++)
+            {
+
+              i_k[1] = Y.points[k];
+              divide<B6> (i_k, q, q1, q2, normalized, boxArea);
+              if (q1[0] < 0 || q2[0] < 0)
+                {
+                  continue;
+                }
+
+              if (L_UpperBound (q1) + L_UpperBound (q2) <= (LSolution & nRet))
+                {
+                  continue;
+                }
+
+              if (screenDivision (L, key, B6, q1, q2,
+                                  i_k[0] | (i_k[1] << descPtoDiv2)
+                                      | (i_k[2] << descPtoDiv3),
+                                  upperBound, &LSolution, &lowerBound,
+                                  pending))
+                {
+                  pending.resize (first);
+                  return LSolution;
+                }
+            }
+        }
+    }
+  return solveCandidates (L, key, B6, first, LSolution, upperBound);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Divide the L-piece in every possible way, according to the B7
+ * subdivision. The divisions are screened as in divideL, and the pairs
+ * of outer coordinates whose divisions can not improve the solution are
+ * skipped as a whole.
+ *
+ * +-------------+
+ * |             |
+ * |   (x',y'')  |
+ * |      o------+
+ * |      |      |
+ * |  L1  |  L2  |
+ * |      |      |
+ * +------o      |
+ * |   (x',y')   |
+ * |             |
+ * |             |
+ * +-------------+
+ *
+ * Parameters:
+ * L - Index of the L-piece.
+ *
+ * q - The L-piece.
+ *
+ * X - Set of raster points.
+ *
+ * Y - Set of raster points.
+ */
+int
+divideB7 (int L, int *q, Set X, Set Y)
+{
+
+  /* i_k[0] <- x'
+   * i_k[1] <- y'
+   * i_k[2] <- y''
+   */
+  int i_k[3];
+  int q1[4], q2[4];
+  int key = 0;
+  int LSolution = getSolution (L, q, &key);
+  int upperBound = R_UpperBound (q[0], q[1]);
+  const int *normalized = normalize;
+  int boxArea = l * w;
+  std::vector<Candidate> &pending = candidates;
+  size_t first = pending.size ();
+  int lowerBound = 0;
+
+  int j = 0;
+  for (i_k[1] = Y.points[j]; j < Y.size; j++)
+    {
+
+      i_k[1] = Y.points[j];
+
+      int k = j;
+      for (i_k[2] = Y.points[k]; k < Y.size; k++)
+        {
+
+          i_k[2] = Y.points[k];
+          if (i_k[1] == 0 && i_k[2] == 0)
+            {
+              continue;
+            }
+
+          /* Whatever x' is, L1 fits in the rectangle (X, Y - y') and L2
+           * in the rectangle (X, y''). */
+          if (R_UpperBound (q[0], q[1] - i_k[1]) + R_UpperBound (q[0], i_k[2])
+              <= std::max (LSolution & nRet, lowerBound))
+            {
+              continue;
+            }
+
+          int i = 0;
+          for (i_k[0] = X.points[i]; i < X.size; i++)
+            {
+
+              i_k[0] = X.points[i];
+              divide<B7> (i_k, q, q1, q2, normalized, boxArea);
+              if (q1[0] < 0 || q2[0] < 0)
+                {
+                  continue;
+                }
+
+              if (L_UpperBound (q1) + L_UpperBound (q2) <= (LSolution & nRet))
+                {
+                  continue;
+                }
+
+              if (screenDivision (L, key, B7, q1, q2,
+                                  i_k[0] | (i_k[1] << descPtoDiv2)
+                                      | (i_k[2] << descPtoDiv3),
+                                  upperBound, &LSolution, &lowerBound,
+                                  pending))
+                {
+                  pending.resize (first);
+                  return LSolution;
+                }
+            }
+        }
+    }
+  return solveCandidates (L, key, B7, first, LSolution, upperBound);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/* Subdivisions of the L-pieces that are not rectangles, in the order
+ * they are tried when nothing is known about the shape of a piece. */
+#define NUM_SUBDIVISIONS 7
+static const int subdivisions[NUM_SUBDIVISIONS]
+    = { B1, B3, B5, B2, B8, B4, B9 };
+
+/* The shapes of the L-pieces are classified by the ratios x/X and y/Y,
+ * each divided in SHAPE_BINS intervals, and the rectangles by the ratio
+ * Y/X, in SHAPE_BINS more classes. */
+#define SHAPE_BINS 4
+#define NUM_SHAPES (SHAPE_BINS * SHAPE_BINS + SHAPE_BINS)
+
+/* Number of pieces of each class of shapes whose solution was improved
+ * last by each subdivision (indexed by B1 ... B9), since the L-approach
+ * started on this thread. */
+__thread int subdivisionWins[NUM_SHAPES][B9 + 1];
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Return the class of the shape of an L-piece in the statistics of
+ * the subdivisions.
+ *
+ * Parameter:
+ * q - The L-piece, in the standard position.
+ */
+inline int
+shapeClass (const int *q)
+{
+  if (q[0] == q[2])
+    {
+      /* The standard position of a rectangle has Y <= X. */
+      return SHAPE_BINS * SHAPE_BINS + SHAPE_BINS * q[1] / (q[0] + 1);
+    }
+  return SHAPE_BINS * (SHAPE_BINS * q[2] / q[0]) + SHAPE_BINS * q[3] / q[1];
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Order the subdivisions of the L-pieces that are not rectangles by the
+ * number of pieces of a class of shapes they improved, keeping the
+ * default order between subdivisions with the same number.
+ *
+ * Parameters:
+ * shape - The class of shapes.
+ *
+ * order - Receives the NUM_SUBDIVISIONS subdivisions.
+ */
+void
+subdivisionOrder (int shape, int *order)
+{
+  const int *wins = subdivisionWins[shape];
+  for (int i = 0; i < NUM_SUBDIVISIONS; i++)
+    {
+      int B = subdivisions[i];
+      int j = i;
+      while (j > 0 && wins[order[j - 1]] < wins[B])
+        {
+          order[j] = order[j - 1];
+          j--;
+        }
+      order[j] = B;
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Divide an L-piece that is not a rectangle according to one of the
+ * subdivisions B1 ... B5, B8 and B9, over the interval of x' and y' of
+ * that subdivision.
+ *
+ * Parameters:
+ * B      - The subdivision.
+ *
+ * L      - Index of the L-piece.
+ *
+ * q      - The L-piece.
+ *
+ * X      - Set of raster points.
+ *
+ * startX - Index of the first point of X not less than x.
+ *
+ * Y      - Set of raster points.
+ *
+ * startY - Index of the first point of Y not less than y.
+ *
+ * Return:
+ * The solution of the L-piece.
+ */
+int
+divideFamily (int B, int L, int *q, Set X, int startX, Set Y, int startY)
+{
+  int constraints[4];
+
+  switch (B)
+    {
+    case B1:
+    case B3:
+    case B5:
+      /* 0 <= x' <= x  and  0 <= y' <= y */
+      constraints[0] = 0;
+      constraints[1] = q[2];
+      constraints[2] = 0;
+      constraints[3] = q[3];
+      break;
+
+    case B2:
+    case B8:
+      /* 0 <= x' <= x  and  y <= y' <= Y */
+      constraints[0] = 0;
+      constraints[1] = q[2];
+      constraints[2] = q[3];
+      constraints[3] = Y.points[Y.size - 1];
+      break;
+
+    default:
+      /* x <= x' <= X  and  0 <= y' <= y */
+      constraints[0] = q[2];
+      constraints[1] = X.points[X.size - 1];
+      constraints[2] = 0;
+      constraints[3] = q[3];
+      break;
+    }
+
+  switch (B)
+    {
+    case B1:
+      /* B1 subdivision.
+       *
+       * +------------+
+       * |            |
+       * |            |(x,y)
+       * |      +-----o-----+
+       * |  L1  |           |
+       * |      |     L2    |
+       * +------o           |
+       * |   (x',y')        |
+       * |                  |
+       * +------------------+
+       */
+      return divideL<B1> (L, q, constraints, X, 0, Y, 0);
+
+    case B3:
+      /* B3 subdivision.
+       *
+       * +------+-----+
+       * |      |     |
+       * |      |     |(x,y)
+       * |      | L2  o-----+
+       * |      |           |
+       * |  L1  |           |
+       * |      o-----------+
+       * |   (x',y')        |
+       * |                  |
+       * +------------------+
+       */
+      return divideL<B3> (L, q, constraints, X, 0, Y, 0);
+
+    case B5:
+      /* B5 subdivision.
+       *
+       * +------------+
+       * |            |
+       * |     L1     |(x,y)
+       * |            o-----+
+       * |   (x',y')  |     |
+       * |      o-----+     |
+       * |      |           |
+       * |      |     L2    |
+       * |      |           |
+       * +------+-----------+
+       */
+      return divideL<B5> (L, q, constraints, X, 0, Y, 0);
+
+    case B2:
+      /* B2 subdivision.
+       *
+       * +------------+
+       * |            |
+       * |   (x',y')  |
+       * +------o     |
+       * |      | L1  |
+       * |      |     |(x,y)
+       * |      +-----o-----+
+       * |  L2              |
+       * |                  |
+       * +------------------+
+       */
+      return divideL<B2> (L, q, constraints, X, 0, Y, startY);
+
+    case B8:
+      /* B8 subdivision.
+       *
+       * +------------+
+       * |            |
+       * |   (x',y')  |
+       * |      o-----+
+       * |      |     |
+       * |  L1  |     |(x,y)
+       * |      |     o-----+
+       * |      |  L2       |
+       * |      |           |
+       * +------+-----------+
+       */
+      return divideL<B8> (L, q, constraints, X, 0, Y, startY);
+
+    case B4:
+      /* B4 subdivision.
+       *
+       * +------+
+       * |      |
+       * |      |(x,y)
+       * |      o-----------+
+       * |  L1  |           |
+       * |      |  (x',y')  |
+       * |      +-----o     |
+       * |            | L2  |
+       * |            |     |
+       * +------------+-----+
+       */
+      return divideL<B4> (L, q, constraints, X, startX, Y, 0);
+
+    case B9:
+      /* B9 subdivision.
+       *
+       * +---------+
+       * |         |
+       * |         |(x,y)
+       * |   L1    o---+----+
+       * |             |    |
+       * |             |    |
+       * +-------------o    |
+       * |          (x',y') |
+       * |     L2           |
+       * |                  |
+       * +------------------+
+       */
+      return divideL<B9> (L, q, constraints, X, startX, Y, 0);
+    }
+  return -1;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Solve the problem of packing rectangular (l,w)-boxes into the
+ * specified L-shaped piece.
+ *
+ * Parameters:
+ * L - Index of the L-piece.
+ *
+ * q - The L-piece. q = {X, Y, x, y}.
+ */
+int
+solve (int L, int *q)
+{
+
+  int key = 0;
+  if (L < denseSize)
+    {
+      if (pieceState != NULL)
+        {
+          return solveShared (L, q);
+        }
+      if (solution[L] != -1)
+        {
+          /* This problem has already been solved. */
+          return solution[L];
+        }
+    }
+  else
+    {
+      key = getKey (q[0], q[1], q[2], q[3], memory_type);
+      if (solutionMap[L - denseSize].count (key) > 0)
+        {
+          /* This problem has already been solved. */
+          return solutionMap[L - denseSize][key];
+        }
+    }
+  return solvePiece (L, key, q);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Solve an L-piece that is not in the memory.
+ *
+ * Parameters:
+ * L   - Index of the L-piece.
+ *
+ * key - Key for this L-piece.
+ *
+ * q   - The L-piece.
+ *
+ * Return:
+ * The solution of the L-piece.
+ */
+int
+solvePiece (int L, int key, int *q)
+{
+  piecesSolved++;
+
+  if (q[0] != q[2])
+    {
+      bool horizontalCut;
+      int lowerBound = L_LowerBound (q, &horizontalCut);
+      int upperBound = L_UpperBound (q);
+      int LSolution = lowerBound | (B1 << descSol);
+
+      if (horizontalCut)
+        storeDivisionPoint (L, key, 0 | (q[3] << descPtoDiv2));
+      else
+        storeDivisionPoint (L, key, q[2] | (0 << descPtoDiv2));
+
+      storeSolution (L, key, LSolution);
+
+      /* Try to solve this problem with homogeneous packing (or other
+       * better solution already computed). */
+      if ((LSolution & nRet) != upperBound)
+        {
+          /* It was not possible to solve this problem with homogeneous
+           * packing. */
+          int startX = 0;
+          int startY = 0;
+
+          /* Construct the raster points sets X and Y. */
+          Set X, Y;
+          constructRasterPoints (q[0], q[1], &X, &Y, normalSetX);
+          for (startX = 0; X.points[startX] < q[2]; startX++)
+            ;
+          for (startY = 0; Y.points[startY] < q[3]; startY++)
+            ;
+
+          /* Raise the lower bound with the divisions that cut a
+           * rectangle from the L-piece, so that the bounds of the
+           * pieces screen more of the divisions below. */
+          int point;
+          int seed = L_DivisionLowerBound (q, X, startX, Y, startY,
+                                           LSolution & nRet, &point);
+          if (seed > (LSolution & nRet))
+            {
+              LSolution = seed | (B3 << descSol);
+              storeSolution (L, key, LSolution);
+              storeDivisionPoint (L, key, point);
+            }
+
+          /* Try the subdivisions that improved the most pieces of
+           * this shape first, to reach the upper bound sooner. */
+          int shape = shapeClass (q);
+          int order[NUM_SUBDIVISIONS];
+          int improvedBy = -1;
+          subdivisionOrder (shape, order);
+          for (int k = 0;
+               k < NUM_SUBDIVISIONS && (LSolution & nRet) != upperBound
+               && !cancelled ();
+               k++)
+            {
+              int before = LSolution & nRet;
+              LSolution
+                  = divideFamily (order[k], L, q, X, startX, Y, startY);
+              if ((LSolution & nRet) > before)
+                {
+                  improvedBy = order[k];
+                }
+              if ((LSolution & nRet) == upperBound)
+                {
+                  break;
+                }
+            }
+          if (improvedBy != -1)
+            {
+              subdivisionWins[shape][improvedBy]++;
+            }
+          free (X.points);
+          free (Y.points);
+        }
+      return LSolution;
+    } /* if q[0] != q[2] */
+  else
+    {
+      /* Degenerated L (a rectangle) */
+
+      int LSolution = R_LowerBound (q[0], q[1]) | (HOMOGENEOUS << descSol);
+      int upperBound = R_UpperBound (q[0], q[1]);
+      storeSolution (L, key, LSolution);
+
+      /* Verify whether it could not be solved with homogeneous packing. */
+      if ((LSolution & nRet) != upperBound)
+        {
+
+          /* Construct the raster points sets X and Y. */
+          Set X, Y;
+          constructRasterPoints (q[0], q[1], &X, &Y, normalSetX);
+
+          /* Try the subdivisions B6 and B7, the one that improved the
+           * most rectangles of this shape first. */
+          int shape = shapeClass (q);
+          int order[2] = { B6, B7 };
+          int improvedBy = -1;
+          if (subdivisionWins[shape][B7] > subdivisionWins[shape][B6])
+            {
+              std::swap (order[0], order[1]);
+            }
+          for (int k = 0; k < 2 && !cancelled (); k++)
+            {
+              int before = LSolution & nRet;
+              if (order[k] == B6)
+                {
+                  /* B6 subdivision.
+                   *
+                   * +-------------+--------+
+                   * |             |        |
+                   * |   (x',y')   |   L2   |
+                   * |      o------o        |
+                   * |      |  (x'',y')     |
+                   * |  L1  |               |
+                   * |      |               |
+                   * +------+---------------+
+                   */
+                  LSolution = divideB6 (L, q, X, Y);
+                }
+              else
+                {
+                  /* B7 subdivision.
+                   *
+                   * +-------------+
+                   * |             |
+                   * |   (x',y'')  |
+                   * |      o------+
+                   * |      |      |
+                   * |  L1  |  L2  |
+                   * |      |      |
+                   * +------o      |
+                   * |   (x',y')   |
+                   * |             |
+                   * |             |
+                   * +-------------+
+                   */
+                  LSolution = divideB7 (L, q, X, Y);
+                }
+              if ((LSolution & nRet) > before)
+                {
+                  improvedBy = order[k];
+                }
+              if ((LSolution & nRet) == upperBound)
+                {
+                  break;
+                }
+            }
+          if (improvedBy != -1)
+            {
+              subdivisionWins[shape][improvedBy]++;
+            }
+
+          free (X.points);
+          free (Y.points);
+
+          /* Update the lower bound for this rectangular piece. The
+           * deterministic search leaves the bounds of Algorithm 1, read
+           * by the other threads, as they were (see canonicalPiece()). */
+          if (!deterministic ())
+            {
+              __atomic_store_n (&lowerBound[indexX[q[0]]][indexY[q[1]]],
+                                LSolution & nRet, __ATOMIC_RELAXED);
+              if ((LSolution & solucao) >> descSol != HOMOGENEOUS)
+                {
+                  /* The cut of Algorithm 1 no longer packs it. */
+                  cutPoints[indexX[q[0]]][indexY[q[1]]].lApproach = 1;
+                }
+            }
+        }
+      return LSolution;
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+void
+makeIndices (int L, int W)
+{
+
+  Set X, Y, raster;
+  constructRasterPoints (L, W, &X, &Y, normalSetX);
+
+  int j = 0;
+  int k = 0;
+  int i = 0;
+
+  raster = newSet (L + 2);
+  while (i < X.size && X.points[i] <= L && j < Y.size && Y.points[j] <= W)
+    {
+
+      if (X.points[i] == Y.points[j])
+        {
+          raster.points[k++] = X.points[i++];
+          raster.size++;
+          j++;
+        }
+      else if (X.points[i] < Y.points[j])
+        {
+          raster.points[k++] = X.points[i++];
+          raster.size++;
+        }
+      else
+        {
+          raster.points[k++] = Y.points[j++];
+          raster.size++;
+        }
+    }
+  while (i < X.size && X.points[i] <= L)
+    {
+      if (X.points[i] > raster.points[k - 1])
+        {
+          raster.points[k++] = X.points[i];
+          raster.size++;
+        }
+      i++;
+    }
+  if (k > 0 && raster.points[k - 1] < L)
+    {
+      raster.points[k++] = L;
+      raster.size++;
+    }
+  raster.points[k] = L + 1;
+  raster.size++;
+
+  try
+    {
+      indexRasterX = new int[L + 2];
+      indexRasterY = new int[W + 2];
+    }
+  catch (std::exception &e)
+    {
+      std::cout << "Error allocating memory." << std::endl;
+      exit (0);
+    }
+
+  j = 0;
+  numRasterX = 0;
+  for (int i = 0; i <= L; i++)
+    {
+
+      if (raster.points[j] == i)
+        {
+          indexRasterX[i] = numRasterX++;
+          j++;
+        }
+      else
+        {
+          indexRasterX[i] = indexRasterX[i - 1];
+        }
+    }
+  indexRasterX[L + 1] = indexRasterX[L] + 1;
+
+  j = 0;
+  numRasterY = 0;
+  for (int i = 0; i <= W; i++)
+    {
+      if (raster.points[j] == i)
+        {
+          indexRasterY[i] = numRasterY++;
+          j++;
+        }
+      else
+        {
+          indexRasterY[i] = indexRasterY[i - 1];
+        }
+    }
+  indexRasterY[W + 1] = indexRasterY[W] + 1;
+
+  free (raster.points);
+  free (X.points);
+  free (Y.points);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+void
+freeMemory ()
+{
+  if (denseSize > 0)
+    {
+      delete[] solution;
+      delete[] divisionPoint;
+    }
+  if (memory_type != MEM_TYPE_4)
+    {
+      delete[] solutionMap;
+      delete[] divisionPointMap;
+    }
+  delete[] indexRasterX;
+  delete[] indexRasterY;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+bool
+tryAllocateMemory (int size)
+{
+  try
+    {
+      solutionMap = new std::unordered_map<int, int>[size];
+    }
+  catch (std::exception &e)
+    {
+      if (size == 0)
+        {
+          std::cout << "Error allocating memory." << std::endl;
+          exit (0);
+        }
+      return false;
+    }
+  try
+    {
+      divisionPointMap = new std::unordered_map<int, int>[size];
+    }
+  catch (std::exception &e)
+    {
+      delete[] solutionMap;
+      delete[] divisionPointMap;
+      if (size == 0)
+        {
+          std::cout << "Error allocating memory." << std::endl;
+          exit (0);
+        }
+      return false;
+    }
+  return true;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Allocate the arrays solution and divisionPoint for size L-pieces,
+ * none of them solved.
+ *
+ * Return:
+ * - true if the memory was allocated, false otherwise.
+ */
+bool
+tryAllocateArrays (int size)
+{
+  try
+    {
+      solution = new int[size];
+    }
+  catch (std::exception &e)
+    {
+      return false;
+    }
+  try
+    {
+      divisionPoint = new int[size];
+    }
+  catch (std::exception &e)
+    {
+      delete[] solution;
+      return false;
+    }
+  for (int i = 0; i < size; i++)
+    solution[i] = -1;
+  denseSize = size;
+  return true;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Allocate the memory of MEM_TYPE_HYBRID: an array for the L-pieces
+ * whose indices in the raster points are less than numDenseX and
+ * numDenseY, with at most HYBRID_DENSE_SIZE L-pieces, and hash maps
+ * for the others.
+ *
+ * Return:
+ * - true if the memory was allocated, false otherwise.
+ */
+bool
+tryAllocateHybrid ()
+{
+  if ((double)numRasterX * numRasterY > INT_MAX / 2)
+    {
+      return false;
+    }
+
+  /* Keep the proportion of the raster points in the dense part. */
+  double scale = sqrt (sqrt ((double)HYBRID_DENSE_SIZE
+                             / ((double)numRasterX * numRasterX
+                                * numRasterY * numRasterY)));
+  numDenseX = std::max (1, std::min (numRasterX, (int)(numRasterX * scale)));
+  numDenseY = std::max (1, std::min (numRasterY, (int)(numRasterY * scale)));
+
+  if (!tryAllocateArrays (numDenseX * numDenseX * numDenseY * numDenseY))
+    {
+      return false;
+    }
+  try
+    {
+      solutionMap = new std::unordered_map<int, int>[numRasterX * numRasterY];
+    }
+  catch (std::exception &e)
+    {
+      delete[] solution;
+      delete[] divisionPoint;
+      denseSize = 0;
+      return false;
+    }
+  try
+    {
+      divisionPointMap
+          = new std::unordered_map<int, int>[numRasterX * numRasterY];
+    }
+  catch (std::exception &e)
+    {
+      delete[] solution;
+      delete[] divisionPoint;
+      delete[] solutionMap;
+      denseSize = 0;
+      return false;
+    }
+  memory_type = MEM_TYPE_HYBRID;
+  return true;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Allocate the memory of the L-pieces. The 4-dimensional array is
+ * preferred, then MEM_TYPE_HYBRID and then the maps of decreasing
+ * dimensions.
+ */
+void
+allocateMemory ()
+{
+  memory_type = MEM_TYPE_4;
+  denseSize = 0;
+
+  int nL = roundToNearest (
+      (pow ((double)numRasterX, ceil ((double)memory_type / 2.0))
+       * pow ((double)numRasterY, floor ((double)memory_type / 2.0))));
+
+  if (nL >= 0 && tryAllocateArrays (nL))
+    {
+      return;
+    }
+  if (tryAllocateHybrid ())
+    {
+      return;
+    }
+
+  memory_type--;
+  do
+    {
+      nL = roundToNearest (
+          (pow ((double)numRasterX, ceil ((double)memory_type / 2.0))
+           * pow ((double)numRasterY, floor ((double)memory_type / 2.0))));
+
+      memory_type--;
+
+      if (nL >= 0 && tryAllocateMemory (nL))
+        {
+          break;
+        }
+    }
+  while (memory_type >= 0);
+  memory_type++;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Set the boxes of the problem and check the dimensions of the
+ * problem of packing (inl,inw)-boxes into the (inL,inW) pallet.
+ *
+ * Parameters:
+ * inL, inW - Dimensions of the pallet.
+ * inl, inw - Dimensions of the boxes.
+ * L, W     - Receive the dimensions of the pallet, with L >= W.
+ * swap     - Receives whether the dimensions of the pallet were swapped.
+ *
+ * Return:
+ * - false if some dimension is invalid, true otherwise.
+ */
+static bool
+setPallet (int inL, int inW, int inl, int inw, int *L, int *W, bool *swap)
+{
+  *L = inL;
+  *W = inW;
+  l = inl;
+  w = inw;
+  *swap = false;
+
+  if (*L <= 0 || *W <= 0 || l <= 0 || w <= 0)
+    {
+      printf ("Invalid dimensions\n");
+      return false;
+    }
+
+  if (*L < *W)
+    {
+      std::swap (*L, *W);
+      *swap = true;
+    }
+
+  memory_type = 5;
+  return true;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/* Precomputed solutions loaded by pack_load_table(), shared by all
+ * the threads. */
+static SolutionTable *solutionTable = NULL;
+
+/* Packing of a neighbouring problem given by pack_seed(), as blocks in
+ * the coordinates of the pallet with L >= W, and whether the next
+ * packing of the thread starts from it. */
+static thread_local std::vector<Block> threadSeed;
+static thread_local bool seedPending = false;
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Solve the problem of packing (inl,inw)-boxes into the (inL,inW)
+ * pallet, looking it up in the solution table first and using
+ * Algorithm 1 otherwise. The tables of the problem are taken from the
+ * table pool selected by the thread and stay there for the next
+ * problems.
+ *
+ * Parameters are the same as in setPallet(), plus:
+ * blocks - Receives the blocks of the solution if it is found in the
+ *          solution table, or NULL to look up its number of boxes only.
+ *
+ * precomputed - Receives whether the solution was found in the table.
+ *
+ * Return:
+ * - the number of boxes packed, or -1 if some dimension is invalid.
+ */
+static int
+solvePallet (int inL, int inW, int inl, int inw, int *L, int *W, bool *swap,
+             std::vector<Block> *blocks, bool *precomputed)
+{
+  *precomputed = false;
+  if (!setPallet (inL, inW, inl, inw, L, W, swap))
+    {
+      return -1;
+    }
+
+  /* The seed serves this packing only. */
+  const std::vector<Block> *seed = seedPending ? &threadSeed : NULL;
+  seedPending = false;
+
+  if (solutionTable != NULL)
+    {
+      int n = lookupSolution (solutionTable, *L, *W, l, w, blocks);
+      if (n >= 0)
+        {
+          *precomputed = true;
+          return n;
+        }
+    }
+
+  /* Try to solve the problem with Algorithm 1. */
+  return solve_BD (*L, *W, l, w, 0, seed);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/* A pallet of pack_best_pallet() and the number of boxes packed. */
+struct RankedPallet
+{
+  int pallet;
+  int count;
+  long area;
+};
+
+/**
+ * Order of the pallets of pack_best_pallet(): the most boxes first and,
+ * among pallets with as many boxes, the smallest one.
+ */
+static bool
+betterPallet (const RankedPallet &a, const RankedPallet &b)
+{
+  if (a.count != b.count)
+    {
+      return a.count > b.count;
+    }
+  return a.area < b.area;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/* Number of cuts tried by solveBlocks() between two checks of the time
+ * of its next checkpoint. */
+#define CHECKPOINT_STEP 4096
+
+int
+solveBlocks (int L, int W, int inl, int inw, std::vector<Block> *blocks,
+             const char *checkpoint, int interval)
+{
+  bool swap;
+
+  if (!setPallet (L, W, inl, inw, &L, &W, &swap) || swap)
+    {
+      return -1;
+    }
+
+  if (checkpoint == NULL)
+    {
+      solve_BD (L, W, l, w, 0);
+    }
+  else
+    {
+      /* Search in steps, continuing the checkpoint if there is one. */
+      BDSearch *search = resume_BD (L, W, l, w, 0, checkpoint);
+      if (search == NULL)
+        {
+          search = start_BD (L, W, l, w, 0);
+        }
+      time_t last = time (NULL);
+      while (!step_BD (search, CHECKPOINT_STEP))
+        {
+          if (time (NULL) - last >= interval)
+            {
+              save_BD (search, checkpoint);
+              last = time (NULL);
+            }
+        }
+      finish_BD (search);
+      if (!cancelled ())
+        {
+          remove (checkpoint);
+        }
+    }
+  if (cancelled ())
+    {
+      return -1;
+    }
+  return drawBlocks (normalize[L], normalize[W], blocks);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Task of the threads of the parallel L-approach. The first thread
+ * solves the root piece, the others solve the pieces offered until the
+ * root is solved.
+ *
+ * Parameters:
+ * id  - Identifier of the thread.
+ *
+ * arg - The search (LSearch).
+ */
+void
+lSearchWorker (int id, void *arg)
+{
+  LSearch *search = (LSearch *)arg;
+
+  if (id != 0)
+    {
+      /* Share the state of the thread that started the search. */
+      l = search->l;
+      w = search->w;
+      memory_type = search->memory_type;
+      denseSize = search->denseSize;
+      lowerBound = search->lowerBound;
+      upperBound = search->upperBound;
+      cutPoints = search->cutPoints;
+      indexX = search->indexX;
+      indexY = search->indexY;
+      normalize = search->normalize;
+      normalSetX = search->normalSetX;
+      indexRasterX = search->indexRasterX;
+      indexRasterY = search->indexRasterY;
+      numRasterX = search->numRasterX;
+      numRasterY = search->numRasterY;
+      solution = search->solution;
+      divisionPoint = search->divisionPoint;
+      setCancelToken (&search->stop);
+      memset (subdivisionWins, 0, sizeof (subdivisionWins));
+    }
+
+  lSearch = search;
+  lWorker = id;
+  pieceState = search->pieceState;
+
+  if (id == 0)
+    {
+      search->LSolution = solve (search->L, search->q);
+      search->stop.store (1);
+    }
+  else
+    {
+      long solved = piecesSolved;
+      PieceTask task;
+      while (search->stop.load () == 0)
+        {
+          if (takeTask (INT_MAX, &task))
+            {
+              runTask (&task);
+            }
+          else
+            {
+              sched_yield ();
+            }
+        }
+      search->pieces += piecesSolved - solved;
+      setCancelToken (NULL);
+    }
+
+  pieceState = NULL;
+  lSearch = NULL;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Solve the root L-piece with the threads of the pool, which share the
+ * memory of the L-pieces. Every piece is solved by a single thread: the
+ * others wait for it, so the solution is the same as on a single
+ * thread.
+ *
+ * Parameters:
+ * L      - Index of the L-piece.
+ *
+ * q      - The L-piece.
+ *
+ * pieces - Receives the number of L-pieces solved by the threads other
+ *          than the calling one.
+ *
+ * Return:
+ * The solution of the L-piece, or -1 if there is not enough memory for
+ * the states of the pieces.
+ */
+int
+solveParallel (int L, int *q, long *pieces)
+{
+  LSearch search;
+  long size = (long)numRasterX * numRasterX * numRasterY * numRasterY;
+
+  try
+    {
+      search.pieceState = new unsigned char[size]();
+    }
+  catch (std::exception &e)
+    {
+      return -1;
+    }
+
+  search.l = l;
+  search.w = w;
+  search.memory_type = memory_type;
+  search.denseSize = denseSize;
+  search.lowerBound = lowerBound;
+  search.upperBound = upperBound;
+  search.cutPoints = cutPoints;
+  search.indexX = indexX;
+  search.indexY = indexY;
+  search.normalize = normalize;
+  search.normalSetX = normalSetX;
+  search.indexRasterX = indexRasterX;
+  search.indexRasterY = indexRasterY;
+  search.numRasterX = numRasterX;
+  search.numRasterY = numRasterY;
+  search.solution = solution;
+  search.divisionPoint = divisionPoint;
+  search.L = L;
+  std::copy (q, q + 4, search.q);
+  search.numQueues = numWorkers ();
+  search.queues = new TaskQueue[search.numQueues];
+  search.stop.store (0);
+  search.pieces.store (0);
+
+  runOnWorkers (lSearchWorker, &search, search.numQueues);
+  *pieces = search.pieces.load ();
+
+  delete[] search.queues;
+  delete[] search.pieceState;
+  return search.LSolution;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Divide an L-piece at a stored division point.
+ *
+ * Parameters:
+ * B      - The subdivision.
+ *
+ * point  - The division point, as stored by storeDivisionPoint.
+ *
+ * q      - The L-piece.
+ *
+ * q1, q2 - Receive the pieces of the division.
+ */
+static void
+divideAt (int B, int point, int *q, int *q1, int *q2)
+{
+  int i[3];
+  i[0] = point & ptoDiv1;
+  i[1] = (point & ptoDiv2) >> descPtoDiv2;
+  i[2] = ((unsigned int)point & ptoDiv3) >> descPtoDiv3;
+
+  switch (B)
+    {
+    case B1:
+      divide<B1> (i, q, q1, q2, normalize, l * w);
+      break;
+    case B2:
+      divide<B2> (i, q, q1, q2, normalize, l * w);
+      break;
+    case B3:
+      divide<B3> (i, q, q1, q2, normalize, l * w);
+      break;
+    case B4:
+      divide<B4> (i, q, q1, q2, normalize, l * w);
+      break;
+    case B5:
+      divide<B5> (i, q, q1, q2, normalize, l * w);
+      break;
+    case B6:
+      divide<B6> (i, q, q1, q2, normalize, l * w);
+      break;
+    case B7:
+      divide<B7> (i, q, q1, q2, normalize, l * w);
+      break;
+    case B8:
+      divide<B8> (i, q, q1, q2, normalize, l * w);
+      break;
+    default:
+      divide<B9> (i, q, q1, q2, normalize, l * w);
+      break;
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Choose again the division of a piece of the solution of the
+ * L-approach, and of the pieces of that division, so that the pattern
+ * does not depend on the order in which the threads solved them. The
+ * solutions of the pieces do not depend on it, since the divisions are
+ * discarded only by their bounds: the division chosen is the first one
+ * that gives the solution of the piece, in the order in which solve()
+ * tries them with the default order of the subdivisions. The
+ * rectangles packed better than by Algorithm 1 are appended to raised,
+ * to get their lower bounds raised once every piece is chosen.
+ *
+ * Parameters:
+ * L       - Index of the piece.
+ *
+ * q       - The piece.
+ *
+ * visited - Indices and keys of the pieces already chosen.
+ *
+ * raised  - Receives the length, the width and the solution of each
+ *           rectangle packed better than by Algorithm 1.
+ */
+static void
+canonicalPiece (int L, int *q, std::unordered_set<long long> &visited,
+                std::vector<int> &raised)
+{
+  if (cancelled ())
+    {
+      return;
+    }
+
+  int key = 0;
+  int target = solve (L, q) & nRet;
+  int found = getSolution (L, q, &key);
+  if (!visited.insert (((long long)L << 32) | (unsigned int)key).second)
+    {
+      return;
+    }
+
+  bool horizontalCut;
+  if (q[0] == q[2] && R_LowerBound (q[0], q[1]) >= target)
+    {
+      /* Packed by Algorithm 1. */
+      storeSolution (L, key, target | (HOMOGENEOUS << descSol));
+      return;
+    }
+  if (q[0] != q[2] && L_LowerBound (q, &horizontalCut) >= target)
+    {
+      /* The rectangles of the lower bound, as in solvePiece(). */
+      storeSolution (L, key, target | (B1 << descSol));
+      storeDivisionPoint (L, key,
+                         horizontalCut ? q[3] << descPtoDiv2 : q[2]);
+    }
+  else
+    {
+      /* Make every division that gives the solution better than the
+       * one in the memory. */
+      storeSolution (L, key, target - 1);
+      canonicalTarget = target;
+
+      Set X, Y;
+      int startX, startY;
+      constructRasterPoints (q[0], q[1], &X, &Y, normalSetX);
+      for (startX = 0; X.points[startX] < q[2]; startX++)
+        ;
+      for (startY = 0; Y.points[startY] < q[3]; startY++)
+        ;
+
+      int LSolution = target - 1;
+      if (q[0] == q[2])
+        {
+          LSolution = divideB6 (L, q, X, Y);
+          if ((LSolution & nRet) != target)
+            {
+              LSolution = divideB7 (L, q, X, Y);
+            }
+        }
+      else
+        {
+          for (int k = 0; k < NUM_SUBDIVISIONS; k++)
+            {
+              LSolution = divideFamily (subdivisions[k], L, q, X, startX, Y,
+                                        startY);
+              if ((LSolution & nRet) == target)
+                {
+                  break;
+                }
+            }
+        }
+      canonicalTarget = 0;
+      free (X.points);
+      free (Y.points);
+
+      if ((LSolution & nRet) != target)
+        {
+          /* Only if the search was cancelled. */
+          storeSolution (L, key, found);
+          return;
+        }
+      if (q[0] == q[2])
+        {
+          raised.push_back (q[0]);
+          raised.push_back (q[1]);
+          raised.push_back (target);
+        }
+    }
+
+  int q1[4], q2[4];
+  int point = (L < denseSize) ? divisionPoint[L]
+                              : divisionPointMap[L - denseSize][key];
+  divideAt ((getSolution (L, q, &key) & solucao) >> descSol, point, q, q1,
+            q2);
+  if (q1[0] >= 0)
+    {
+      canonicalPiece (LIndex (q1[0], q1[1], q1[2], q1[3], memory_type), q1,
+                      visited, raised);
+    }
+  if (q2[0] >= 0)
+    {
+      canonicalPiece (LIndex (q2[0], q2[1], q2[2], q2[3], memory_type), q2,
+                      visited, raised);
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+solve_L (int inL, int inW, int inl, int inw, long *pieces,
+         std::vector<float> *positions)
+{
+  int L, W, q[4];
+  bool swap;
+
+  if (!setPallet (inL, inW, inl, inw, &L, &W, &swap))
+    {
+      return -1;
+    }
+
+  /* The bounds of the rectangles come from Algorithm 1. */
+  solve_BD (L, W, l, w, 0);
+
+  q[0] = q[2] = normalize[L];
+  q[1] = q[3] = normalize[W];
+
+  makeIndices (L, W);
+  allocateMemory ();
+
+  piecesSolved = 0;
+  memset (subdivisionWins, 0, sizeof (subdivisionWins));
+  int root = LIndex (q[0], q[1], q[2], q[3], memory_type);
+  int LSolution = -1;
+  long others = 0;
+
+  /* The memory of the L-pieces is shared by the threads only when it is
+   * an array. */
+  if (numWorkers () > 1 && memory_type == MEM_TYPE_4)
+    {
+      LSolution = solveParallel (root, q, &others);
+    }
+  if (LSolution == -1)
+    {
+      LSolution = solve (root, q);
+    }
+
+  if (deterministic ())
+    {
+      /* Choose the pattern of the pallet, and only then raise the
+       * bounds of its rectangles for Algorithm 1. */
+      std::unordered_set<long long> visited;
+      std::vector<int> raised;
+      canonicalPiece (root, q, visited, raised);
+      for (size_t i = 0; i < raised.size (); i += 3)
+        {
+          int x = indexX[raised[i]], y = indexY[raised[i + 1]];
+          lowerBound[x][y] = raised[i + 2];
+          cutPoints[x][y].lApproach = 1;
+        }
+    }
+  *pieces = piecesSolved + others;
+
+  /* The L-approach raised the lower bounds of the rectangles it packs
+   * better, the pallet among them, and Algorithm 1 combines them in
+   * its cuts. */
+  int solution = refine_BD (L, W, l, w);
+
+  if (positions != NULL && !cancelled ())
+    {
+      /* The pattern may place more boxes than the bound of the pallet
+       * (see drawSolution()); they are all part of the solution. */
+      positions->resize (3 * maxBoxes (q, solution));
+      int drawn = drawPositions (L, W, root, q, solution, true, l, w, swap,
+                                 positions->data ());
+      if (!cancelled ())
+        {
+          solution = drawn;
+          positions->resize (3 * solution);
+        }
+    }
+
+  freeMemory ();
+  return solution;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+solve_L (int L, int W, int l, int w, long *pieces)
+{
+  return solve_L (L, W, l, w, pieces, NULL);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Give back the memory of the own table pool of a worker.
+ */
+static void
+trimWorker (int id, void *arg)
+{
+  trimTables ();
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/* A packing solved step by step by pack_start() and pack_step(). */
+struct PackJob
+{
+  BDSearch *search;
+  int L, W, l, w;
+  bool swap;
+
+  /* Cancellation token of the thread when the packing started. */
+  std::atomic<int> *token;
+
+  /* Pool of the tables of the packing, apart from the tables of the
+   * thread so that other packings can run between its steps. */
+  TablePool *tables;
+
+  /* Boxes of the solution, once drawn by pack_result(). */
+  std::string result;
+};
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Start a packing of (inl,inw)-boxes into the (inL,inW) pallet, with
+ * tables of its own, for pack_start() and pack_resume().
+ *
+ * Parameters:
+ * checkpoint - Checkpoint of the search to continue (see save_BD()),
+ *              or NULL to start a new search.
+ *
+ * Return:
+ * - the packing, or NULL if some dimension is invalid or the checkpoint
+ *   cannot be continued.
+ */
+static PackJob *
+startJob (int inL, int inW, int inl, int inw, const char *checkpoint)
+{
+  int L, W;
+  bool swap;
+
+  if (!setPallet (inL, inW, inl, inw, &L, &W, &swap))
+    {
+      return NULL;
+    }
+
+  PackJob *job = new PackJob;
+  job->L = L;
+  job->W = W;
+  job->l = l;
+  job->w = w;
+  job->swap = swap;
+  job->token = cancelToken;
+  job->tables = newTablePool ();
+  setTablePool (job->tables);
+  job->search = (checkpoint != NULL)
+                    ? resume_BD (L, W, l, w, 0, checkpoint)
+                    : start_BD (L, W, l, w, 0);
+  setTablePool (NULL);
+
+  if (job->search == NULL)
+    {
+      deleteTablePool (job->tables);
+      delete job;
+      return NULL;
+    }
+  return job;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/* Packings of problems changed a little at a time, solved by
+ * pack_again() from the tables of the previous one. */
+struct PackSession
+{
+  BDHistory *history;
+
+  /* Last problem given, as given, and its boxes. */
+  int L, W, l, w;
+  std::string result;
+};
+
+/******************************************************************
+ ******************************************************************/
+
+#ifdef __cplusplus
+extern "C" { // So that the C++ compiler does not rename our function names
+#endif
+
+  /**
+   * Pack (inl,inw)-boxes into the (inL,inW) pallet and return the
+   * boxes as a JSON array of {x, y, rotated} objects, or NULL if some
+   * dimension is invalid or the packing was cancelled (see
+   * pack_set_token()). The string is owned by the calling thread and
+   * stays valid until its next call to pack().
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  const char* pack(int inL, int inW, int inl, int inw) {
+    static thread_local std::string result;
+    static thread_local std::vector<Block> blocks;
+    printf("Beginning pack sequence\n");
+    int L, W;
+    int q[4];
+    int BD_solution;
+    bool swap, precomputed;
+
+    BD_solution = solvePallet (inL, inW, inl, inw, &L, &W, &swap, &blocks,
+                               &precomputed);
+    if (BD_solution < 0) {
+      return NULL;
+    }
+    if (precomputed) {
+      result = draw (blocks, BD_solution, l, w, swap);
+      return result.c_str();
+    }
+
+    q[0] = q[2] = normalize[L];
+    q[1] = q[3] = normalize[W];
+
+    result = draw (L, W, 0, q, BD_solution, false, l, w, swap);
+
+    if (cancelled ()) {
+      return NULL;
+    }
+    return result.c_str();
+  }
+
+  /**
+   * Same as pack(), but return the boxes as floats: the number of
+   * boxes n followed by n triples {x, y, rotated}, rotated being 1 or
+   * 0. Meant to be copied out of the heap into a transferable buffer.
+   * The array is owned by the calling thread and stays valid until its
+   * next call to pack_buffer().
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  const float* pack_buffer(int inL, int inW, int inl, int inw) {
+    static thread_local std::vector<float> buffer;
+    static thread_local std::vector<Block> blocks;
+    int L, W;
+    int q[4];
+    int BD_solution;
+    bool swap, precomputed;
+
+    BD_solution = solvePallet (inL, inW, inl, inw, &L, &W, &swap, &blocks,
+                               &precomputed);
+    if (BD_solution < 0) {
+      return NULL;
+    }
+
+    buffer.resize (1 + 3 * BD_solution);
+    buffer[0] = (float)BD_solution;
+    if (precomputed) {
+      drawPositions (blocks, BD_solution, l, w, swap, &buffer[1]);
+      return buffer.data();
+    }
+
+    q[0] = q[2] = normalize[L];
+    q[1] = q[3] = normalize[W];
+    drawPositions (L, W, 0, q, BD_solution, false, l, w, swap, &buffer[1]);
+
+    if (cancelled ()) {
+      return NULL;
+    }
+    return buffer.data();
+  }
+
+  /**
+   * Return the number of (inl,inw)-boxes packed into the (inL,inW)
+   * pallet without drawing them, or -1 if some dimension is invalid or
+   * the packing was cancelled.
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  int pack_count(int inL, int inW, int inl, int inw) {
+    int L, W;
+    bool swap, precomputed;
+
+    int BD_solution = solvePallet (inL, inW, inl, inw, &L, &W, &swap, NULL,
+                                   &precomputed);
+    if (BD_solution < 0 || cancelled ()) {
+      return -1;
+    }
+    return BD_solution;
+  }
+
+  /**
+   * Pack (inl,inw)-boxes into each of count pallets, given as the pairs
+   * (L,W) of the array pallets, and return them ranked as a JSON array,
+   * from the pallet with most boxes to the one with least (the smaller
+   * one first among pallets with as many boxes):
+   * [{"pallet": i, "L": L, "W": W, "count": n, "boxes": [...]}, ...],
+   * where i is the position of the pallet in the array and boxes are as
+   * in pack(). The pallets not in the solution table are solved
+   * together, on the same tables (see solveMany_BD()). Return NULL if
+   * some dimension is invalid or the packing was cancelled. The string
+   * is owned by the calling thread and stays valid until its next call
+   * to pack_best_pallet().
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  const char* pack_best_pallet(int inl, int inw, const int *pallets,
+                               int count) {
+    static thread_local std::string result;
+    std::vector<RankedPallet> ranked (count);
+    std::vector<std::vector<Block> > blocks (count);
+    std::vector<bool> precomputed (count, false);
+    std::vector<int> solve, solved, solveIndex;
+    int L, W;
+    int q[4];
+    bool swap;
+
+    if (count <= 0) {
+      return NULL;
+    }
+
+    for (int i = 0; i < count; i++) {
+      if (!setPallet (pallets[2 * i], pallets[2 * i + 1], inl, inw, &L, &W,
+                      &swap)) {
+        return NULL;
+      }
+      ranked[i].pallet = i;
+      ranked[i].area = (long)L * W;
+      if (solutionTable != NULL) {
+        ranked[i].count = lookupSolution (solutionTable, L, W, l, w,
+                                          &blocks[i]);
+        if (ranked[i].count >= 0) {
+          precomputed[i] = true;
+          continue;
+        }
+      }
+      solve.push_back (L);
+      solve.push_back (W);
+      solveIndex.push_back (i);
+    }
+
+    if (!solveIndex.empty ()) {
+      solved.resize (solveIndex.size ());
+      solveMany_BD ((int)solveIndex.size (), solve.data (), l, w, 0,
+                    solved.data ());
+      for (size_t k = 0; k < solveIndex.size (); k++) {
+        ranked[solveIndex[k]].count = solved[k];
+      }
+    }
+    if (cancelled ()) {
+      return NULL;
+    }
+
+    std::stable_sort (ranked.begin (), ranked.end (), betterPallet);
+
+    result = "[";
+    for (int k = 0; k < count; k++) {
+      int i = ranked[k].pallet;
+      char head[160];
+
+      setPallet (pallets[2 * i], pallets[2 * i + 1], inl, inw, &L, &W, &swap);
+      snprintf (head, sizeof (head),
+                "%s{\"pallet\": %d, \"L\": %d, \"W\": %d, \"count\": %d, "
+                "\"boxes\": ",
+                k > 0 ? ", " : "", i, pallets[2 * i], pallets[2 * i + 1],
+                ranked[k].count);
+      result += head;
+      if (precomputed[i]) {
+        result += draw (blocks[i], ranked[k].count, l, w, swap);
+      } else {
+        q[0] = q[2] = normalize[L];
+        q[1] = q[3] = normalize[W];
+        result += draw (L, W, 0, q, ranked[k].count, false, l, w, swap);
+      }
+      if (cancelled ()) {
+        return NULL;
+      }
+      result += "}";
+    }
+    result += "]";
+    return result.c_str();
+  }
+
+  /**
+   * Pack (inl,inw)-boxes into the (inL,inW) pallet and return the
+   * number of boxes packed into each of its rectangles (see
+   * AnswerGrid) as the JSON object {"x": [...], "y": [...],
+   * "count": [...], "optimal": [...]}, x along inL and y along inW,
+   * with count and optimal (1 if the count is proven optimal, 0
+   * otherwise) in row-major order, x.length x y.length entries each.
+   * The pallet itself is the last entry, with the count of pack().
+   * Only the pallet is searched, so the other counts that are not
+   * optimal are lower bounds, which pack() may beat for the rectangle.
+   * Return NULL if some dimension is invalid or the packing was
+   * cancelled. The string is owned by the calling thread and stays
+   * valid until its next call to pack_grid().
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  const char* pack_grid(int inL, int inW, int inl, int inw) {
+    static thread_local std::string result;
+    AnswerGrid grid;
+    int L, W;
+    bool swap;
+    char number[16];
+
+    if (!setPallet (inL, inW, inl, inw, &L, &W, &swap)) {
+      return NULL;
+    }
+
+    /* The solution table holds the pallets only, the grid comes from
+     * the tables of the search. */
+    solve_BD (L, W, l, w, 0);
+    if (cancelled ()) {
+      return NULL;
+    }
+    grid_BD (inL, inW, &grid);
+
+    result = "{\"x\": [";
+    for (size_t i = 0; i < grid.x.size (); i++) {
+      snprintf (number, sizeof (number), "%s%d", i > 0 ? ", " : "",
+                grid.x[i]);
+      result += number;
+    }
+    result += "], \"y\": [";
+    for (size_t j = 0; j < grid.y.size (); j++) {
+      snprintf (number, sizeof (number), "%s%d", j > 0 ? ", " : "",
+                grid.y[j]);
+      result += number;
+    }
+    result += "], \"count\": [";
+    for (size_t k = 0; k < grid.count.size (); k++) {
+      snprintf (number, sizeof (number), "%s%d", k > 0 ? ", " : "",
+                grid.count[k]);
+      result += number;
+    }
+    result += "], \"optimal\": [";
+    for (size_t k = 0; k < grid.optimal.size (); k++) {
+      result += k > 0 ? ", " : "";
+      result += grid.optimal[k] ? "1" : "0";
+    }
+    result += "]}";
+    return result.c_str();
+  }
+
+  /**
+   * Pack (inl,inw)-boxes into the (inL,inW) pallet and return up to
+   * count distinct packings with the most boxes found, as a JSON array
+   * of box arrays as in pack(), the packing of the search first. The
+   * search keeps up to cuts of the best cuts of the pallet (see
+   * solveAlternatives_BD()) and the other packings take one of them or
+   * turn the boxes of some of their blocks (see drawAlternatives()), so
+   * fewer packings are returned when the pallet has fewer. Return NULL
+   * if some dimension or count is invalid or the packing was
+   * cancelled. The string is owned by the calling thread and stays
+   * valid until its next call to pack_alternatives().
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  const char* pack_alternatives(int inL, int inW, int inl, int inw,
+                                int cuts, int count) {
+    static thread_local std::string result;
+    std::vector<std::vector<Block> > patterns;
+    int L, W;
+    bool swap;
+
+    if (!setPallet (inL, inW, inl, inw, &L, &W, &swap) || cuts < 1
+        || count < 1) {
+      return NULL;
+    }
+
+    /* The solution table holds a single packing of each pallet, the
+     * others come from the tables of the search. */
+    solveAlternatives_BD (L, W, l, w, 0, cuts);
+    if (cancelled ()) {
+      return NULL;
+    }
+    int n = drawAlternatives (normalize[L], normalize[W], count, &patterns);
+    if (cancelled ()) {
+      return NULL;
+    }
+
+    result = "[";
+    for (size_t i = 0; i < patterns.size (); i++) {
+      result += i > 0 ? ",\n" : "";
+      result += draw (patterns[i], n, l, w, swap);
+    }
+    result += "]";
+    return result.c_str();
+  }
+
+  /**
+   * Give a packing of a neighbouring problem, such as the same boxes on
+   * a slightly different pallet or similar boxes on the same pallet, to
+   * the next call of the thread to pack(), pack_buffer() or
+   * pack_count(), which starts its search from it (see solve_BD()).
+   * The packing is the one returned by pack_buffer() for packing
+   * (inl,inw)-boxes into the (inL,inW) pallet: the number of boxes n
+   * followed by n triples {x, y, rotated}. Each of its boxes holds as
+   * many boxes of the next packing as fit into it; the boxes that do
+   * not fit into the next pallet are left out. A packing whose boxes
+   * overlap is ignored. The seeded packing may differ from the one
+   * found without a seed, and may even hold more boxes. Return 0 if
+   * some dimension is invalid, 1 otherwise.
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  int pack_seed(int inL, int inW, int inl, int inw, const float *positions) {
+    int n = (int)positions[0];
+    bool swap = inL < inW;
+
+    seedPending = false;
+    if (inL <= 0 || inW <= 0 || inl <= 0 || inw <= 0 || n < 0) {
+      return 0;
+    }
+
+    /* The boxes back in the coordinates of the pallet with L >= W,
+     * undoing boxPosition(). */
+    int height = swap ? inl : inw;
+    int width = swap ? inw : inl;
+
+    threadSeed.resize (n);
+    for (int i = 0; i < n; i++) {
+      const float *box = positions + 1 + 3 * i;
+      bool rotated = box[2] != 0;
+      float x = swap ? box[0] : box[1];
+      float y = swap ? box[1] : box[0];
+      Block &b = threadSeed[i];
+
+      b.x = rotated ? height : width;
+      b.y = rotated ? width : height;
+      b.dx = (int)lroundf (x - b.x / 2.0f);
+      b.dy = (int)lroundf (y - b.y / 2.0f);
+      b.rotated = false;
+    }
+    seedPending = true;
+    return 1;
+  }
+
+  /**
+   * Load the solution table at path (see the precompute tool), so
+   * that pack(), pack_buffer() and pack_count() answer the problems in
+   * it without solving. A NULL path unloads the table. It must not be
+   * called while some thread is packing. Return 1 on success, 0 if the
+   * file is not a valid solution table (the previous table is kept).
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  int pack_load_table(const char *path) {
+    SolutionTable *table = NULL;
+
+    if (path != NULL && (table = openSolutionTable (path)) == NULL) {
+      return 0;
+    }
+    closeSolutionTable (solutionTable);
+    solutionTable = table;
+    return 1;
+  }
+
+  /**
+   * Start packing (inl,inw)-boxes into the (inL,inW) pallet without
+   * searching yet, so that hosts without threads can run the search in
+   * slices with pack_step() and stay responsive. Return the handle of
+   * the packing, or NULL if some dimension is invalid. The handle must
+   * be released with pack_free().
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  PackJob* pack_start(int inL, int inW, int inl, int inw) {
+    return startJob (inL, inW, inl, inw, NULL);
+  }
+
+  /**
+   * Same as pack_start(), but continue the search saved by
+   * pack_checkpoint() at path for the same problem, possibly by another
+   * process or machine. Return NULL if some dimension is invalid or
+   * the file is not a checkpoint of this problem.
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  PackJob* pack_resume(int inL, int inW, int inl, int inw, const char *path) {
+    return startJob (inL, inW, inl, inw, path);
+  }
+
+  /**
+   * Save the search of a packing between two calls to pack_step() to
+   * a checkpoint file at path (see save_BD()), so that pack_resume()
+   * can continue it after an interruption. Return 1 on success, 0 if
+   * the file could not be written or the search is over or cancelled.
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  int pack_checkpoint(PackJob *job, const char *path) {
+    if (job->search == NULL) {
+      return 0;
+    }
+
+    std::atomic<int> *token = cancelToken;
+    setCancelToken (job->token);
+    bool stopped = cancelled ();
+    setCancelToken (token);
+
+    if (stopped) {
+      return 0;
+    }
+    return save_BD (job->search, path);
+  }
+
+  /**
+   * Try about budget more cuts of the pallet. Return 1 when the search
+   * is over or cancelled, 0 otherwise.
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  int pack_step(PackJob *job, int budget) {
+    if (job->search == NULL) {
+      return 1;
+    }
+
+    std::atomic<int> *token = cancelToken;
+    setCancelToken (job->token);
+    int over = step_BD (job->search, budget);
+    setCancelToken (token);
+
+    return over;
+  }
+
+  /**
+   * Return the fraction, between 0 and 1, of the search already done.
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  double pack_progress(PackJob *job) {
+    if (job->search == NULL) {
+      return 1.0;
+    }
+    return progress_BD (job->search);
+  }
+
+  /**
+   * Complete the search, if it is not over, and return the boxes as
+   * pack() does. The string stays valid until pack_free().
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  const char* pack_result(PackJob *job) {
+    int q[4];
+    int BD_solution;
+    std::atomic<int> *token = cancelToken;
+
+    setCancelToken (job->token);
+    if (job->search != NULL) {
+      BD_solution = finish_BD (job->search);
+      job->search = NULL;
+
+      l = job->l;
+      w = job->w;
+      q[0] = q[2] = normalize[job->L];
+      q[1] = q[3] = normalize[job->W];
+
+      job->result = draw (job->L, job->W, 0, q, BD_solution, false, l, w,
+                          job->swap);
+    }
+    bool stopped = cancelled ();
+    setCancelToken (token);
+
+    if (stopped) {
+      return NULL;
+    }
+    return job->result.c_str();
+  }
+
+  /**
+   * Release a packing started by pack_start(), cancelling its search
+   * if it is not over.
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  void pack_free(PackJob *job) {
+    if (job == NULL) {
+      return;
+    }
+    if (job->search != NULL) {
+      cancel_BD (job->search);
+    }
+    deleteTablePool (job->tables);
+    delete job;
+  }
+
+  /**
+   * Create a session for packings that change a little at a time, as
+   * when the dimensions of the pallet or of the boxes are adjusted by
+   * a millimetre and packed again. It must be released with
+   * pack_session_free().
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  PackSession* pack_session() {
+    PackSession *session = new PackSession;
+    session->history = newHistory_BD ();
+    session->L = session->W = session->l = session->w = 0;
+    return session;
+  }
+
+  /**
+   * Same as pack(), for the next problem of the session. If it
+   * normalizes to the last problem of the session, its boxes are
+   * returned, or drawn again in the new orientation, without
+   * searching. Otherwise, for the same boxes, the search
+   * reuses the rectangles already packed for the last problem (see
+   * resolve_BD()). The string stays valid until the next call for the
+   * session or pack_session_free().
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  const char* pack_again(PackSession *session, int inL, int inW, int inl,
+                         int inw) {
+    std::vector<Block> blocks;
+    int L, W;
+    int q[4];
+    int BD_solution, unchanged;
+    bool swap;
+
+    if (!setPallet (inL, inW, inl, inw, &L, &W, &swap)) {
+      return NULL;
+    }
+    if (solutionTable != NULL) {
+      BD_solution = lookupSolution (solutionTable, L, W, l, w, &blocks);
+      if (BD_solution >= 0) {
+        session->result = draw (blocks, BD_solution, l, w, swap);
+        session->L = 0;
+        return session->result.c_str();
+      }
+    }
+
+    BD_solution = resolve_BD (session->history, L, W, l, w, 0, &unchanged);
+    if (cancelled ()) {
+      return NULL;
+    }
+    if (unchanged && inL == session->L && inW == session->W
+        && inl == session->l && inw == session->w) {
+      return session->result.c_str();
+    }
+
+    q[0] = q[2] = normalize[L];
+    q[1] = q[3] = normalize[W];
+    session->result = draw (L, W, 0, q, BD_solution, false, l, w, swap);
+
+    if (cancelled ()) {
+      session->L = 0;
+      return NULL;
+    }
+    session->L = inL;
+    session->W = inW;
+    session->l = inl;
+    session->w = inw;
+    return session->result.c_str();
+  }
+
+  /**
+   * Release a session created by pack_session() and its tables.
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  void pack_session_free(PackSession *session) {
+    if (session == NULL) {
+      return;
+    }
+    deleteHistory_BD (session->history);
+    delete session;
+  }
+
+  /**
+   * Create a cancellation token. Any thread (or, in the threaded build,
+   * JavaScript with Atomics.store() on HEAP32) may cancel the packings
+   * using it with pack_cancel(). It must be released with
+   * pack_token_free().
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  std::atomic<int>* pack_token() {
+    return new std::atomic<int> (0);
+  }
+
+  /**
+   * Cancel the packings using the token. They stop as soon as they
+   * notice it, release their tables and return NULL.
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  void pack_cancel(std::atomic<int> *token) {
+    token->store (1);
+  }
+
+  /**
+   * Release a token created by pack_token().
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  void pack_token_free(std::atomic<int> *token) {
+    if (cancelToken == token) {
+      setCancelToken (NULL);
+    }
+    delete token;
+  }
+
+  /**
+   * Set the cancellation token of the calling thread, used by its
+   * next calls to pack(), pack_buffer() and pack_start(). NULL (the
+   * default) packs without cancellation.
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  void pack_set_token(std::atomic<int> *token) {
+    setCancelToken (token);
+  }
+
+  /**
+   * Give back the memory of the tables kept between packings by the
+   * calling thread and by the threads of the pool. They are allocated
+   * again by the next packing.
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  void pack_trim() {
+    runOnWorkers (trimWorker, NULL, numWorkers ());
+  }
+
+  /**
+   * Return the size, in bytes, of the tables kept between packings by
+   * the calling thread.
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  double pack_tables_size() {
+    return (double)tablesSize ();
+  }
+
+  /**
+   * Set the number of threads used by pack(). A value less than or
+   * equal to zero uses every processor available. It has no effect in
+   * the serial build.
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  void pack_threads(int n) {
+    setNumWorkers (n);
+  }
+
+  /**
+   * Select whether pack() gives the same packing of a problem on any
+   * number of threads (on != 0). Off by default: the threads then share
+   * the bounds they find as soon as they find them, which is faster but
+   * may choose another packing with the same number of boxes.
+   */
+#ifdef __EMSCRIPTEN__
+  EMSCRIPTEN_KEEPALIVE
+#endif
+  void pack_deterministic(int on) {
+    setDeterministic (on != 0);
   }
 
 #ifdef __cplusplus
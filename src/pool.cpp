@@ -0,0 +1,311 @@
+/* Copyright (C) 2007-2016 Rafael Durbano Lobato
+ *
+ * This file is part of Recursive Partitioning Algorithm.
+ *
+ * Recursive Partitioning Algorithm is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Recursive Partitioning Algorithm is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Recursive Partitioning Algorithm. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Contact information:
+ *
+ * Rafael Durbano Lobato <lobato@ime.usp.br>
+ * http://www.ime.usp.br/~lobato/
+ */
+
+
+/* Pool of worker threads used by the parallel parts of the solver.
+ *
+ * The threads are created on the first parallel task and kept alive
+ * between calls, so that successive problems do not pay for the
+ * creation of the threads. In WebAssembly builds without pthreads
+ * support every task runs on the calling thread.
+ */
+
+/******************************************************************
+ ******************************************************************/
+
+#include "pool.h"
+
+#include <atomic>
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define NO_THREADS
+#endif
+
+/* Maximum number of threads of the pool. WebAssembly builds set it to
+ * the size of the pthreads pool of the runtime. */
+#ifndef MAX_WORKERS
+#define MAX_WORKERS 64
+#endif
+
+/* Whether the parallel searches are deterministic. It is read by the
+ * packings of every thread, so it may be changed while they run, but
+ * the packings running then are not repeatable. */
+static std::atomic<bool> deterministicMode (false);
+
+/******************************************************************
+ ******************************************************************/
+
+void
+setDeterministic (bool on)
+{
+  deterministicMode.store (on);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+bool
+deterministic ()
+{
+  return deterministicMode.load ();
+}
+
+/******************************************************************
+ ******************************************************************/
+
+#ifdef NO_THREADS
+
+void
+setNumWorkers (int n)
+{
+}
+
+int
+numWorkers ()
+{
+  return 1;
+}
+
+int
+runOnWorkers (void (*task) (int, void *), void *arg, int maxWorkers)
+{
+  task (0, arg);
+  return 1;
+}
+
+#else
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Number of workers, including the calling thread (worker 0). Zero
+ * means that it was not set yet. It changes only while the pool is
+ * taken (see busy). */
+static std::atomic<int> numThreads (0);
+
+/* Indicate whether some thread is using the pool. */
+static std::atomic<bool> busy (false);
+
+/* Threads of the workers 1 to numThreads - 1, task being executed and
+ * the data used to synchronize the workers (protected by mutex). The
+ * task runs on the workers 0 to workers - 1 only, running of them
+ * still running it. The pool is never destroyed, so that the threads
+ * still waiting for tasks do not block or abort the program at its
+ * exit. */
+struct Pool
+{
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable wakeUp, finished;
+  void (*task) (int, void *);
+  void *arg;
+  unsigned long generation;
+  int workers;
+  int running;
+  bool stopping;
+};
+
+static Pool &pool = *new Pool ();
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Main loop of the worker threads.
+ *
+ * Parameters:
+ * id   - Identifier of the worker.
+ *
+ * seen - Generation of the last task seen by this worker.
+ */
+static void
+workerLoop (int id, unsigned long seen)
+{
+  for (;;)
+    {
+      void (*task) (int, void *);
+      void *arg;
+
+      {
+        std::unique_lock<std::mutex> lock (pool.mutex);
+        while (!pool.stopping && pool.generation == seen)
+          {
+            pool.wakeUp.wait (lock);
+          }
+        if (pool.stopping)
+          {
+            return;
+          }
+        seen = pool.generation;
+        if (id >= pool.workers)
+          {
+            /* The task needs fewer workers. */
+            continue;
+          }
+        task = pool.task;
+        arg = pool.arg;
+      }
+
+      task (id, arg);
+
+      {
+        std::lock_guard<std::mutex> lock (pool.mutex);
+        if (--pool.running == 0)
+          {
+            pool.finished.notify_one ();
+          }
+      }
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Terminate the threads of the pool.
+ */
+static void
+stopThreads ()
+{
+  {
+    std::lock_guard<std::mutex> lock (pool.mutex);
+    pool.stopping = true;
+  }
+  pool.wakeUp.notify_all ();
+  for (size_t i = 0; i < pool.threads.size (); i++)
+    {
+      pool.threads[i].join ();
+    }
+  pool.threads.clear ();
+  pool.stopping = false;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+void
+setNumWorkers (int n)
+{
+  if (n <= 0)
+    {
+      n = (int)std::thread::hardware_concurrency ();
+    }
+  if (n < 1)
+    {
+      n = 1;
+    }
+  if (n > MAX_WORKERS)
+    {
+      n = MAX_WORKERS;
+    }
+
+  /* Wait until the pool is free. */
+  bool expected = false;
+  while (!busy.compare_exchange_weak (expected, true))
+    {
+      expected = false;
+      std::this_thread::yield ();
+    }
+
+  if (n != numThreads.load ())
+    {
+      stopThreads ();
+      numThreads.store (n);
+    }
+
+  busy.store (false);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+numWorkers ()
+{
+  if (numThreads.load () == 0)
+    {
+      setNumWorkers (0);
+    }
+  return numThreads.load ();
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+runOnWorkers (void (*task) (int, void *), void *arg, int maxWorkers)
+{
+  /* Set the number of threads on first use. */
+  numWorkers ();
+
+  if (maxWorkers <= 1 || busy.exchange (true))
+    {
+      /* Single worker or the pool is already in use (possibly by a
+       * task that called this function again). */
+      task (0, arg);
+      return 1;
+    }
+
+  /* The number of threads does not change while the pool is taken. */
+  int n = std::min (maxWorkers, numThreads.load ());
+  if (n == 1)
+    {
+      busy.store (false);
+      task (0, arg);
+      return 1;
+    }
+
+  {
+    std::lock_guard<std::mutex> lock (pool.mutex);
+    while ((int)pool.threads.size () < n - 1)
+      {
+        int id = (int)pool.threads.size () + 1;
+        pool.threads.push_back (std::thread (workerLoop, id, pool.generation));
+      }
+    pool.task = task;
+    pool.arg = arg;
+    pool.workers = n;
+    pool.running = n - 1;
+    pool.generation++;
+  }
+  pool.wakeUp.notify_all ();
+
+  task (0, arg);
+
+  {
+    std::unique_lock<std::mutex> lock (pool.mutex);
+    while (pool.running > 0)
+      {
+        pool.finished.wait (lock);
+      }
+  }
+
+  busy.store (false);
+  return n;
+}
+
+#endif
@@ -0,0 +1,87 @@
+/* Copyright (C) 2007-2016 Rafael Durbano Lobato
+ *
+ * This file is part of Recursive Partitioning Algorithm.
+ *
+ * Recursive Partitioning Algorithm is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Recursive Partitioning Algorithm is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Recursive Partitioning Algorithm. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Contact information:
+ *
+ * Rafael Durbano Lobato <lobato@ime.usp.br>
+ * http://www.ime.usp.br/~lobato/
+ */
+
+
+#ifndef POOL_H_
+#define POOL_H_
+
+/**
+ * Set the number of threads used by the solver, including the calling
+ * thread. A value less than or equal to zero selects the number of
+ * processors available. Builds without thread support always use a
+ * single thread.
+ *
+ * Parameter:
+ * n - Number of threads.
+ */
+void setNumWorkers (int n);
+
+/**
+ * Return the number of threads used by the solver.
+ */
+int numWorkers ();
+
+/**
+ * Run the specified task on the workers of the pool, at most
+ * maxWorkers of them. The calling thread takes part as the worker 0
+ * and this function returns only after all the workers have finished
+ * the task. If the pool is busy with another task, the calling thread
+ * runs the task alone. The number of workers may change between a
+ * call to numWorkers() and this one, so the data of the workers must
+ * be sized from maxWorkers.
+ *
+ * Parameters:
+ * task       - Function executed by each worker. It receives the
+ *              identifier of the worker (between 0 and the number of
+ *              workers that run the task - 1) and arg.
+ *
+ * arg        - Argument passed to the task.
+ *
+ * maxWorkers - Maximum number of workers.
+ *
+ * Return:
+ * - the number of workers that ran the task.
+ */
+int runOnWorkers (void (*task) (int, void *), void *arg, int maxWorkers);
+
+/**
+ * Select whether the parallel searches are deterministic. In the
+ * deterministic mode the packing found for a problem depends only on
+ * the problem, and not on the number of threads or on their timing,
+ * at the cost of some of the speedup of the threads (see parallelBD()
+ * and solve_L()). It is off by default. It can be called from any
+ * thread, also while other threads pack, but the packings that run
+ * meanwhile may mix both modes and then are not repeatable.
+ *
+ * Parameter:
+ * on - Whether the searches are deterministic.
+ */
+void setDeterministic (bool on);
+
+/**
+ * Return whether the parallel searches are deterministic.
+ */
+bool deterministic ();
+
+#endif
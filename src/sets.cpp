@@ -32,7 +32,7 @@
  *
  * <x>_S = max {s | s \in S, s <= x}.
  */
-extern int *normalize;
+extern __thread int *normalize;
 
 /******************************************************************
  ******************************************************************/
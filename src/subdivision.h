@@ -0,0 +1,280 @@
+/* Copyright (C) 2007-2016 Rafael Durbano Lobato
+ *
+ * This file is part of Recursive Partitioning Algorithm.
+ *
+ * Recursive Partitioning Algorithm is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Recursive Partitioning Algorithm is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Recursive Partitioning Algorithm. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Contact information:
+ *
+ * Rafael Durbano Lobato <lobato@ime.usp.br>
+ * http://www.ime.usp.br/~lobato/
+ */
+
+
+#ifndef SUBDIVISION_H_
+#define SUBDIVISION_H_
+
+#include <algorithm>
+
+#include "util.h"
+
+/* Subdivisions of the L-approach as inline templates, so that the
+ * loops of divideL<B>() compile the arithmetic of their subdivision
+ * and the normalization of the pieces inline instead of calling them
+ * through a function pointer. The functions standardPositionB1() ...
+ * standardPositionB9() and normalizePiece() of util.h are the same
+ * code for callers outside the loops.
+ *
+ * The normalize array and the area of the boxes are parameters, so
+ * that the loops read them once instead of at every division. */
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Divide the L-shaped piece q in two new L-shaped pieces, according to
+ * the subdivision B, and put them in the standard position (see
+ * standardPositionB1() ... standardPositionB9() in util.h).
+ */
+template <int B>
+inline void standardPosition (const int *i, const int *q, int *q1, int *q2,
+                              const int *normalize);
+
+template <>
+inline void
+standardPosition<B1> (const int *i, const int *q, int *q1, int *q2,
+                      const int *normalize)
+{
+  q1[0] = q[2];
+  q1[1] = normalize[q[1] - i[1]];
+  q1[2] = i[0];
+  q1[3] = normalize[q[1] - q[3]];
+
+  q2[0] = q[0];
+  q2[1] = q[3];
+  q2[2] = normalize[q[0] - i[0]];
+  q2[3] = i[1];
+}
+
+template <>
+inline void
+standardPosition<B2> (const int *i, const int *q, int *q1, int *q2,
+                      const int *normalize)
+{
+  q1[0] = q[2];
+  q1[1] = normalize[q[1] - q[3]];
+  q1[2] = normalize[q[2] - i[0]];
+  q1[3] = normalize[q[1] - i[1]];
+
+  q2[0] = q[0];
+  q2[1] = i[1];
+  q2[2] = i[0];
+  q2[3] = q[3];
+}
+
+template <>
+inline void
+standardPosition<B3> (const int *i, const int *q, int *q1, int *q2,
+                      const int *normalize)
+{
+  q1[0] = q[0];
+  q1[1] = q[1];
+  q1[2] = i[0];
+  q1[3] = i[1];
+
+  q2[0] = normalize[q[0] - i[0]];
+  q2[1] = normalize[q[1] - i[1]];
+  q2[2] = normalize[q[2] - i[0]];
+  q2[3] = normalize[q[3] - i[1]];
+}
+
+template <>
+inline void
+standardPosition<B4> (const int *i, const int *q, int *q1, int *q2,
+                      const int *normalize)
+{
+  q1[0] = i[0];
+  q1[1] = q[1];
+  q1[2] = q[2];
+  q1[3] = i[1];
+
+  q2[0] = normalize[q[0] - q[2]];
+  q2[1] = q[3];
+  q2[2] = normalize[q[0] - i[0]];
+  q2[3] = normalize[q[3] - i[1]];
+}
+
+template <>
+inline void
+standardPosition<B5> (const int *i, const int *q, int *q1, int *q2,
+                      const int *normalize)
+{
+  q1[0] = q[2];
+  q1[1] = q[1];
+  q1[2] = i[0];
+  q1[3] = normalize[q[1] - i[1]];
+
+  q2[0] = normalize[q[0] - i[0]];
+  q2[1] = q[3];
+  q2[2] = normalize[q[0] - q[2]];
+  q2[3] = i[1];
+}
+
+template <>
+inline void
+standardPosition<B6> (const int *i, const int *q, int *q1, int *q2,
+                      const int *normalize)
+{
+  q1[0] = i[2];
+  q1[1] = q[1];
+  q1[2] = i[0];
+  q1[3] = normalize[q[1] - i[1]];
+
+  q2[0] = normalize[q[0] - i[0]];
+  q2[1] = q[1];
+  q2[2] = normalize[q[0] - i[2]];
+  q2[3] = i[1];
+}
+
+template <>
+inline void
+standardPosition<B7> (const int *i, const int *q, int *q1, int *q2,
+                      const int *normalize)
+{
+  q1[0] = q[0];
+  q1[1] = normalize[q[1] - i[1]];
+  q1[2] = i[0];
+  q1[3] = normalize[q[1] - i[2]];
+
+  q2[0] = q[0];
+  q2[1] = i[2];
+  q2[2] = normalize[q[0] - i[0]];
+  q2[3] = i[1];
+}
+
+template <>
+inline void
+standardPosition<B8> (const int *i, const int *q, int *q1, int *q2,
+                      const int *normalize)
+{
+  q1[0] = q[2];
+  q1[1] = q[1];
+  q1[2] = i[0];
+  q1[3] = normalize[q[1] - i[1]];
+
+  q2[0] = normalize[q[0] - i[0]];
+  q2[1] = i[1];
+  q2[2] = normalize[q[2] - i[0]];
+  q2[3] = q[3];
+}
+
+template <>
+inline void
+standardPosition<B9> (const int *i, const int *q, int *q1, int *q2,
+                      const int *normalize)
+{
+  q1[0] = i[0];
+  q1[1] = normalize[q[1] - i[1]];
+  q1[2] = q[2];
+  q1[3] = normalize[q[3] - i[1]];
+
+  q2[0] = q[0];
+  q2[1] = q[3];
+  q2[2] = normalize[q[0] - i[0]];
+  q2[3] = i[1];
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Normalize the L-piece q (see normalizePiece() in util.h). Pieces
+ * with less area than boxArea are discarded by setting q[0] to -1.
+ */
+inline void
+normalizePiece (int *q, int boxArea)
+{
+  int i, j, i1, j1;
+
+  i = q[0];
+  j = q[1];
+  i1 = q[2];
+  j1 = q[3];
+
+  /* Rule (4) for degenerated L's. */
+  if (i1 == 0)
+    {
+      i1 = i;
+      j = j1;
+    }
+  else if (j1 == 0)
+    {
+      j1 = j;
+      i = i1;
+    }
+  else if (i1 == i || j1 == j)
+    {
+      i1 = i;
+      j1 = j;
+    }
+
+  /* If the area of this L-piece is less than the area of the box,
+   * this L-piece is discarded. */
+  if (i * j - (i - i1) * (j - j1) < boxArea)
+    {
+      q[0] = -1;
+      return;
+    }
+
+  if (i == i1 && j == j1 && i < j)
+    {
+      std::swap (i, j);
+      std::swap (i1, j1);
+    }
+
+  if (0 < i1 && i1 < i && 0 < j1 && j1 < j && i < j)
+    {
+      std::swap (i, j);
+      std::swap (i1, j1);
+    }
+  else if (0 < i1 && i1 < i && 0 < j1 && j1 < j && i == j && i1 < j1)
+    {
+      std::swap (i1, j1);
+    }
+
+  q[0] = i;
+  q[1] = j;
+  q[2] = i1;
+  q[3] = j1;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Divide the L-piece q in two new L-pieces, q1 and q2, according to
+ * the subdivision B, and normalize them.
+ */
+template <int B>
+inline void
+divide (const int *i, const int *q, int *q1, int *q2, const int *normalize,
+        int boxArea)
+{
+  standardPosition<B> (i, q, q1, q2, normalize);
+  normalizePiece (q1, boxArea);
+  normalizePiece (q2, boxArea);
+}
+
+#endif
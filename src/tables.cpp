@@ -0,0 +1,167 @@
+/* Copyright (C) 2007-2016 Rafael Durbano Lobato
+ *
+ * This file is part of Recursive Partitioning Algorithm.
+ *
+ * Recursive Partitioning Algorithm is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Recursive Partitioning Algorithm is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Recursive Partitioning Algorithm. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Contact information:
+ *
+ * Rafael Durbano Lobato <lobato@ime.usp.br>
+ * http://www.ime.usp.br/~lobato/
+ */
+
+#include "tables.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+struct TablePool
+{
+  /* Buffers of the tables (0 to NUM_TABLES - 1) and of their row
+   * pointers (NUM_TABLES to 2 NUM_TABLES - 1), and their sizes. */
+  void *buffer[2 * NUM_TABLES];
+  size_t capacity[2 * NUM_TABLES];
+};
+
+/* Own pool of the thread and pool selected by it. */
+static __thread TablePool *threadPool = NULL;
+static __thread TablePool *selectedPool = NULL;
+
+/******************************************************************
+ ******************************************************************/
+
+TablePool *
+newTablePool ()
+{
+  TablePool *pool = new TablePool;
+  for (int i = 0; i < 2 * NUM_TABLES; i++)
+    {
+      pool->buffer[i] = NULL;
+      pool->capacity[i] = 0;
+    }
+  return pool;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+void
+deleteTablePool (TablePool *pool)
+{
+  for (int i = 0; i < 2 * NUM_TABLES; i++)
+    {
+      free (pool->buffer[i]);
+    }
+  delete pool;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+void
+setTablePool (TablePool *pool)
+{
+  selectedPool = pool;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Return the pool selected by this thread.
+ */
+static TablePool *
+currentPool ()
+{
+  if (selectedPool != NULL)
+    {
+      return selectedPool;
+    }
+  if (threadPool == NULL)
+    {
+      threadPool = newTablePool ();
+    }
+  return threadPool;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+void
+trimTables ()
+{
+  if (threadPool != NULL)
+    {
+      deleteTablePool (threadPool);
+      threadPool = NULL;
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+size_t
+tablesSize ()
+{
+  TablePool *pool = currentPool ();
+  size_t size = 0;
+
+  for (int i = 0; i < 2 * NUM_TABLES; i++)
+    {
+      size += pool->capacity[i];
+    }
+  return size;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Return the buffer i of the pool, enlarged to size bytes if needed.
+ */
+static void *
+buffer (TablePool *pool, int i, size_t size)
+{
+  if (size > pool->capacity[i])
+    {
+      free (pool->buffer[i]);
+      pool->buffer[i] = malloc (size);
+      if (pool->buffer[i] == NULL)
+        {
+          printf ("Error allocating memory.\n");
+          exit (0);
+        }
+      pool->capacity[i] = size;
+    }
+  return pool->buffer[i];
+}
+
+/******************************************************************
+ ******************************************************************/
+
+void *
+poolBuffer (int table, size_t size)
+{
+  return buffer (currentPool (), table, size);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+void *
+poolRows (int table, size_t size)
+{
+  return buffer (currentPool (), NUM_TABLES + table, size);
+}
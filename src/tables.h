@@ -0,0 +1,135 @@
+/* Copyright (C) 2007-2016 Rafael Durbano Lobato
+ *
+ * This file is part of Recursive Partitioning Algorithm.
+ *
+ * Recursive Partitioning Algorithm is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Recursive Partitioning Algorithm is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Recursive Partitioning Algorithm. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Contact information:
+ *
+ * Rafael Durbano Lobato <lobato@ime.usp.br>
+ * http://www.ime.usp.br/~lobato/
+ */
+
+#ifndef TABLES_H_
+#define TABLES_H_
+
+#include <cstddef>
+
+/* Tables of the solver kept by a table pool. */
+#define TABLE_LOWER_BOUND 0
+#define TABLE_UPPER_BOUND 1
+#define TABLE_SOLUTION_DEPTH 2
+#define TABLE_REACHED_LIMIT 3
+#define TABLE_CUT_POINTS 4
+#define TABLE_INDEX_X 5
+#define TABLE_INDEX_Y 6
+#define TABLE_NORMALIZE 7
+#define TABLE_NORMAL_SET 8
+#define TABLE_SCREEN_F 9
+#define TABLE_SCREEN_G 10
+
+/* Copies of the tables used by the deterministic search of the root
+ * (see parallelBD()): the tables of the chain of cuts being searched
+ * and the best solution found by the thread. */
+#define TABLE_CHAIN_LOWER_BOUND 11
+#define TABLE_CHAIN_SOLUTION_DEPTH 12
+#define TABLE_CHAIN_REACHED_LIMIT 13
+#define TABLE_CHAIN_CUT_POINTS 14
+#define TABLE_BEST_LOWER_BOUND 15
+#define TABLE_BEST_CUT_POINTS 16
+
+/* Other cuts kept for each rectangle (see solveAlternatives_BD()). */
+#define TABLE_ALTERNATIVES 17
+#define TABLE_NUM_ALTERNATIVES 18
+#define NUM_TABLES 19
+
+/* Memory of the tables of a problem. It keeps the largest buffer
+ * requested for each table, so that solving several problems in a row
+ * allocates only when a problem is larger than all the previous ones.
+ * The contents of a buffer are not kept: whoever takes a table
+ * initializes the region it uses. */
+struct TablePool;
+
+/**
+ * Create an empty table pool.
+ */
+TablePool *newTablePool ();
+
+/**
+ * Free a table pool and all the tables taken from it.
+ */
+void deleteTablePool (TablePool *pool);
+
+/**
+ * Select the pool of the tables taken by this thread.
+ *
+ * Parameter:
+ * pool - The pool, or NULL for the own pool of the thread, created on
+ *        first use.
+ */
+void setTablePool (TablePool *pool);
+
+/**
+ * Give back the memory of the own pool of this thread. The tables
+ * taken from it before must not be used anymore.
+ */
+void trimTables ();
+
+/**
+ * Return the total size, in bytes, of the buffers kept by the pool
+ * selected by this thread.
+ */
+size_t tablesSize ();
+
+/**
+ * Return a buffer of at least size bytes for the table, taken from
+ * the pool selected by this thread. It replaces the buffer returned
+ * before for the same table.
+ */
+void *poolBuffer (int table, size_t size);
+
+/**
+ * Same as poolBuffer(), for the array of row pointers of a table.
+ */
+void *poolRows (int table, size_t size);
+
+/**
+ * Return an array of size elements for the table.
+ */
+template <typename T>
+T *
+poolArray (int table, int size)
+{
+  return (T *)poolBuffer (table, size * sizeof (T));
+}
+
+/**
+ * Return a table of rows x cols elements, stored contiguously.
+ */
+template <typename T>
+T **
+poolTable (int table, int rows, int cols)
+{
+  T **rowsOf = (T **)poolRows (table, rows * sizeof (T *));
+  T *data = poolArray<T> (table, rows * cols);
+
+  for (int i = 0; i < rows; i++)
+    {
+      rowsOf[i] = data + (size_t)i * cols;
+    }
+  return rowsOf;
+}
+
+#endif
@@ -23,18 +23,20 @@
  */
 
 #include "util.h"
+#include "subdivision.h"
 #include <algorithm>
 #include <cstdio>
 
-extern const int l, w;
-extern const int *normalize;
+extern __thread const int l, w;
+extern __thread const int *normalize;
 
-extern const int *indexRasterX;
-extern const int *indexRasterY;
-extern const int numRasterX;
-extern const int numRasterY;
+extern __thread const int *indexRasterX;
+extern __thread const int *indexRasterY;
+extern __thread const int numRasterX;
+extern __thread const int numRasterY;
 
-extern const int memory_type;
+extern __thread const int memory_type;
+extern __thread const int denseSize, numDenseX, numDenseY;
 
 /******************************************************************
  ******************************************************************/
@@ -87,58 +89,7 @@ extern const int memory_type;
 void
 normalizePiece (int *q)
 {
-  int i, j, i1, j1;
-
-  i = q[0];
-  j = q[1];
-  i1 = q[2];
-  j1 = q[3];
-
-  /* Rule (4) for degenerated L's. */
-  if (i1 == 0)
-    {
-      i1 = i;
-      j = j1;
-    }
-  else if (j1 == 0)
-    {
-      j1 = j;
-      i = i1;
-    }
-  else if (i1 == i || j1 == j)
-    {
-      i1 = i;
-      j1 = j;
-    }
-
-  /* If the area of this L-piece is less than the area of the box,
-   * this L-piece is discarded. */
-  if (i * j - (i - i1) * (j - j1) < l * w)
-    {
-      q[0] = -1;
-      return;
-    }
-
-  if (i == i1 && j == j1 && i < j)
-    {
-      std::swap (i, j);
-      std::swap (i1, j1);
-    }
-
-  if (0 < i1 && i1 < i && 0 < j1 && j1 < j && i < j)
-    {
-      std::swap (i, j);
-      std::swap (i1, j1);
-    }
-  else if (0 < i1 && i1 < i && 0 < j1 && j1 < j && i == j && i1 < j1)
-    {
-      std::swap (i1, j1);
-    }
-
-  q[0] = i;
-  q[1] = j;
-  q[2] = i1;
-  q[3] = j1;
+  normalizePiece (q, l * w);
 }
 
 /******************************************************************
@@ -172,17 +123,7 @@ normalizePiece (int *q)
 void
 standardPositionB1 (int *i, int *q, int *q1, int *q2)
 {
-  /* L1 */
-  q1[0] = q[2];
-  q1[1] = normalize[q[1] - i[1]];
-  q1[2] = i[0];
-  q1[3] = normalize[q[1] - q[3]];
-
-  /* L2 */
-  q2[0] = q[0];
-  q2[1] = q[3];
-  q2[2] = normalize[q[0] - i[0]];
-  q2[3] = i[1];
+  standardPosition<B1> (i, q, q1, q2, normalize);
 }
 
 /******************************************************************
@@ -216,17 +157,7 @@ standardPositionB1 (int *i, int *q, int *q1, int *q2)
 void
 standardPositionB2 (int *i, int *q, int *q1, int *q2)
 {
-  /* L1 */
-  q1[0] = q[2];
-  q1[1] = normalize[q[1] - q[3]];
-  q1[2] = normalize[q[2] - i[0]];
-  q1[3] = normalize[q[1] - i[1]];
-
-  /* L2 */
-  q2[0] = q[0];
-  q2[1] = i[1];
-  q2[2] = i[0];
-  q2[3] = q[3];
+  standardPosition<B2> (i, q, q1, q2, normalize);
 }
 
 /******************************************************************
@@ -260,17 +191,7 @@ standardPositionB2 (int *i, int *q, int *q1, int *q2)
 void
 standardPositionB3 (int *i, int *q, int *q1, int *q2)
 {
-  /* L1 */
-  q1[0] = q[0];
-  q1[1] = q[1];
-  q1[2] = i[0];
-  q1[3] = i[1];
-
-  /* L2 */
-  q2[0] = normalize[q[0] - i[0]];
-  q2[1] = normalize[q[1] - i[1]];
-  q2[2] = normalize[q[2] - i[0]];
-  q2[3] = normalize[q[3] - i[1]];
+  standardPosition<B3> (i, q, q1, q2, normalize);
 }
 
 /******************************************************************
@@ -304,17 +225,7 @@ standardPositionB3 (int *i, int *q, int *q1, int *q2)
 void
 standardPositionB4 (int *i, int *q, int *q1, int *q2)
 {
-  /* L1 */
-  q1[0] = i[0];
-  q1[1] = q[1];
-  q1[2] = q[2];
-  q1[3] = i[1];
-
-  /* L2 */
-  q2[0] = normalize[q[0] - q[2]];
-  q2[1] = q[3];
-  q2[2] = normalize[q[0] - i[0]];
-  q2[3] = normalize[q[3] - i[1]];
+  standardPosition<B4> (i, q, q1, q2, normalize);
 }
 
 /******************************************************************
@@ -348,17 +259,7 @@ standardPositionB4 (int *i, int *q, int *q1, int *q2)
 void
 standardPositionB5 (int *i, int *q, int *q1, int *q2)
 {
-  /* L1 */
-  q1[0] = q[2];
-  q1[1] = q[1];
-  q1[2] = i[0];
-  q1[3] = normalize[q[1] - i[1]];
-
-  /* L2 */
-  q2[0] = normalize[q[0] - i[0]];
-  q2[1] = q[3];
-  q2[2] = normalize[q[0] - q[2]];
-  q2[3] = i[1];
+  standardPosition<B5> (i, q, q1, q2, normalize);
 }
 
 /******************************************************************
@@ -390,17 +291,7 @@ standardPositionB5 (int *i, int *q, int *q1, int *q2)
 void
 standardPositionB6 (int *i, int *q, int *q1, int *q2)
 {
-  /* L1 */
-  q1[0] = i[2];
-  q1[1] = q[1];
-  q1[2] = i[0];
-  q1[3] = normalize[q[1] - i[1]];
-
-  /* L2 */
-  q2[0] = normalize[q[0] - i[0]];
-  q2[1] = q[1];
-  q2[2] = normalize[q[0] - i[2]];
-  q2[3] = i[1];
+  standardPosition<B6> (i, q, q1, q2, normalize);
 }
 
 /******************************************************************
@@ -436,17 +327,7 @@ standardPositionB6 (int *i, int *q, int *q1, int *q2)
 void
 standardPositionB7 (int *i, int *q, int *q1, int *q2)
 {
-  /* L1 */
-  q1[0] = q[0];
-  q1[1] = normalize[q[1] - i[1]];
-  q1[2] = i[0];
-  q1[3] = normalize[q[1] - i[2]];
-
-  /* L2 */
-  q2[0] = q[0];
-  q2[1] = i[2];
-  q2[2] = normalize[q[0] - i[0]];
-  q2[3] = i[1];
+  standardPosition<B7> (i, q, q1, q2, normalize);
 }
 
 /******************************************************************
@@ -480,17 +361,7 @@ standardPositionB7 (int *i, int *q, int *q1, int *q2)
 void
 standardPositionB8 (int *i, int *q, int *q1, int *q2)
 {
-  /* L1 */
-  q1[0] = q[2];
-  q1[1] = q[1];
-  q1[2] = i[0];
-  q1[3] = normalize[q[1] - i[1]];
-
-  /* L2 */
-  q2[0] = normalize[q[0] - i[0]];
-  q2[1] = i[1];
-  q2[2] = normalize[q[2] - i[0]];
-  q2[3] = q[3];
+  standardPosition<B8> (i, q, q1, q2, normalize);
 }
 
 /******************************************************************
@@ -525,17 +396,7 @@ standardPositionB8 (int *i, int *q, int *q1, int *q2)
 void
 standardPositionB9 (int *i, int *q, int *q1, int *q2)
 {
-  /* L1 */
-  q1[0] = i[0];
-  q1[1] = normalize[q[1] - i[1]];
-  q1[2] = q[2];
-  q1[3] = normalize[q[3] - i[1]];
-
-  /* L2 */
-  q2[0] = q[0];
-  q2[1] = q[3];
-  q2[2] = normalize[q[0] - i[0]];
-  q2[3] = i[1];
+  standardPosition<B9> (i, q, q1, q2, normalize);
 }
 
 /******************************************************************
@@ -557,6 +418,7 @@ getKey (int q0, int q1, int q2, int q3, int type)
       return q3;
 
     case MEM_TYPE_2:
+    case MEM_TYPE_HYBRID:
       return ((indexRasterX[q2] * numRasterY) + indexRasterY[q3]);
 
     case MEM_TYPE_1:
@@ -596,6 +458,19 @@ LIndex (int q0, int q1, int q2, int q3, int type)
     case MEM_TYPE_1:
       return indexRasterX[q0];
 
+    case MEM_TYPE_HYBRID:
+      /* As q2 <= q0 and q3 <= q1, the small L-pieces have all their
+       * indices in the dense part. The others are offset by its size. */
+      if (indexRasterX[q0] < numDenseX && indexRasterY[q1] < numDenseY)
+        {
+          return (((indexRasterX[q0] * numDenseY) + indexRasterY[q1])
+                      * numDenseX
+                  + indexRasterX[q2])
+                     * numDenseY
+                 + indexRasterY[q3];
+        }
+      return denseSize + (indexRasterX[q0] * numRasterY) + indexRasterY[q1];
+
     default:
       return 0;
     }
@@ -40,6 +40,9 @@
 #define MEM_TYPE_2 2 /* 2-dimensional array. */
 #define MEM_TYPE_3 3 /* 3-dimensional array. */
 #define MEM_TYPE_4 4 /* 4-dimensional array. */
+#define MEM_TYPE_HYBRID 5 /* 4-dimensional array for the small L-pieces and
+                           * 2-dimensional array of hash maps for the
+                           * others. */
 
 #define HORIZONTAL 0
 #define VERTICAL 1
@@ -47,9 +50,14 @@
 #define HORIZONTAL_CUT 0
 #define VERTICAL_CUT 1
 
+/* Cut of a rectangle by Algorithm 1. If lApproach is set, the
+ * rectangle is packed instead by the solution of the L-approach in the
+ * memory of the L-pieces (see drawLRectangle() in draw_bd.h). If seed
+ * is set, it is packed by the blocks of the seed of the search that
+ * fit into it (see solve_BD()). */
 struct CutPoint
 {
-  int x1, x2, y1, y2, homogeneous;
+  int x1, x2, y1, y2, homogeneous, lApproach, seed;
 };
 
 const unsigned int ptoDiv1 = 2047;
@@ -0,0 +1,211 @@
+/* Copyright (C) 2007-2016 Rafael Durbano Lobato
+ *
+ * This file is part of Recursive Partitioning Algorithm.
+ *
+ * Recursive Partitioning Algorithm is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Recursive Partitioning Algorithm is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Recursive Partitioning Algorithm. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Contact information:
+ *
+ * Rafael Durbano Lobato <lobato@ime.usp.br>
+ * http://www.ime.usp.br/~lobato/
+ */
+
+
+/* Benchmark of the L-approach.
+ *
+ * Solves a set of problems with solve_L() and reports the throughput
+ * of the recursion, in L-pieces solved per second, which does not
+ * depend on how many pieces the bounds let the search skip:
+ *
+ *   bench_l [--repeat N] [--threads N] [--deterministic] [--check] [FILE]
+ *
+ * FILE lists the problems, one "L W l w" per line; without it a small
+ * built-in set is used. The problems are solved on a single thread
+ * unless --threads is given (0 for every processor). The number of
+ * boxes is printed along, so that two builds can also be checked to
+ * agree. --check also draws each solution, untimed, and checks that
+ * its boxes are as many as counted, inside the pallet and apart from
+ * each other. --deterministic solves them in the deterministic mode
+ * (see setDeterministic()).
+ */
+
+/******************************************************************
+ ******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "lapproach.h"
+#include "pool.h"
+
+/* Problems solved when no file is given. */
+static const int builtIn[][4] = {
+  { 43, 26, 7, 3 },
+  { 49, 28, 8, 3 },
+  { 57, 34, 7, 4 },
+  { 63, 44, 8, 5 },
+  { 87, 47, 7, 6 },
+  { 93, 46, 13, 4 },
+  { 100, 64, 17, 5 },
+};
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Check the boxes of a solution of packing (l,w)-boxes into the (L,W)
+ * pallet, given as the triples {x, y, rotated} of solve_L(), x going
+ * along W and y along L.
+ *
+ * Return:
+ * - a description of the first fault found, or NULL if there is none.
+ */
+static const char *
+checkBoxes (int L, int W, int l, int w, int count,
+            const std::vector<float> &positions)
+{
+  int n = positions.size () / 3;
+  if (n != count)
+    {
+      return "wrong number of boxes";
+    }
+
+  std::vector<float> box (4 * n);
+  for (int i = 0; i < n; i++)
+    {
+      bool rotated = positions[3 * i + 2] != 0;
+      float a = (rotated ? l : w) / 2.0f;
+      float b = (rotated ? w : l) / 2.0f;
+      box[4 * i] = positions[3 * i] - a;
+      box[4 * i + 1] = positions[3 * i + 1] - b;
+      box[4 * i + 2] = positions[3 * i] + a;
+      box[4 * i + 3] = positions[3 * i + 1] + b;
+      if (box[4 * i] < -0.01f || box[4 * i + 1] < -0.01f
+          || box[4 * i + 2] > W + 0.01f || box[4 * i + 3] > L + 0.01f)
+        {
+          return "box outside the pallet";
+        }
+    }
+
+  for (int i = 0; i < n; i++)
+    {
+      for (int j = i + 1; j < n; j++)
+        {
+          if (box[4 * i] < box[4 * j + 2] - 0.01f
+              && box[4 * j] < box[4 * i + 2] - 0.01f
+              && box[4 * i + 1] < box[4 * j + 3] - 0.01f
+              && box[4 * j + 1] < box[4 * i + 3] - 0.01f)
+            {
+              return "overlapping boxes";
+            }
+        }
+    }
+  return NULL;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+main (int argc, char **argv)
+{
+  std::vector<std::vector<int> > problems;
+  int repeat = 1;
+  int threads = 1;
+  bool check = false;
+  const char *path = NULL;
+  int faults = 0;
+
+  for (int i = 1; i < argc; i++)
+    {
+      if (strcmp (argv[i], "--repeat") == 0 && i + 1 < argc)
+        repeat = atoi (argv[++i]);
+      else if (strcmp (argv[i], "--threads") == 0 && i + 1 < argc)
+        threads = atoi (argv[++i]);
+      else if (strcmp (argv[i], "--check") == 0)
+        check = true;
+      else if (strcmp (argv[i], "--deterministic") == 0)
+        setDeterministic (true);
+      else
+        path = argv[i];
+    }
+
+  if (path != NULL)
+    {
+      FILE *file = fopen (path, "r");
+      int p[4];
+      if (file == NULL)
+        {
+          perror ("bench_l");
+          return 1;
+        }
+      while (fscanf (file, "%d %d %d %d", &p[0], &p[1], &p[2], &p[3]) == 4)
+        problems.push_back (std::vector<int> (p, p + 4));
+      fclose (file);
+    }
+  else
+    {
+      for (size_t i = 0; i < sizeof (builtIn) / sizeof (builtIn[0]); i++)
+        problems.push_back (std::vector<int> (builtIn[i], builtIn[i] + 4));
+    }
+
+  setNumWorkers (threads);
+
+  long totalPieces = 0;
+  double totalSeconds = 0;
+
+  for (size_t i = 0; i < problems.size (); i++)
+    {
+      const std::vector<int> &p = problems[i];
+      long pieces = 0;
+      int count = 0;
+
+      std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now ();
+      for (int k = 0; k < repeat; k++)
+        count = solve_L (p[0], p[1], p[2], p[3], &pieces);
+      double seconds = std::chrono::duration<double> (
+        std::chrono::steady_clock::now () - start).count ();
+
+      totalPieces += pieces * repeat;
+      totalSeconds += seconds;
+      printf ("%5d %5d %4d %4d  boxes %5d  pieces %10ld  %9.3f ms  "
+              "%12.0f pieces/s\n",
+              p[0], p[1], p[2], p[3], count, pieces,
+              1000 * seconds / repeat, pieces * repeat / seconds);
+
+      if (check)
+        {
+          std::vector<float> positions;
+          const char *fault;
+          count = solve_L (p[0], p[1], p[2], p[3], &pieces, &positions);
+          fault = checkBoxes (p[0], p[1], p[2], p[3], count, positions);
+          if (fault != NULL)
+            {
+              printf ("%5d %5d %4d %4d  %s\n", p[0], p[1], p[2], p[3],
+                      fault);
+              faults++;
+            }
+        }
+    }
+
+  printf ("total  pieces %ld  %.3f s  %.0f pieces/s\n", totalPieces,
+          totalSeconds, totalPieces / totalSeconds);
+  return faults > 0;
+}
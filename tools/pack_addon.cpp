@@ -0,0 +1,370 @@
+/* Copyright (C) 2007-2016 Rafael Durbano Lobato
+ *
+ * This file is part of Recursive Partitioning Algorithm.
+ *
+ * Recursive Partitioning Algorithm is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Recursive Partitioning Algorithm is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Recursive Partitioning Algorithm. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Contact information:
+ *
+ * Rafael Durbano Lobato <lobato@ime.usp.br>
+ * http://www.ime.usp.br/~lobato/
+ */
+
+
+/* Node.js addon.
+ *
+ * Runs the solver natively, on the threads of the libuv pool, for
+ * servers that would otherwise run the WebAssembly build. It exports:
+ *
+ *   solve(L, W, l, w, countOnly) -> { promise, cancel }
+ *   threads(n)                   -> sets the threads of the solver,
+ *                                   throws while packings run
+ *   trim()                       -> releases the tables of the caller
+ *
+ * The promise resolves to { count, positions } as packAsync() of
+ * pack-async.js does, positions being a Float32Array of count triples
+ * { x, y, rotated } (null for counts). js/pack-native.js wraps it in
+ * the same functions as pack-async.js.
+ */
+
+/******************************************************************
+ ******************************************************************/
+
+#include <node_api.h>
+#include <string.h>
+
+#include <atomic>
+#include <vector>
+
+#include "cancel.h"
+#include "pool.h"
+
+extern "C" {
+  const float* pack_buffer(int inL, int inW, int inl, int inw);
+  int pack_count(int inL, int inW, int inl, int inw);
+  void pack_trim();
+}
+
+/* Cancellation token shared by a job and its cancel() function, so
+ * that cancel() may still be called once the job is over. */
+struct Token
+{
+  std::atomic<int> cancelled;
+  std::atomic<int> references;
+};
+
+/* A packing run on the libuv pool. */
+struct Job
+{
+  int L, W, l, w;
+  bool countOnly;
+  Token *token;
+
+  /* Result, filled on the pool: the number of boxes (-1 if some
+   * dimension is invalid) and their positions. */
+  int count;
+  std::vector<float> positions;
+
+  napi_async_work work;
+  napi_deferred deferred;
+};
+
+/* Jobs queued by solve() whose promise is not settled yet. It is only
+ * used on the JavaScript thread. */
+static int jobsInFlight = 0;
+
+/******************************************************************
+ ******************************************************************/
+
+static void
+releaseToken (Token *token)
+{
+  if (token->references.fetch_sub (1) == 1)
+    {
+      delete token;
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Throw a JavaScript error and return NULL.
+ */
+static napi_value
+fail (napi_env env, const char *message)
+{
+  napi_throw_error (env, NULL, message);
+  return NULL;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Read the integer arguments of a function.
+ *
+ * Return:
+ * - false (with a pending exception) if some argument is not a number.
+ */
+static bool
+intArguments (napi_env env, napi_value *args, int n, int *values)
+{
+  for (int i = 0; i < n; i++)
+    {
+      if (napi_get_value_int32 (env, args[i], &values[i]) != napi_ok)
+        {
+          napi_throw_type_error (env, NULL, "Dimensions must be numbers");
+          return false;
+        }
+    }
+  return true;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Pack the job on a thread of the libuv pool. Its tables stay with
+ * the thread for the next jobs.
+ */
+static void
+execute (napi_env env, void *data)
+{
+  Job *job = (Job *)data;
+
+  setCancelToken (&job->token->cancelled);
+  if (job->countOnly)
+    {
+      job->count = pack_count (job->L, job->W, job->l, job->w);
+    }
+  else
+    {
+      const float *buffer = pack_buffer (job->L, job->W, job->l, job->w);
+      job->count = buffer == NULL ? -1 : (int)buffer[0];
+      if (buffer != NULL)
+        {
+          job->positions.assign (buffer + 1, buffer + 1 + 3 * job->count);
+        }
+    }
+  setCancelToken (NULL);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Settle the promise of the job, back on the JavaScript thread.
+ */
+static void
+complete (napi_env env, napi_status status, void *data)
+{
+  Job *job = (Job *)data;
+  napi_value result, value, message, error;
+
+  if (status == napi_cancelled || job->token->cancelled.load () != 0)
+    {
+      napi_create_string_utf8 (env, "Packing aborted", NAPI_AUTO_LENGTH,
+                               &message);
+      napi_create_error (env, NULL, message, &error);
+      napi_create_string_utf8 (env, "AbortError", NAPI_AUTO_LENGTH, &value);
+      napi_set_named_property (env, error, "name", value);
+      napi_reject_deferred (env, job->deferred, error);
+    }
+  else if (job->count < 0)
+    {
+      napi_create_string_utf8 (env, "Invalid dimensions", NAPI_AUTO_LENGTH,
+                               &message);
+      napi_create_error (env, NULL, message, &error);
+      napi_reject_deferred (env, job->deferred, error);
+    }
+  else
+    {
+      napi_create_object (env, &result);
+      napi_create_int32 (env, job->count, &value);
+      napi_set_named_property (env, result, "count", value);
+
+      if (job->countOnly)
+        {
+          napi_get_null (env, &value);
+        }
+      else
+        {
+          napi_value buffer;
+          void *bytes;
+          size_t size = job->positions.size () * sizeof (float);
+
+          napi_create_arraybuffer (env, size, &bytes, &buffer);
+          if (size > 0)
+            {
+              memcpy (bytes, job->positions.data (), size);
+            }
+          napi_create_typedarray (env, napi_float32_array,
+                                  job->positions.size (), buffer, 0, &value);
+        }
+      napi_set_named_property (env, result, "positions", value);
+      napi_resolve_deferred (env, job->deferred, result);
+    }
+
+  napi_delete_async_work (env, job->work);
+  jobsInFlight--;
+  releaseToken (job->token);
+  delete job;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+static napi_value
+cancel (napi_env env, napi_callback_info info)
+{
+  Token *token;
+
+  napi_get_cb_info (env, info, NULL, NULL, NULL, (void **)&token);
+  token->cancelled.store (1);
+  return NULL;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+static void
+finalizeCancel (napi_env env, void *data, void *hint)
+{
+  releaseToken ((Token *)data);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * solve(L, W, l, w, countOnly): queue the packing on the libuv pool
+ * and return { promise, cancel }.
+ */
+static napi_value
+solve (napi_env env, napi_callback_info info)
+{
+  size_t argc = 5;
+  napi_value args[5], handle, promise, cancelFunction, name;
+  int dimensions[4];
+  bool countOnly = false;
+
+  napi_get_cb_info (env, info, &argc, args, NULL, NULL);
+  if (argc < 4)
+    {
+      return fail (env, "solve() takes L, W, l and w");
+    }
+  if (!intArguments (env, args, 4, dimensions))
+    {
+      return NULL;
+    }
+  if (argc > 4)
+    {
+      napi_coerce_to_bool (env, args[4], &args[4]);
+      napi_get_value_bool (env, args[4], &countOnly);
+    }
+
+  Job *job = new Job;
+  job->L = dimensions[0];
+  job->W = dimensions[1];
+  job->l = dimensions[2];
+  job->w = dimensions[3];
+  job->countOnly = countOnly;
+  job->count = -1;
+  job->token = new Token;
+  job->token->cancelled.store (0);
+  job->token->references.store (2);
+
+  napi_create_promise (env, &job->deferred, &promise);
+  napi_create_string_utf8 (env, "pack", NAPI_AUTO_LENGTH, &name);
+  napi_create_async_work (env, NULL, name, execute, complete, job, &job->work);
+
+  napi_create_function (env, "cancel", NAPI_AUTO_LENGTH, cancel, job->token,
+                        &cancelFunction);
+  napi_add_finalizer (env, cancelFunction, job->token, finalizeCancel, NULL,
+                      NULL);
+
+  napi_create_object (env, &handle);
+  napi_set_named_property (env, handle, "promise", promise);
+  napi_set_named_property (env, handle, "cancel", cancelFunction);
+
+  napi_queue_async_work (env, job->work);
+  jobsInFlight++;
+  return handle;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * threads(n): set the number of threads of the solver (every
+ * processor if n <= 0). Packings running on different threads of the
+ * libuv pool at the same time share them. Changing them waits for the
+ * running packings, which would block the JavaScript thread, so it
+ * throws while some job of solve() is not settled.
+ */
+static napi_value
+threads (napi_env env, napi_callback_info info)
+{
+  size_t argc = 1;
+  napi_value arg;
+  int n;
+
+  napi_get_cb_info (env, info, &argc, &arg, NULL, NULL);
+  if (argc < 1 || !intArguments (env, &arg, 1, &n))
+    {
+      return argc < 1 ? fail (env, "threads() takes n") : NULL;
+    }
+  if (jobsInFlight > 0)
+    {
+      return fail (env, "threads() cannot be called while packings run");
+    }
+  setNumWorkers (n);
+  return NULL;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * trim(): give back the tables kept by the threads of the solver. The
+ * tables of the libuv threads are kept until they pack again.
+ */
+static napi_value
+trim (napi_env env, napi_callback_info info)
+{
+  pack_trim ();
+  return NULL;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+static napi_value
+init (napi_env env, napi_value exports)
+{
+  napi_property_descriptor properties[] = {
+    { "solve", NULL, solve, NULL, NULL, NULL, napi_default, NULL },
+    { "threads", NULL, threads, NULL, NULL, NULL, napi_default, NULL },
+    { "trim", NULL, trim, NULL, NULL, NULL, napi_default, NULL },
+  };
+
+  napi_define_properties (env, exports,
+                          sizeof (properties) / sizeof (properties[0]),
+                          properties);
+  return exports;
+}
+
+NAPI_MODULE (packnative, init)
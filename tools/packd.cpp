@@ -0,0 +1,1038 @@
+/* Copyright (C) 2007-2016 Rafael Durbano Lobato
+ *
+ * This file is part of Recursive Partitioning Algorithm.
+ *
+ * Recursive Partitioning Algorithm is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Recursive Partitioning Algorithm is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Recursive Partitioning Algorithm. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Contact information:
+ *
+ * Rafael Durbano Lobato <lobato@ime.usp.br>
+ * http://www.ime.usp.br/~lobato/
+ */
+
+
+/* Solver daemon.
+ *
+ * Keeps the solver loaded between packings so that a local service
+ * does not pay for starting a process, growing the tables and
+ * creating the threads on every request. It reads one JSON request
+ * per line, from the standard input or from the clients of a Unix
+ * socket, and writes one JSON answer per line:
+ *
+ *   {"id": 1, "L": 1200, "W": 1000, "l": 250, "w": 150}
+ *   {"id": 1, "count": 30, "boxes": [{"x": 0, ...}, ...], "cached": false, "ms": 4.1}
+ *
+ * Optional fields of a request are "count_only" (true to skip the
+ * boxes) and "deadline_ms" (time after which the packing is cancelled
+ * and answered with an error). {"id": ..., "op": "stats"} returns the
+ * counters of the daemon. Answers may come out of order; the "id" of
+ * the request, whatever its JSON type, is copied to its answer.
+ *
+ * Requests are served by a fixed number of threads, each one keeping
+ * its own tables warm, and the answers are kept in a LRU cache. A
+ * request missing from the cache starts its search from the cached
+ * packing of a neighbouring problem, if there is one, so its answer
+ * depends on the history of the cache and may differ from the one of
+ * an unseeded pack(), possibly with more boxes. When the queue
+ * of waiting requests is full, new requests are rejected at once with
+ * the error "busy" instead of piling up.
+ */
+
+/******************************************************************
+ ******************************************************************/
+
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "cancel.h"
+#include "pool.h"
+
+extern "C" {
+  const float* pack_buffer(int inL, int inW, int inl, int inw);
+  int pack_count(int inL, int inW, int inl, int inw);
+  int pack_load_table(const char *path);
+  int pack_seed(int inL, int inW, int inl, int inw, const float *positions);
+}
+
+typedef std::chrono::steady_clock Clock;
+
+/* Default number of threads serving requests. */
+#define DEFAULT_WORKERS 2
+
+/* Default maximum number of requests waiting for a thread. */
+#define DEFAULT_QUEUE 64
+
+/* Default number of answers kept in the cache. */
+#define DEFAULT_CACHE 4096
+
+/* Largest difference in each dimension between a problem and the
+ * cached problems whose packings seed its search: the same boxes on a
+ * pallet up to this much smaller, or boxes up to this much larger on
+ * the same pallet. Their packings fit into the problem. */
+#define SEED_RADIUS 8
+
+/* Maximum length of a request line. */
+#define MAX_LINE 4096
+
+/******************************************************************
+ ******************************************************************/
+
+/* Origin of requests: the standard input and output or a client of
+ * the socket. The socket is closed when the last request of the client
+ * is answered. */
+struct Client
+{
+  int in, out;
+  bool owned;
+  std::mutex lock;
+
+  Client (int in, int out, bool owned) : in (in), out (out), owned (owned) {}
+  ~Client () { if (owned) close (in); }
+};
+
+struct Request
+{
+  std::shared_ptr<Client> client;
+
+  /* Raw JSON value of the "id" field, or "null". */
+  std::string id;
+
+  int L, W, l, w;
+  bool countOnly;
+
+  Clock::time_point arrival;
+  bool hasDeadline;
+  Clock::time_point deadline;
+
+  /* Cancellation token of the packing, set by the watchdog. */
+  std::atomic<int> token;
+
+  /* Whether the request is in the deadlines watched. */
+  bool watched;
+  std::multimap<Clock::time_point, Request *>::iterator watch;
+};
+
+/* Answer kept in the cache. The boxes are empty for counts. */
+struct Answer
+{
+  int count;
+  bool hasBoxes;
+  std::string boxes;
+
+  /* The boxes as returned by pack_buffer(), to seed other packings,
+   * and the problem they pack. The problems with the pallet or the
+   * boxes turned share the answer (see cacheKey()), so it may be one
+   * of them. */
+  std::vector<float> positions;
+  int L, W, l, w;
+};
+
+/* Options of the daemon. */
+static int numServers = DEFAULT_WORKERS;
+static size_t maxQueue = DEFAULT_QUEUE;
+static size_t maxCache = DEFAULT_CACHE;
+static int defaultDeadline = 0;
+
+/* Queue of requests waiting for a thread. */
+static std::mutex queueLock;
+static std::condition_variable queueReady, queueIdle;
+static std::deque<Request *> queue;
+static int running = 0;
+static bool closing = false;
+
+/* Deadlines of the packings running, watched by the watchdog. */
+static std::mutex watchLock;
+static std::condition_variable watchChanged;
+static std::multimap<Clock::time_point, Request *> deadlines;
+static bool watchStopping = false;
+
+/* LRU cache of answers: the most recently used key is at the front
+ * of the list. */
+typedef std::list<std::pair<std::string, Answer> > CacheList;
+static std::mutex cacheLock;
+static CacheList cacheList;
+static std::unordered_map<std::string, CacheList::iterator> cacheIndex;
+
+/* Counters reported by the "stats" operation. */
+static std::atomic<long> served (0), hits (0), rejected (0), expired (0);
+static std::atomic<long> seeded (0);
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Write a line to the client. Errors (such as a client that went
+ * away) are ignored.
+ */
+static void
+sendLine (Client *client, std::string line)
+{
+  line += '\n';
+  std::lock_guard<std::mutex> guard (client->lock);
+  const char *p = line.data ();
+  size_t left = line.size ();
+  while (left > 0)
+    {
+      ssize_t k = write (client->out, p, left);
+      if (k < 0 && errno == EINTR)
+        continue;
+      if (k <= 0)
+        return;
+      p += k;
+      left -= k;
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+static void
+sendError (Client *client, const std::string &id, const char *message)
+{
+  sendLine (client, "{\"id\": " + id + ", \"error\": \"" + message + "\"}");
+}
+
+/******************************************************************
+ ******************************************************************/
+
+static double
+elapsed (Clock::time_point since)
+{
+  return std::chrono::duration<double, std::milli> (Clock::now () - since)
+    .count ();
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Parse a JSON object whose values are numbers, strings, true, false
+ * or null into the raw text of each value.
+ *
+ * Return:
+ * - false if the line is not such an object.
+ */
+static bool
+parseObject (const std::string &line, std::map<std::string, std::string> *fields)
+{
+  size_t i = 0, n = line.size ();
+
+#define SKIP_SPACES() while (i < n && isspace ((unsigned char)line[i])) i++
+
+  SKIP_SPACES ();
+  if (i == n || line[i++] != '{')
+    return false;
+  SKIP_SPACES ();
+  if (i < n && line[i] == '}')
+    return true;
+
+  while (i < n)
+    {
+      /* Key. */
+      if (line[i++] != '"')
+        return false;
+      size_t start = i;
+      while (i < n && line[i] != '"')
+        i++;
+      if (i == n)
+        return false;
+      std::string key = line.substr (start, i - start);
+      i++;
+
+      SKIP_SPACES ();
+      if (i == n || line[i++] != ':')
+        return false;
+      SKIP_SPACES ();
+
+      /* Value. */
+      start = i;
+      if (i < n && line[i] == '"')
+        {
+          for (i++; i < n && line[i] != '"'; i++)
+            if (line[i] == '\\')
+              i++;
+          if (i >= n)
+            return false;
+          i++;
+        }
+      else
+        {
+          while (i < n && line[i] != ',' && line[i] != '}'
+                 && !isspace ((unsigned char)line[i]))
+            i++;
+        }
+      if (i == start)
+        return false;
+      (*fields)[key] = line.substr (start, i - start);
+
+      SKIP_SPACES ();
+      if (i < n && line[i] == '}')
+        return true;
+      if (i == n || line[i++] != ',')
+        return false;
+      SKIP_SPACES ();
+    }
+
+#undef SKIP_SPACES
+
+  return false;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Read the integer field key into value.
+ *
+ * Return:
+ * - false if the field is missing or is not an integer.
+ */
+static bool
+intField (std::map<std::string, std::string> &fields, const char *key,
+          int *value)
+{
+  std::map<std::string, std::string>::iterator it = fields.find (key);
+  if (it == fields.end ())
+    return false;
+
+  char *end;
+  errno = 0;
+  long v = strtol (it->second.c_str (), &end, 10);
+  if (errno != 0 || *end != '\0' || v < -2147483647L || v > 2147483647L)
+    return false;
+
+  *value = (int)v;
+  return true;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Return the key of the answer of the request in the cache. The
+ * problem is normalized (L >= W, l >= w), so that it is shared by the
+ * problems with the pallet or the boxes turned.
+ */
+static std::string
+cacheKey (Request *request)
+{
+  return std::to_string (std::max (request->L, request->W)) + " "
+    + std::to_string (std::min (request->L, request->W)) + " "
+    + std::to_string (std::max (request->l, request->w)) + " "
+    + std::to_string (std::min (request->l, request->w));
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Look up the answer of the request in the cache. A cached packing
+ * answers counts as well.
+ *
+ * Return:
+ * - true if the answer was found.
+ */
+static bool
+cacheLookup (Request *request, Answer *answer)
+{
+  std::lock_guard<std::mutex> guard (cacheLock);
+  std::unordered_map<std::string, CacheList::iterator>::iterator it =
+    cacheIndex.find (cacheKey (request));
+
+  if (it == cacheIndex.end ()
+      || (!request->countOnly && !it->second->second.hasBoxes))
+    {
+      return false;
+    }
+
+  cacheList.splice (cacheList.begin (), cacheList, it->second);
+  *answer = it->second->second;
+  return true;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+static void
+cacheStore (Request *request, const Answer &answer)
+{
+  if (maxCache == 0)
+    return;
+
+  std::string key = cacheKey (request);
+  std::lock_guard<std::mutex> guard (cacheLock);
+  std::unordered_map<std::string, CacheList::iterator>::iterator it =
+    cacheIndex.find (key);
+
+  if (it != cacheIndex.end ())
+    {
+      if (!answer.hasBoxes && it->second->second.hasBoxes)
+        return;
+      cacheList.erase (it->second);
+      cacheIndex.erase (it);
+    }
+
+  cacheList.push_front (std::make_pair (key, answer));
+  cacheIndex[key] = cacheList.begin ();
+
+  if (cacheList.size () > maxCache)
+    {
+      cacheIndex.erase (cacheList.back ().first);
+      cacheList.pop_back ();
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Give to the next packing of the calling thread the cached packing
+ * with most boxes among the neighbours of the request (see
+ * SEED_RADIUS), without making them more recently used.
+ *
+ * Return:
+ * - true if some neighbour was found.
+ */
+static bool
+seedFromCache (Request *request)
+{
+  Request neighbour;
+  Answer best;
+  int L = std::max (request->L, request->W);
+  int W = std::min (request->L, request->W);
+  int l = std::max (request->l, request->w);
+  int w = std::min (request->l, request->w);
+
+  best.count = -1;
+  std::lock_guard<std::mutex> guard (cacheLock);
+  for (int k = 0; k < 2; k++)
+    {
+      for (int a = 0; a <= SEED_RADIUS; a++)
+        {
+          for (int b = 0; b <= SEED_RADIUS; b++)
+            {
+              neighbour.L = L - (k == 0 ? a : 0);
+              neighbour.W = W - (k == 0 ? b : 0);
+              neighbour.l = l + (k == 1 ? a : 0);
+              neighbour.w = w + (k == 1 ? b : 0);
+
+              std::unordered_map<std::string, CacheList::iterator>::iterator
+                it = cacheIndex.find (cacheKey (&neighbour));
+              if ((a == 0 && b == 0) || it == cacheIndex.end ()
+                  || !it->second->second.hasBoxes
+                  || it->second->second.count <= best.count)
+                continue;
+
+              best = it->second->second;
+            }
+        }
+    }
+
+  if (best.count <= 0)
+    return false;
+
+  /* pack_seed() places the boxes in the pallet with L >= W, whichever
+   * way the pallet of the seed is turned. */
+  pack_seed (best.L, best.W, best.l, best.w, best.positions.data ());
+  return true;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Write the answer of the request to its client.
+ */
+static void
+sendAnswer (Request *request, const Answer &answer, bool cached)
+{
+  char tail[64];
+
+  snprintf (tail, sizeof (tail), ", \"cached\": %s, \"ms\": %.3f}",
+            cached ? "true" : "false", elapsed (request->arrival));
+
+  std::string line = "{\"id\": " + request->id + ", \"count\": "
+    + std::to_string (answer.count);
+  if (answer.hasBoxes)
+    {
+      line += ", \"boxes\": " + answer.boxes;
+    }
+  sendLine (request->client.get (), line + tail);
+  served++;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Format the boxes returned by pack_buffer() as a JSON array on a
+ * single line.
+ */
+static std::string
+boxesJson (const float *buffer)
+{
+  int n = (int)buffer[0];
+  std::string boxes = "[";
+  char box[96];
+
+  for (int i = 0; i < n; i++)
+    {
+      const float *b = buffer + 1 + 3 * i;
+      snprintf (box, sizeof (box), "%s{\"x\": %g, \"y\": %g, \"rotated\": %s}",
+                i > 0 ? ", " : "", b[0], b[1], b[2] != 0 ? "true" : "false");
+      boxes += box;
+    }
+
+  return boxes + "]";
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Turn the boxes of a cached answer to the request, when the answer
+ * packs the problem with the pallet or the boxes turned.
+ */
+static void
+orientAnswer (Request *request, Answer *answer)
+{
+  bool transposed = answer->L != request->L;
+  bool turned = answer->l != request->l;
+
+  if (!answer->hasBoxes || (!transposed && !turned))
+    return;
+
+  /* Transposing the pallet turns every box, and so does naming the
+   * sides of the boxes the other way. Square boxes are never turned. */
+  for (int i = 0; i < answer->count; i++)
+    {
+      float *b = &answer->positions[1 + 3 * i];
+      if (transposed)
+        {
+          std::swap (b[0], b[1]);
+        }
+      if (transposed != turned && request->l != request->w)
+        {
+          b[2] = b[2] != 0 ? 0.0f : 1.0f;
+        }
+    }
+  answer->boxes = boxesJson (answer->positions.data ());
+  answer->L = request->L;
+  answer->W = request->W;
+  answer->l = request->l;
+  answer->w = request->w;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Cancel the packings whose deadline has passed.
+ */
+static void
+watchdog ()
+{
+  std::unique_lock<std::mutex> guard (watchLock);
+
+  while (!watchStopping)
+    {
+      if (deadlines.empty ())
+        {
+          watchChanged.wait (guard);
+          continue;
+        }
+
+      std::multimap<Clock::time_point, Request *>::iterator first =
+        deadlines.begin ();
+      if (Clock::now () >= first->first)
+        {
+          first->second->token.store (1);
+          first->second->watched = false;
+          deadlines.erase (first);
+        }
+      else
+        {
+          watchChanged.wait_until (guard, first->first);
+        }
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Pack the request on the calling thread, within its deadline.
+ */
+static void
+serve (Request *request)
+{
+  Answer answer;
+
+  if (request->hasDeadline && Clock::now () >= request->deadline)
+    {
+      expired++;
+      sendError (request->client.get (), request->id, "deadline exceeded");
+      return;
+    }
+
+  if (request->hasDeadline)
+    {
+      std::lock_guard<std::mutex> guard (watchLock);
+      request->watch = deadlines.insert (std::make_pair (request->deadline,
+                                                         request));
+      request->watched = true;
+      watchChanged.notify_one ();
+    }
+
+  if (seedFromCache (request))
+    {
+      seeded++;
+    }
+
+  setCancelToken (&request->token);
+  if (request->countOnly)
+    {
+      answer.count = pack_count (request->L, request->W,
+                                 request->l, request->w);
+      answer.hasBoxes = false;
+    }
+  else
+    {
+      const float *buffer = pack_buffer (request->L, request->W,
+                                         request->l, request->w);
+      answer.count = buffer == NULL ? -1 : (int)buffer[0];
+      answer.hasBoxes = true;
+      if (buffer != NULL)
+        {
+          answer.boxes = boxesJson (buffer);
+          answer.positions.assign (buffer, buffer + 1 + 3 * answer.count);
+        }
+    }
+  answer.L = request->L;
+  answer.W = request->W;
+  answer.l = request->l;
+  answer.w = request->w;
+  setCancelToken (NULL);
+
+  if (request->hasDeadline)
+    {
+      std::lock_guard<std::mutex> guard (watchLock);
+      if (request->watched)
+        {
+          deadlines.erase (request->watch);
+        }
+    }
+
+  if (request->token.load () != 0)
+    {
+      expired++;
+      sendError (request->client.get (), request->id, "deadline exceeded");
+    }
+  else if (answer.count < 0)
+    {
+      sendError (request->client.get (), request->id, "invalid dimensions");
+    }
+  else
+    {
+      cacheStore (request, answer);
+      sendAnswer (request, answer, false);
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Serve the requests of the queue until the daemon closes.
+ */
+static void
+server ()
+{
+  for (;;)
+    {
+      Request *request;
+      {
+        std::unique_lock<std::mutex> guard (queueLock);
+        while (queue.empty () && !closing)
+          queueReady.wait (guard);
+        if (queue.empty ())
+          return;
+        request = queue.front ();
+        queue.pop_front ();
+        running++;
+      }
+
+      serve (request);
+      delete request;
+
+      std::lock_guard<std::mutex> guard (queueLock);
+      running--;
+      if (queue.empty () && running == 0)
+        queueIdle.notify_all ();
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+static void
+sendStats (Client *client, const std::string &id)
+{
+  size_t waiting, cached;
+  int busy;
+  {
+    std::lock_guard<std::mutex> guard (queueLock);
+    waiting = queue.size ();
+    busy = running;
+  }
+  {
+    std::lock_guard<std::mutex> guard (cacheLock);
+    cached = cacheList.size ();
+  }
+
+  sendLine (client, "{\"id\": " + id
+            + ", \"queued\": " + std::to_string (waiting)
+            + ", \"running\": " + std::to_string (busy)
+            + ", \"served\": " + std::to_string (served.load ())
+            + ", \"cached\": " + std::to_string (cached)
+            + ", \"hits\": " + std::to_string (hits.load ())
+            + ", \"seeded\": " + std::to_string (seeded.load ())
+            + ", \"rejected\": " + std::to_string (rejected.load ())
+            + ", \"expired\": " + std::to_string (expired.load ()) + "}");
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Handle a request line: answer it from the cache, queue it or reject
+ * it.
+ */
+static void
+handleLine (const std::shared_ptr<Client> &client, const std::string &line)
+{
+  std::map<std::string, std::string> fields;
+
+  if (!parseObject (line, &fields))
+    {
+      sendError (client.get (), "null", "invalid request");
+      return;
+    }
+
+  std::string id = fields.count ("id") ? fields["id"] : "null";
+
+  if (fields.count ("op"))
+    {
+      if (fields["op"] == "\"stats\"")
+        sendStats (client.get (), id);
+      else
+        sendError (client.get (), id, "unknown operation");
+      return;
+    }
+
+  Request *request = new Request;
+  request->client = client;
+  request->id = id;
+  request->arrival = Clock::now ();
+  request->countOnly = fields.count ("count_only")
+    && fields["count_only"] == "true";
+  request->token.store (0);
+  request->watched = false;
+
+  int deadline = defaultDeadline;
+  if (!intField (fields, "L", &request->L)
+      || !intField (fields, "W", &request->W)
+      || !intField (fields, "l", &request->l)
+      || !intField (fields, "w", &request->w)
+      || (fields.count ("deadline_ms")
+          && !intField (fields, "deadline_ms", &deadline)))
+    {
+      sendError (client.get (), id, "invalid request");
+      delete request;
+      return;
+    }
+  request->hasDeadline = deadline > 0;
+  request->deadline = request->arrival + std::chrono::milliseconds (deadline);
+
+  Answer answer;
+  if (cacheLookup (request, &answer))
+    {
+      orientAnswer (request, &answer);
+      hits++;
+      sendAnswer (request, answer, true);
+      delete request;
+      return;
+    }
+
+  {
+    std::lock_guard<std::mutex> guard (queueLock);
+    if (queue.size () < maxQueue)
+      {
+        queue.push_back (request);
+        queueReady.notify_one ();
+        return;
+      }
+  }
+
+  rejected++;
+  sendError (client.get (), id, "busy");
+  delete request;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Handle the request lines read from the client until it closes its
+ * side of the connection.
+ */
+static void
+readClient (std::shared_ptr<Client> client)
+{
+  std::string line;
+  char buffer[4096];
+  bool tooLong = false;
+
+  for (;;)
+    {
+      ssize_t k = read (client->in, buffer, sizeof (buffer));
+      if (k < 0 && errno == EINTR)
+        continue;
+      if (k <= 0)
+        break;
+
+      for (ssize_t i = 0; i < k; i++)
+        {
+          if (buffer[i] != '\n')
+            {
+              if (line.size () < MAX_LINE)
+                line += buffer[i];
+              else
+                tooLong = true;
+              continue;
+            }
+
+          if (tooLong)
+            sendError (client.get (), "null", "invalid request");
+          else if (line.find_first_not_of (" \t\r") != std::string::npos)
+            handleLine (client, line);
+          line.clear ();
+          tooLong = false;
+        }
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Open the Unix socket at path, replacing a stale one.
+ *
+ * Return:
+ * - the descriptor of the socket, or -1 if it cannot be opened.
+ */
+static int
+openSocket (const char *path)
+{
+  struct sockaddr_un address;
+
+  if (strlen (path) >= sizeof (address.sun_path))
+    {
+      fprintf (stderr, "packd: socket path too long\n");
+      return -1;
+    }
+
+  int fd = socket (AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    {
+      perror ("packd: socket");
+      return -1;
+    }
+
+  memset (&address, 0, sizeof (address));
+  address.sun_family = AF_UNIX;
+  strcpy (address.sun_path, path);
+  unlink (path);
+
+  if (bind (fd, (struct sockaddr *)&address, sizeof (address)) < 0
+      || listen (fd, 64) < 0)
+    {
+      perror ("packd: bind");
+      close (fd);
+      return -1;
+    }
+
+  return fd;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Accept the clients of the socket, each one read by its own thread.
+ * It returns only if accept() fails.
+ */
+static void
+acceptClients (int fd)
+{
+  for (;;)
+    {
+      int clientFd = accept (fd, NULL, NULL);
+      if (clientFd < 0)
+        {
+          if (errno == EINTR || errno == ECONNABORTED)
+            continue;
+          perror ("packd: accept");
+          close (fd);
+          return;
+        }
+      std::thread (readClient,
+                   std::make_shared<Client> (clientFd, clientFd, true)).detach ();
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+static void
+usage ()
+{
+  fprintf (stderr,
+           "Usage: packd [options]\n"
+           "  --socket PATH      serve the clients of a Unix socket instead\n"
+           "                     of the standard input and output\n"
+           "  --workers N        requests packed at the same time (%d)\n"
+           "  --threads N        threads of the solver, 0 for every\n"
+           "                     processor (0)\n"
+           "  --queue N          requests waiting before new ones are\n"
+           "                     rejected (%d)\n"
+           "  --cache N          answers kept in the cache (%d)\n"
+           "  --deadline MS      deadline of requests without one, 0 for\n"
+           "                     none (0)\n"
+           "  --table FILE       answer the problems of a solution table\n"
+           "                     (see precompute) without solving\n",
+           DEFAULT_WORKERS, DEFAULT_QUEUE, DEFAULT_CACHE);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+main (int argc, char **argv)
+{
+  const char *socketPath = NULL;
+  int threads = 0;
+
+  for (int i = 1; i < argc; i++)
+    {
+      const char *option = argv[i];
+      if (i + 1 == argc)
+        {
+          usage ();
+          return 2;
+        }
+      const char *value = argv[++i];
+
+      if (strcmp (option, "--socket") == 0)
+        socketPath = value;
+      else if (strcmp (option, "--workers") == 0)
+        numServers = atoi (value) > 0 ? atoi (value) : 1;
+      else if (strcmp (option, "--threads") == 0)
+        threads = atoi (value);
+      else if (strcmp (option, "--queue") == 0)
+        maxQueue = atoi (value) > 0 ? atoi (value) : 0;
+      else if (strcmp (option, "--cache") == 0)
+        maxCache = atoi (value) > 0 ? atoi (value) : 0;
+      else if (strcmp (option, "--deadline") == 0)
+        defaultDeadline = atoi (value);
+      else if (strcmp (option, "--table") == 0)
+        {
+          if (!pack_load_table (value))
+            {
+              fprintf (stderr, "packd: invalid solution table %s\n", value);
+              return 1;
+            }
+        }
+      else
+        {
+          usage ();
+          return 2;
+        }
+    }
+
+  signal (SIGPIPE, SIG_IGN);
+
+  int listening = -1;
+  if (socketPath != NULL && (listening = openSocket (socketPath)) < 0)
+    return 1;
+
+  /* The solver writes its messages to the standard output, so answers
+   * go to a copy of it and the messages to the standard error. */
+  int out = socketPath == NULL ? dup (STDOUT_FILENO) : -1;
+  dup2 (STDERR_FILENO, STDOUT_FILENO);
+
+  setNumWorkers (threads);
+
+  std::thread watcher (watchdog);
+  std::vector<std::thread> servers;
+  for (int i = 0; i < numServers; i++)
+    servers.push_back (std::thread (server));
+
+  if (socketPath != NULL)
+    acceptClients (listening);
+  else
+    readClient (std::make_shared<Client> (STDIN_FILENO, out, false));
+
+  /* End of the input: answer the requests queued and leave. */
+  std::unique_lock<std::mutex> guard (queueLock);
+  while (!queue.empty () || running > 0)
+    queueIdle.wait (guard);
+  closing = true;
+  queueReady.notify_all ();
+  guard.unlock ();
+
+  for (size_t i = 0; i < servers.size (); i++)
+    servers[i].join ();
+
+  {
+    std::lock_guard<std::mutex> watchGuard (watchLock);
+    watchStopping = true;
+  }
+  watchChanged.notify_one ();
+  watcher.join ();
+
+  return socketPath != NULL;
+}
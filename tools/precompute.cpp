@@ -0,0 +1,741 @@
+/* Copyright (C) 2007-2016 Rafael Durbano Lobato
+ *
+ * This file is part of Recursive Partitioning Algorithm.
+ *
+ * Recursive Partitioning Algorithm is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Recursive Partitioning Algorithm is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Recursive Partitioning Algorithm. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Contact information:
+ *
+ * Rafael Durbano Lobato <lobato@ime.usp.br>
+ * http://www.ime.usp.br/~lobato/
+ */
+
+
+/* Precompute tool.
+ *
+ * Solves every problem of ranges of pallets and boxes, in parallel, and
+ * writes their solutions to a solution table (see lookup.h), which
+ * pack() answers without solving once loaded by pack_load_table():
+ *
+ *   precompute -L 1200 -W 800:1000 -l 100:400 -w 100:400 -o table.bin
+ *
+ * A range is given as a value, first:last or first:last:step. The
+ * problems may also be listed in a file, one "L W l w" per line, with
+ * --instances. Pallets are canonicalized (L >= W), so (1200,800) and
+ * (800,1200) are solved once.
+ *
+ * Large sweeps are split into shards by the dimensions of the boxes.
+ * --shard i/n solves only the shard i of n, so that the shards can be
+ * solved by different machines, and --merge combines the tables of the
+ * shards (or any tables) into one:
+ *
+ *   precompute ... --shard 0/2 -o part0.bin     (on one machine)
+ *   precompute ... --shard 1/2 -o part1.bin     (on another one)
+ *   precompute --merge -o table.bin part0.bin part1.bin
+ *
+ * On a single machine, --shards n runs the n shards in separate
+ * processes, restarts the ones that fail and merges their tables. The
+ * tables of the shards already written by a previous run of the same
+ * sweep are kept, so running it again after a failure solves only the
+ * missing shards. Each table is recorded with the sweep and the shard
+ * it solves in a file next to it (see shardSweep()); a table of another
+ * sweep is solved again.
+ *
+ * With --checkpoint s, the search of each problem is saved every s
+ * seconds next to the output (see save_BD()), and a run interrupted
+ * in a long problem continues it from its last checkpoint, on this
+ * machine or on another one the checkpoint is copied to.
+ */
+
+/******************************************************************
+ ******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lookup.h"
+#include "pool.h"
+
+/* A range of dimensions: first, first + step, ..., up to last. */
+struct Range
+{
+  int first, last, step;
+};
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Parse a range given as "a", "a:b" or "a:b:s".
+ *
+ * Return:
+ * - false if the text is not a valid range.
+ */
+static bool
+parseRange (const char *text, Range *range)
+{
+  int n = sscanf (text, "%d:%d:%d", &range->first, &range->last,
+                  &range->step);
+  if (n < 1)
+    {
+      return false;
+    }
+  if (n < 2)
+    {
+      range->last = range->first;
+    }
+  if (n < 3)
+    {
+      range->step = 1;
+    }
+  return range->first > 0 && range->last >= range->first && range->step > 0;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/* Shard solved by this process (see --shard): problems whose boxes
+ * fall in the shard shardIndex of numShards. */
+static int shardIndex = 0, numShards = 1;
+
+/**
+ * Return the shard of the problems with (l,w)-boxes. All the pallets
+ * of a box go to the same shard; the boxes are spread over the shards
+ * by a hash, so that ranges of boxes are split evenly.
+ */
+static int
+boxShard (int l, int w, int n)
+{
+  unsigned int h = (unsigned int)l * 2654435761u ^ (unsigned int)w * 40503u;
+  return (int)((h ^ (h >> 15)) % (unsigned int)n);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Add the problem (L,W,l,w) to problems, with L >= W, if it belongs
+ * to the shard of this process.
+ */
+static void
+addProblem (std::vector<Solution> *problems, int L, int W, int l, int w)
+{
+  Solution problem;
+
+  if (L <= 0 || W <= 0 || l <= 0 || w <= 0
+      || boxShard (l, w, numShards) != shardIndex)
+    {
+      return;
+    }
+  problem.L = std::max (L, W);
+  problem.W = std::min (L, W);
+  problem.l = l;
+  problem.w = w;
+  problem.count = -1;
+  problems->push_back (problem);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+static bool
+lessProblem (const Solution &a, const Solution &b)
+{
+  if (a.L != b.L)
+    return a.L < b.L;
+  if (a.W != b.W)
+    return a.W < b.W;
+  if (a.l != b.l)
+    return a.l < b.l;
+  return a.w < b.w;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+static bool
+sameProblem (const Solution &a, const Solution &b)
+{
+  return a.L == b.L && a.W == b.W && a.l == b.l && a.w == b.w;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/* Problems of the sweep and index of the next one to be solved. */
+static std::vector<Solution> problems;
+static std::atomic<size_t> next (0);
+
+/* Seconds between two checkpoints of a problem (see --checkpoint), or
+ * 0 for none, and path of the table written by this process. */
+static int checkpointInterval = 0;
+static const char *output = NULL;
+
+/**
+ * Return the path of the checkpoint of a problem.
+ */
+static std::string
+checkpointPath (const Solution &problem)
+{
+  return std::string (output) + ".checkpoint-" + std::to_string (problem.L)
+    + "-" + std::to_string (problem.W) + "-" + std::to_string (problem.l)
+    + "-" + std::to_string (problem.w);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Solve problems until there are none left. Each thread keeps its own
+ * tables, so that they grow once for the largest problem it solves.
+ */
+static void
+sweep ()
+{
+  std::vector<Block> blocks;
+
+  for (size_t i = next++; i < problems.size (); i = next++)
+    {
+      Solution &problem = problems[i];
+      if (checkpointInterval > 0)
+        {
+          std::string checkpoint = checkpointPath (problem);
+          problem.count = solveBlocks (problem.L, problem.W, problem.l,
+                                       problem.w, &blocks,
+                                       checkpoint.c_str (),
+                                       checkpointInterval);
+        }
+      else
+        {
+          problem.count = solveBlocks (problem.L, problem.W, problem.l,
+                                       problem.w, &blocks);
+        }
+      problem.tree = encodeBlocks (blocks);
+    }
+}
+
+/******************************************************************
+ ******************************************************************/
+
+static void
+usage ()
+{
+  fprintf (stderr,
+           "Usage: precompute -L RANGE -W RANGE -l RANGE -w RANGE -o FILE\n"
+           "       precompute --instances FILE -o FILE\n"
+           "       precompute --merge -o FILE TABLE...\n"
+           "  RANGE is a value, first:last or first:last:step\n"
+           "  --threads N    problems solved at the same time by each\n"
+           "                 process, 0 for every processor (0)\n"
+           "  --shard I/N    solve only the shard I of N\n"
+           "  --shards N     solve the N shards in separate processes\n"
+           "                 and merge their tables\n"
+           "  --processes P  shards solved at the same time (N)\n"
+           "  --retries R    times a failed shard is restarted (2)\n"
+           "  --checkpoint S save the search of each problem every S\n"
+           "                 seconds and continue it if interrupted\n");
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Merge solution tables: the solutions of all of them, sorted, with
+ * the repeated problems kept once.
+ *
+ * Return:
+ * - the exit status of the program.
+ */
+static int
+merge (const char *output, const std::vector<const char *> &inputs)
+{
+  std::vector<Solution> solutions;
+
+  for (size_t i = 0; i < inputs.size (); i++)
+    {
+      SolutionTable *table = openSolutionTable (inputs[i]);
+      if (table == NULL)
+        {
+          fprintf (stderr, "precompute: invalid solution table %s\n",
+                   inputs[i]);
+          return 1;
+        }
+
+      size_t n = tableSize (table);
+      solutions.reserve (solutions.size () + n);
+      for (size_t k = 0; k < n; k++)
+        {
+          Solution solution;
+          if (!tableSolution (table, k, &solution))
+            {
+              fprintf (stderr, "precompute: corrupt solution table %s\n",
+                       inputs[i]);
+              closeSolutionTable (table);
+              return 1;
+            }
+          solutions.push_back (solution);
+        }
+      closeSolutionTable (table);
+    }
+
+  if (!writeSolutionTable (output, solutions))
+    {
+      perror ("precompute");
+      return 1;
+    }
+
+  fprintf (stderr, "precompute: %zu problems merged from %zu tables\n",
+           solutions.size (), inputs.size ());
+  return 0;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Return the path of the table of the shard i of n of output.
+ */
+static std::string
+shardPath (const char *output, int i, int n)
+{
+  return std::string (output) + ".shard-" + std::to_string (i) + "-of-"
+    + std::to_string (n);
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Return the description of the shard i of n of the sweep: its
+ * options, except those that change only how it is solved, and the
+ * shard. It is written to the path of the table of the shard followed
+ * by ".args" once the table is solved.
+ */
+static std::string
+shardSweep (const std::vector<std::string> &args, int i, int n)
+{
+  std::string sweep;
+
+  for (size_t k = 0; k + 1 < args.size (); k += 2)
+    {
+      if (args[k] != "--threads" && args[k] != "--checkpoint")
+        {
+          sweep += args[k] + " " + args[k + 1] + "\n";
+        }
+    }
+  return sweep + "--shard " + std::to_string (i) + "/" + std::to_string (n)
+    + "\n";
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Return whether the file at path holds exactly text.
+ */
+static bool
+fileHolds (const std::string &path, const std::string &text)
+{
+  FILE *file = fopen (path.c_str (), "rb");
+  std::string contents;
+  char buffer[4096];
+  size_t size;
+
+  if (file == NULL)
+    {
+      return false;
+    }
+  while ((size = fread (buffer, 1, sizeof (buffer), file)) > 0)
+    contents.append (buffer, size);
+  fclose (file);
+  return contents == text;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Write text to the file at path.
+ *
+ * Return:
+ * - false if it cannot be written.
+ */
+static bool
+writeFile (const std::string &path, const std::string &text)
+{
+  FILE *file = fopen (path.c_str (), "wb");
+
+  if (file == NULL)
+    {
+      return false;
+    }
+  bool written = fwrite (text.data (), 1, text.size (), file) == text.size ();
+  return fclose (file) == 0 && written;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Start a process solving the shard i of n.
+ *
+ * Parameters:
+ * program - Path of this program.
+ *
+ * args    - Options of the sweep passed to every shard.
+ *
+ * Return:
+ * - the identifier of the process, or -1 if it cannot be started.
+ */
+static pid_t
+startShard (const char *program, const std::vector<std::string> &args,
+            const char *output, int i, int n)
+{
+  std::vector<std::string> shardArgs (args);
+  shardArgs.push_back ("--shard");
+  shardArgs.push_back (std::to_string (i) + "/" + std::to_string (n));
+  shardArgs.push_back ("-o");
+  shardArgs.push_back (shardPath (output, i, n));
+
+  std::vector<char *> argv;
+  argv.push_back ((char *)program);
+  for (size_t k = 0; k < shardArgs.size (); k++)
+    argv.push_back ((char *)shardArgs[k].c_str ());
+  argv.push_back (NULL);
+
+  pid_t pid = fork ();
+  if (pid == 0)
+    {
+      execvp (program, &argv[0]);
+      perror ("precompute: exec");
+      _exit (127);
+    }
+  return pid;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+/**
+ * Solve the n shards of the sweep in separate processes, at most
+ * processes at a time, restarting each failed shard up to retries
+ * times, and merge their tables into output. Shards whose table is
+ * already written for the same sweep are not solved again.
+ *
+ * Return:
+ * - the exit status of the program.
+ */
+static int
+runShards (const char *program, const std::vector<std::string> &args,
+           const char *output, int n, int processes, int retries)
+{
+  std::vector<int> pending, attempts (n, 0);
+  std::map<pid_t, int> running;
+  std::vector<std::string> paths;
+  bool failed = false;
+
+  for (int i = 0; i < n; i++)
+    {
+      paths.push_back (shardPath (output, i, n));
+      SolutionTable *table = NULL;
+      if (fileHolds (paths[i] + ".args", shardSweep (args, i, n)))
+        {
+          table = openSolutionTable (paths[i].c_str ());
+        }
+      if (table != NULL)
+        {
+          fprintf (stderr, "precompute: shard %d/%d already solved\n", i, n);
+          closeSolutionTable (table);
+        }
+      else
+        {
+          unlink ((paths[i] + ".args").c_str ());
+          pending.push_back (i);
+        }
+    }
+
+  while (!pending.empty () || !running.empty ())
+    {
+      while (!pending.empty () && (int)running.size () < processes)
+        {
+          int i = pending.front ();
+          pending.erase (pending.begin ());
+          attempts[i]++;
+          pid_t pid = startShard (program, args, output, i, n);
+          if (pid < 0)
+            {
+              perror ("precompute: fork");
+              return 1;
+            }
+          running[pid] = i;
+        }
+
+      int status;
+      pid_t pid = wait (&status);
+      if (pid < 0)
+        {
+          perror ("precompute: wait");
+          return 1;
+        }
+      if (running.count (pid) == 0)
+        {
+          continue;
+        }
+
+      int i = running[pid];
+      running.erase (pid);
+      if (WIFEXITED (status) && WEXITSTATUS (status) == 0)
+        {
+          if (!writeFile (paths[i] + ".args", shardSweep (args, i, n)))
+            {
+              perror ("precompute");
+            }
+          continue;
+        }
+
+      if (attempts[i] <= retries)
+        {
+          fprintf (stderr, "precompute: shard %d/%d failed, restarting it\n",
+                   i, n);
+          pending.push_back (i);
+        }
+      else
+        {
+          fprintf (stderr, "precompute: shard %d/%d failed\n", i, n);
+          failed = true;
+        }
+    }
+
+  if (failed)
+    {
+      fprintf (stderr, "precompute: run again to solve the failed shards\n");
+      return 1;
+    }
+
+  std::vector<const char *> inputs;
+  for (int i = 0; i < n; i++)
+    inputs.push_back (paths[i].c_str ());
+
+  int status = merge (output, inputs);
+  if (status == 0)
+    {
+      for (int i = 0; i < n; i++)
+        {
+          unlink (paths[i].c_str ());
+          unlink ((paths[i] + ".args").c_str ());
+        }
+    }
+  return status;
+}
+
+/******************************************************************
+ ******************************************************************/
+
+int
+main (int argc, char **argv)
+{
+  Range range[4];
+  bool given[4] = { false, false, false, false };
+  const char *names[4] = { "-L", "-W", "-l", "-w" };
+  const char *instances = NULL;
+  int threads = 0, shards = 0, processes = 0, retries = 2;
+  bool merging = false;
+
+  /* Tables to merge and options passed to the processes of the
+   * shards. */
+  std::vector<const char *> inputs;
+  std::vector<std::string> sweepArgs;
+
+  for (int i = 1; i < argc; i++)
+    {
+      const char *option = argv[i];
+      int k;
+
+      if (strcmp (option, "--merge") == 0)
+        {
+          merging = true;
+          continue;
+        }
+      if (option[0] != '-')
+        {
+          inputs.push_back (option);
+          continue;
+        }
+      if (i + 1 == argc)
+        {
+          usage ();
+          return 2;
+        }
+      const char *value = argv[++i];
+
+      for (k = 0; k < 4 && strcmp (option, names[k]) != 0; k++)
+        ;
+
+      if (k < 4)
+        {
+          if (!parseRange (value, &range[k]))
+            {
+              fprintf (stderr, "precompute: invalid range %s\n", value);
+              return 2;
+            }
+          given[k] = true;
+        }
+      else if (strcmp (option, "-o") == 0)
+        output = value;
+      else if (strcmp (option, "--instances") == 0)
+        instances = value;
+      else if (strcmp (option, "--threads") == 0)
+        threads = atoi (value);
+      else if (strcmp (option, "--checkpoint") == 0)
+        checkpointInterval = std::max (1, atoi (value));
+      else if (strcmp (option, "--shard") == 0)
+        {
+          if (sscanf (value, "%d/%d", &shardIndex, &numShards) != 2
+              || numShards < 1 || shardIndex < 0 || shardIndex >= numShards)
+            {
+              fprintf (stderr, "precompute: invalid shard %s\n", value);
+              return 2;
+            }
+          continue;
+        }
+      else if (strcmp (option, "--shards") == 0)
+        {
+          shards = atoi (value);
+          continue;
+        }
+      else if (strcmp (option, "--processes") == 0)
+        {
+          processes = atoi (value);
+          continue;
+        }
+      else if (strcmp (option, "--retries") == 0)
+        {
+          retries = atoi (value);
+          continue;
+        }
+      else
+        {
+          usage ();
+          return 2;
+        }
+
+      if (strcmp (option, "-o") != 0)
+        {
+          sweepArgs.push_back (option);
+          sweepArgs.push_back (value);
+        }
+    }
+
+  if (output == NULL)
+    {
+      usage ();
+      return 2;
+    }
+  if (merging)
+    {
+      return merge (output, inputs);
+    }
+  if (!inputs.empty ()
+      || (instances == NULL
+          && !(given[0] && given[1] && given[2] && given[3])))
+    {
+      usage ();
+      return 2;
+    }
+
+  if (shards > 0)
+    {
+      if (processes <= 0)
+        {
+          processes = shards;
+        }
+      if (threads <= 0)
+        {
+          int cores = std::max (1, (int)std::thread::hardware_concurrency ());
+          sweepArgs.push_back ("--threads");
+          sweepArgs.push_back (std::to_string (
+            std::max (1, cores / std::min (processes, shards))));
+        }
+      return runShards (argv[0], sweepArgs, output, shards, processes,
+                        std::max (0, retries));
+    }
+
+  if (instances != NULL)
+    {
+      FILE *file = fopen (instances, "r");
+      int L, W, l, w;
+      if (file == NULL)
+        {
+          perror ("precompute");
+          return 1;
+        }
+      while (fscanf (file, "%d %d %d %d", &L, &W, &l, &w) == 4)
+        addProblem (&problems, L, W, l, w);
+      fclose (file);
+    }
+  else
+    {
+      for (int L = range[0].first; L <= range[0].last; L += range[0].step)
+        for (int W = range[1].first; W <= range[1].last; W += range[1].step)
+          for (int l = range[2].first; l <= range[2].last; l += range[2].step)
+            for (int w = range[3].first; w <= range[3].last;
+                 w += range[3].step)
+              addProblem (&problems, L, W, l, w);
+    }
+
+  std::sort (problems.begin (), problems.end (), lessProblem);
+  problems.erase (std::unique (problems.begin (), problems.end (),
+                               sameProblem),
+                  problems.end ());
+
+  /* The problems are solved in parallel, so each one uses a single
+   * thread of the solver. */
+  setNumWorkers (1);
+  if (threads <= 0)
+    {
+      threads = std::max (1, (int)std::thread::hardware_concurrency ());
+    }
+
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now ();
+  std::vector<std::thread> sweepers;
+  for (int i = 0; i < threads; i++)
+    sweepers.push_back (std::thread (sweep));
+  for (size_t i = 0; i < sweepers.size (); i++)
+    sweepers[i].join ();
+  double seconds = std::chrono::duration<double> (
+    std::chrono::steady_clock::now () - start).count ();
+
+  if (!writeSolutionTable (output, problems))
+    {
+      perror ("precompute");
+      return 1;
+    }
+
+  fprintf (stderr, "precompute: %zu problems solved in %.1f s\n",
+           problems.size (), seconds);
+  return 0;
+}